@@ -106,6 +106,21 @@ int main(int argc, char **argv){
         MZ_Vec v11 = MZ_cross_product(v9, v10);
         MZ_print_vector_by_label(fp, "CROSS PRODUCT VECTOR", v11);
         
+        MZ_Vec pair9[2] = { v9, v10 };
+        MZ_Vec pair10[2] = { v10, v9 };
+        MZ_VecBatch batch9 = MZ_vectors_to_batch(pair9, 2);
+        MZ_VecBatch batch10 = MZ_vectors_to_batch(pair10, 2);
+        MZ_VecBatch batch11 = MZ_cross_product_vec_batches(batch9, batch10);
+        MZ_Vec cross11 = MZ_get_vector_from_batch(batch11, 0);
+        MZ_Vec cross11_swapped = MZ_get_vector_from_batch(batch11, 1);
+        MZ_print_vector_by_label(fp, "BATCHED CROSS PRODUCT VECTOR", cross11);
+        MZ_print_vector_by_label(fp, "BATCHED CROSS PRODUCT VECTOR SWAPPED", cross11_swapped);
+
+        MZ_free_vector(&cross11);
+        MZ_free_vector(&cross11_swapped);
+        MZ_free_vec_batch(&batch9);
+        MZ_free_vec_batch(&batch10);
+        MZ_free_vec_batch(&batch11);
         MZ_free_vector(&v9);
         MZ_free_vector(&v10);
         MZ_free_vector(&v11);
@@ -193,6 +208,15 @@ int main(int argc, char **argv){
         MZ_print_vector_by_label(fp, "3TH COL TAKEN FROM [MATRIX 4]", v16);
     fprintf(fp, "}\n");
 
+    fprintf(fp, "\nTEST: PROJECT EVERY ROW OF [MATRIX 4] ON [VECTOR 16] {");
+        MZ_Matrix matProj = MZ_vector_proj_rows_on_b(mat4, v16);
+        MZ_print_matrix_by_label(fp, "PROJECTED ROWS", matProj);
+        MZ_Vec vProj = MZ_scalar_proj_rows_on_b(mat4, v16);
+        MZ_print_vector_by_label(fp, "SCALAR PROJECTIONS", vProj);
+        MZ_free_matrix(&matProj);
+        MZ_free_vector(&vProj);
+    fprintf(fp, "}\n");
+
     fprintf(fp, "\nTEST: OPERATION BETWEEN [MATRIX 5] AND [MATRIX 6] INTO [MATRIX 7] {\n\n");
         MZ_Matrix mat5 = MZ_new_default_matrix(3, 3, 5.0f);
         MZ_print_matrix_by_index(fp, 5, mat5);
@@ -210,6 +234,15 @@ int main(int argc, char **argv){
             mat7 = MZ_multiply_two_matrices(mat5, mat6);
             MZ_print_matrix_by_label(fp, "PROD MATRIX", mat7);
         fprintf(fp, "}\n"); 
+        fprintf(fp, "\nOP: PRODUCT BETWEEN [MATRIX 5] AND [MATRIX 6] BY THE NAIVE KERNEL {");
+            MZ_Matrix matNaive = MZ_multiply_two_matrices_naive(mat5, mat6);
+            fprintf(fp, "   | IS IT EQUAL TO THE BLOCKED PRODUCT?: : {\n   |\t %s;\n   | }\n", MZ_are_two_matrices_equal(mat7, matNaive) ? "TRUE" : "FALSE");
+            MZ_free_matrix(&matNaive);
+        fprintf(fp, "}\n");
+        fprintf(fp, "\nOP: 2 * [MATRIX 5]^T * [MATRIX 6] - [MATRIX 7] INTO [MATRIX 7] {");
+            MZ_gemm(MZ_TRANSPOSE, MZ_NO_TRANSPOSE, 2.0f, mat5, mat6, -1.0f, &mat7);
+            MZ_print_matrix_by_label(fp, "GEMM MATRIX", mat7);
+        fprintf(fp, "}\n");
         fprintf(fp, "\nOP: DIVISION BETWEEN [MATRIX 5] AND [MATRIX 6] INTO [MATRIX 7] {");
             mat7 = MZ_divide_two_matrices(mat5, mat6);
             MZ_print_matrix_by_label(fp, "DIV MATRIX", mat7);;
@@ -227,6 +260,52 @@ int main(int argc, char **argv){
         mat8 = MZ_transposed_matrix(mat8);
         MZ_print_matrix_by_label(fp, "TRANSPOSED MATRIX", mat8);
     fprintf(fp, "}\n");
+
+    fprintf(fp, "\nTEST: TRANSPOSE [MATRIX 8] BACK IN PLACE {");
+        MZ_transposed_matrix_into(&mat8, mat8);
+        MZ_print_matrix_by_label(fp, "TRANSPOSED MATRIX", mat8);
+    fprintf(fp, "}\n");
+
+    fprintf(fp, "\nTEST: TRANSPOSE A 19x13 MATRIX, A PADDED 19x13 MATRIX AND A 17x17 MATRIX IN PLACE {");
+        MZ_Matrix rect8 = MZ_alloc_matrix(19, 13);
+        MZ_Matrix padded8 = MZ_alloc_padded_matrix(19, 13);
+        MZ_Matrix square8 = MZ_alloc_matrix(17, 17);
+        for(unsigned int i = 0; i < 19; i++){
+            for(unsigned int j = 0; j < 13; j++){
+                MZ_VALUE_OF_MAT_AT(rect8, i, j) = (float)(i * 13 + j);
+                MZ_VALUE_OF_MAT_AT(padded8, i, j) = (float)(i * 13 + j);
+            }
+        }
+        for(unsigned int i = 0; i < 17; i++){
+            for(unsigned int j = 0; j < 17; j++){
+                MZ_VALUE_OF_MAT_AT(square8, i, j) = (float)(i * 17 + j);
+            }
+        }
+        MZ_Matrix rectT8 = MZ_transposed_matrix(rect8);
+        MZ_Matrix paddedT8 = MZ_alloc_padded_matrix(13, 19);
+        MZ_transposed_matrix_into(&paddedT8, padded8);
+        MZ_transposed_matrix_into(&square8, square8);
+        bool rectOk8 = true, paddedOk8 = true, squareOk8 = true;
+        for(unsigned int i = 0; i < 13; i++){
+            for(unsigned int j = 0; j < 19; j++){
+                if(MZ_VALUE_OF_MAT_AT(rectT8, i, j) != (float)(j * 13 + i)) rectOk8 = false;
+                if(MZ_VALUE_OF_MAT_AT(paddedT8, i, j) != (float)(j * 13 + i)) paddedOk8 = false;
+            }
+        }
+        for(unsigned int i = 0; i < 17; i++){
+            for(unsigned int j = 0; j < 17; j++){
+                if(MZ_VALUE_OF_MAT_AT(square8, i, j) != (float)(j * 17 + i)) squareOk8 = false;
+            }
+        }
+        fprintf(fp, "   | 19x13 TRANSPOSED: %s\n", rectOk8 ? "true" : "false");
+        fprintf(fp, "   | PADDED 19x13 TRANSPOSED: %s\n", paddedOk8 ? "true" : "false");
+        fprintf(fp, "   | 17x17 TRANSPOSED IN PLACE: %s\n", squareOk8 ? "true" : "false");
+        MZ_free_matrix(&rectT8);
+        MZ_free_matrix(&paddedT8);
+        MZ_free_matrix(&square8);
+        MZ_free_matrix(&padded8);
+        MZ_free_matrix(&rect8);
+    fprintf(fp, "}\n");
     
 
     fprintf(fp, "\nTEST: [MATRIX 9] TO ROW ECHELON FORM {");
@@ -266,6 +345,13 @@ int main(int argc, char **argv){
         #endif
     fprintf(fp, "}\n");
 
+    fprintf(fp, "\nTEST: DETERMINANT OF [MATRIX 13] BY LU AND BY COFACTOR EXPANSION {");
+        MZ_LU lu13 = MZ_lu_decomposition_of_matrix(mat13);
+        MZ_print_value(fp, "THE DETERMINANT OF [MATRIX 15] BY LU IS", "DET", MZ_determinant_of_lu(lu13));
+        MZ_print_value(fp, "THE DETERMINANT OF [MATRIX 15] BY COFACTOR EXPANSION IS", "DET", MZ_determinant_of_matrix_by_cofactor(mat13));
+        MZ_free_lu(&lu13);
+    fprintf(fp, "}\n");
+
     fprintf(fp, "\nTEST: INVERSE OF [MATRIX 14] {");
         MZ_Matrix mat14 = MZ_new_random_int_matrix(3, 3, 2, 5);
         MZ_print_matrix_by_index(fp, 14, mat14);
@@ -274,6 +360,68 @@ int main(int argc, char **argv){
         MZ_print_matrix_by_label(fp, "INVERTED MATRIX", mat14);
     fprintf(fp, "}\n");
 
+    fprintf(fp, "\nTEST: SOLVE [MATRIX 18] * X = [VECTOR 18] FROM A SINGLE FACTORIZATION {");
+        MZ_Matrix mat18 = MZ_new_matrix(3, 3, 2.0f, 1.0f, 1.0f, 1.0f, 3.0f, 2.0f, 1.0f, 0.0f, 0.0f);
+        MZ_print_matrix_by_index(fp, 18, mat18);
+        MZ_Factorization fact18 = MZ_factorize(mat18);
+        MZ_Vec v18 = MZ_new_vector(4.0f, 5.0f, 6.0f);
+        MZ_Vec x18 = MZ_solve_vec(fact18, v18);
+        MZ_print_vector_by_label(fp, "SOLUTION VECTOR", x18);
+        MZ_Vec check18 = MZ_multiply_matrix_by_vector(mat18, x18);
+        MZ_print_vector_by_label(fp, "RECOMPUTED RIGHT HAND SIDE", check18);
+        MZ_free_vector(&check18);
+        MZ_Matrix rhs18 = MZ_new_identity_matrix(3);
+        MZ_Matrix sol18 = MZ_solve_mat(fact18, rhs18);
+        MZ_print_matrix_by_label(fp, "SOLUTION MATRIX FOR THE IDENTITY", sol18);
+        MZ_Matrix gram18 = MZ_alloc_matrix(3, 3);
+        MZ_gemm(MZ_TRANSPOSE, MZ_NO_TRANSPOSE, 1.0f, mat18, mat18, 0.0f, &gram18);
+        MZ_print_matrix_by_label(fp, "GRAM MATRIX", gram18);
+        MZ_Matrix sym18 = MZ_alloc_matrix(3, 3);
+        MZ_geam(MZ_NO_TRANSPOSE, 0.5f, mat18, MZ_TRANSPOSE, 0.5f, mat18, &sym18);
+        MZ_print_matrix_by_label(fp, "SYMMETRIC PART", sym18);
+        MZ_product_element_wise_transposed_into(MZ_NO_TRANSPOSE, mat18, MZ_TRANSPOSE, mat18, &sym18);
+        MZ_print_matrix_by_label(fp, "PRODUCT ELEMENT BY ELEMENT WITH THE TRANSPOSE", sym18);
+        MZ_free_matrix(&sym18);
+        MZ_Vec normal18 = MZ_alloc_vector(3);
+        MZ_gemv(MZ_TRANSPOSE, 1.0f, mat18, v18, 0.0f, &normal18);
+        MZ_print_vector_by_label(fp, "NORMAL EQUATIONS RIGHT HAND SIDE", normal18);
+        MZ_Factorization chol18 = MZ_factorize_spd(gram18);
+        MZ_Vec normalSol18 = MZ_solve_vec(chol18, normal18);
+        MZ_print_vector_by_label(fp, "SOLUTION OF THE NORMAL EQUATIONS BY CHOLESKY", normalSol18);
+        MZ_free_vector(&normalSol18);
+        MZ_free_factorization(&chol18);
+        MZ_free_matrix(&gram18);
+        MZ_free_vector(&normal18);
+        MZ_free_factorization(&fact18);
+        MZ_free_vector(&v18);
+        MZ_free_vector(&x18);
+        MZ_free_matrix(&mat18);
+        MZ_free_matrix(&rhs18);
+        MZ_free_matrix(&sol18);
+    fprintf(fp, "}\n");
+
+    fprintf(fp, "\nTEST: FIT A LINE THROUGH 4 POINTS BY LEAST SQUARES WITH THE QR OF [MATRIX 22] {");
+        MZ_Matrix mat22 = MZ_new_matrix(4, 2, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 2.0f, 1.0f, 3.0f);
+        MZ_print_matrix_by_index(fp, 22, mat22);
+        MZ_Vec v22 = MZ_new_vector(1.1f, 2.9f, 5.2f, 6.8f);
+        MZ_Vec fit22 = MZ_least_squares(mat22, v22);
+        MZ_print_vector_by_label(fp, "INTERCEPT AND SLOPE", fit22);
+        MZ_QR qr22 = MZ_qr(mat22);
+        MZ_Matrix r22 = MZ_r_of_qr(qr22);
+        MZ_print_matrix_by_label(fp, "R FACTOR", r22);
+        MZ_free_matrix(&r22);
+        MZ_free_qr(&qr22);
+        MZ_Matrix dependent22 = MZ_new_matrix(4, 2, 1.0f, 2.0f, 2.0f, 4.0f, 3.0f, 6.0f, 4.0f, 8.0f);
+        MZ_Vec rhs22 = MZ_new_vector(1.0f, 2.0f, 3.0f, 5.0f);
+        MZ_Vec none22 = MZ_least_squares(dependent22, rhs22);
+        fprintf(fp, "   | DEPENDENT COLS GIVE A NULL VECTOR: %s\n", none22.elements == NULL ? "true" : "false");
+        MZ_free_vector(&rhs22);
+        MZ_free_matrix(&dependent22);
+        MZ_free_vector(&fit22);
+        MZ_free_vector(&v22);
+        MZ_free_matrix(&mat22);
+    fprintf(fp, "}\n");
+
     fprintf(fp, "\nTEST: CHECK IF [MATRIX 15] AND [MATRIX 16] ARE ORTHOGONAL {");
         MZ_Matrix mat15 = MZ_new_matrix(2, 2, 0.96f, -0.28f, 0.28f, 0.96f);
         MZ_Matrix mat16 = MZ_new_matrix(2, 2, 0.96f, 0.28f, -0.28f, 0.96f);
@@ -289,6 +437,100 @@ int main(int argc, char **argv){
         fprintf(fp, "   | IS [MATRIX 17] ORTHONORMAL?: : {\n   |\t %s;\n   | }\n", MZ_is_matrix_orthonormal(mat17) ? "TRUE" : "FALSE");
     fprintf(fp, "}\n");
 
+    fprintf(fp, "\nTEST: INVERSE OF [MATRIX 13] AS A FIXED SIZE MATRIX {");
+        MZ_Mat3 mat3x3 = MZ_Matrix_to_mat3(mat13);
+        MZ_Mat3 inv3x3;
+        fprintf(fp, "   | DETERMINANT OF [MATRIX 13]: : {\n   |\t %f;\n   | }\n", MZ_determinant_of_mat3(mat3x3));
+        if(MZ_inverse_of_mat3(mat3x3, &inv3x3)){
+            MZ_Matrix inv_mat13 = MZ_Mat3_to_matrix(inv3x3);
+            MZ_print_matrix_by_label(fp, "INV MAT", inv_mat13);
+            MZ_free_matrix(&inv_mat13);
+        }
+    fprintf(fp, "}\n");
+
+    fprintf(fp, "\nTEST: TRANSLATE AND SCALE 2 POINTS BY [MATRIX 19] {");
+        MZ_Matrix mat19 = MZ_new_matrix(3, 4, 2.0f, 0.0f, 0.0f, 1.0f,
+                                              0.0f, 2.0f, 0.0f, 2.0f,
+                                              0.0f, 0.0f, 2.0f, 3.0f);
+        MZ_print_matrix_by_index(fp, 19, mat19);
+        float points19[6] = { 1.0f, 1.0f, 1.0f, -1.0f, 0.0f, 2.0f };
+        MZ_transform_points(mat19, points19, 2);
+        fprintf(fp, "   | TRANSFORMED POINTS: : {\n   |\t (%f, %f, %f) (%f, %f, %f);\n   | }\n",
+                points19[0], points19[1], points19[2], points19[3], points19[4], points19[5]);
+        MZ_free_matrix(&mat19);
+    fprintf(fp, "}\n");
+
+    fprintf(fp, "\nTEST: VIEW THE TOP LEFT 2x2 BLOCK AND THE 3RD COL OF [MATRIX 20] WITHOUT COPYING THEM {");
+        MZ_Matrix mat20 = MZ_new_random_int_matrix(3, 3, -5, 5);
+        MZ_print_matrix_by_index(fp, 20, mat20);
+        MZ_Matrix block20 = MZ_view_of_matrix_block(mat20, 0, 0, 2, 2);
+        MZ_print_matrix_by_label(fp, "TOP LEFT BLOCK", block20);
+        fprintf(fp, "   | DETERMINANT OF THE BLOCK: %f\n", MZ_determinant_of_matrix(block20));
+        MZ_print_matrix_by_label(fp, "3RD COL", MZ_view_of_matrix_col(mat20, 3));
+        MZ_Matrix left20 = MZ_view_of_matrix_block(mat20, 0, 0, 3, 2);
+        MZ_copy_matrix_into(&left20, MZ_view_of_matrix_block(mat20, 0, 1, 3, 2));
+        MZ_print_matrix_by_label(fp, "COLS SHIFTED LEFT THROUGH OVERLAPPING VIEWS", mat20);
+        MZ_free_matrix(&mat20);
+    fprintf(fp, "}\n");
+
+    fprintf(fp, "\nTEST: COPY AND TRANSPOSE THE 1ST ROW OF A 4x4 MATRIX AS A 2x2 MATRIX INTO ITS TOP LEFT BLOCK {");
+        MZ_Matrix square20 = MZ_new_matrix(4, 4, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f,
+                                           9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f);
+        MZ_print_matrix_by_label(fp, "4x4 MATRIX", square20);
+        // both views start at the first element, with a stride of 4 and of 2
+        MZ_Matrix squareBlock20 = MZ_view_of_matrix_block(square20, 0, 0, 2, 2);
+        MZ_Matrix squareRow20 = MZ_view_of_vector_as_matrix(MZ_view_of_matrix_row(square20, 1), 2, 2);
+        MZ_copy_matrix_into(&squareBlock20, squareRow20);
+        MZ_print_matrix_by_label(fp, "COPIED BLOCK", squareBlock20);
+        MZ_free_matrix(&square20);
+        square20 = MZ_new_matrix(4, 4, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f,
+                                 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f);
+        squareBlock20 = MZ_view_of_matrix_block(square20, 0, 0, 2, 2);
+        squareRow20 = MZ_view_of_vector_as_matrix(MZ_view_of_matrix_row(square20, 1), 2, 2);
+        MZ_transposed_matrix_into(&squareBlock20, squareRow20);
+        MZ_print_matrix_by_label(fp, "TRANSPOSED BLOCK", squareBlock20);
+        MZ_free_matrix(&square20);
+    fprintf(fp, "}\n");
+
+    fprintf(fp, "\nTEST: WRAP A BUFFER AS [MATRIX 21] AND SCALE IT WITHOUT COPYING IT {");
+        float buffer21[6] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f };
+        MZ_Matrix mat21 = MZ_wrap_matrix(buffer21, 2, 3, 0);
+        MZ_multiply_matrix_by_scalar_into(&mat21, mat21, 2.0f);
+        MZ_print_matrix_by_index(fp, 21, mat21);
+        fprintf(fp, "   | LAST ELEMENT OF THE BUFFER: %f\n", buffer21[5]);
+        MZ_free_matrix(&mat21); // the buffer stays with its owner
+    fprintf(fp, "}\n");
+
+    fprintf(fp, "\nTEST: RANK OF [MATRIX 23] {");
+        MZ_Matrix mat23 = MZ_new_matrix(3, 3, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f);
+        MZ_print_matrix_by_index(fp, 23, mat23);
+        fprintf(fp, "   | RANK: %u\n", MZ_rank(mat23));
+        MZ_free_matrix(&mat23);
+    fprintf(fp, "}\n");
+
+    fprintf(fp, "\nTEST: ROW ECHELON AND REDUCED ROW ECHELON FORMS OF [MATRIX 24] {");
+        MZ_Matrix mat24 = MZ_new_matrix(3, 4, 1.0f, 2.0f, 3.0f, 4.0f, 2.0f, 4.0f, 7.0f, 9.0f, 3.0f, 6.0f, 10.0f, 14.0f);
+        MZ_print_matrix_by_index(fp, 24, mat24);
+        MZ_Matrix ref24 = MZ_alloc_matrix(3, 4);
+        MZ_copy_matrix_into(&ref24, mat24);
+        MZ_to_echelon_form(&ref24);
+        MZ_print_matrix_by_label(fp, "ROW ECHELON FORM", ref24);
+        MZ_to_reduced_echelon_form(&mat24);
+        MZ_print_matrix_by_label(fp, "REDUCED ROW ECHELON FORM", mat24);
+        MZ_free_matrix(&ref24);
+        MZ_free_matrix(&mat24);
+    fprintf(fp, "}\n");
+
+    fprintf(fp, "\nTEST: ELIMINATE THE 1TH COL OF [MATRIX 25] BELOW ITS 1TH ROW {");
+        MZ_Matrix mat25 = MZ_new_matrix(3, 3, 2.0f, 1.0f, -1.0f, 1.0f, 3.0f, 2.0f, 3.0f, -1.0f, 4.0f);
+        MZ_print_matrix_by_index(fp, 25, mat25);
+        float scalars25[2] = { -0.5f, -1.5f };
+        MZ_multiply_add_matrix_row_to_rows(&mat25, 0, 1, 2, scalars25);
+        MZ_multiply_two_matrix_rows(&mat25, 0, 0.5f);
+        MZ_print_matrix_by_label(fp, "ELIMINATED MATRIX", mat25);
+        MZ_free_matrix(&mat25);
+    fprintf(fp, "}\n");
+
     fclose(fp);
     
     
@@ -62,14 +62,16 @@ SOFTWARE.
 #define VISUALIZE_RATIONAL 0
 
 /*!
+    @brief Minimum number of elements an operation has to touch before its work is split across the thread pool.
 */
-#define CURR_ALLOCATOR calloc
+#define MZ_PARALLEL_THRESHOLD 65536
 
 #define MZ_EQUAL_ERROR      "Dimension mismatch."
 #define MZ_ALLOC_ERROR      "Allocation failure."
 #define MZ_PROD_ERROR       "Matrix 1 columns not equal to Matrix 2 rows."
 #define MZ_DIRECTION_ERROR  "Invalid direction."
 #define MZ_SQUARE_ERROR     "Matrix is not square."
+#define MZ_ALIAS_ERROR      "Destination must not be one of the operands."
 #define MZ_NULL_VECTOR       "(null vector)"
 #define MZ_NULL_MATRIX       "(null matrix)"
 
@@ -98,12 +100,21 @@ SOFTWARE.
 }while(0))
 
 /*!
-    @brief Alloc macro.
+    @brief Alloc macro, the chunk is zero initialized and comes from the current allocator.
     @param count The size of the chunk to allocate.
     @param type The type of the chunk.
 */
 #define MZ_ALLOC(count, type) \
-    (type*)CURR_ALLOCATOR((count) , sizeof(type))\
+    (type*)_MZ_alloc((size_t)(count) * sizeof(type))\
+
+/*!
+    @brief Free macro, gives a chunk allocated with MZ_ALLOC back to the current allocator.
+    @param ptr The chunk to free.
+    @param count The size of the chunk.
+    @param type The type of the chunk.
+*/
+#define MZ_FREE(ptr, count, type) \
+    _MZ_free((ptr), (size_t)(count) * sizeof(type))\
 
 /*!
     @brief Swap two values.
@@ -182,6 +193,202 @@ bool MZ_is_in_array(unsigned int *arr, int n, float target);
 */
 #define MZ_assert(condition, message) _MZ_assert(condition, message, __FILE__, __LINE__)
 
+/*!
+    @brief Sets the number of threads used by the heavy kernels, the calling thread included.
+    @param num_threads The number of threads, 0 to go back to the ZMATH_NUM_THREADS environment variable or the number of cores.
+*/
+void MZ_set_num_threads(unsigned int num_threads);
+
+/*!
+    @brief Gives the number of threads used by the heavy kernels, the calling thread included.
+    @return The number of threads.
+*/
+unsigned int MZ_get_num_threads(void);
+
+/*!
+    @brief The instruction sets the vector kernels can run on, from the slowest to the fastest.
+*/
+typedef enum MZ_Isa{
+    MZ_ISA_AUTO = 0,
+    MZ_ISA_SCALAR,
+    MZ_ISA_SSE2,
+    MZ_ISA_AVX2,
+    MZ_ISA_AVX512,
+    MZ_ISA_COUNT,
+}MZ_Isa;
+
+/*!
+    @brief Forces the vector kernels to run on an instruction set, by default the best one found at startup or the one named by the ZMATH_ISA environment variable (scalar, sse2, avx2, avx512).
+    @attention Call it while no other thread is using zMath.
+    @param isa The instruction set, MZ_ISA_AUTO to go back to the one found at startup.
+    @return false if the processor does not support the instruction set, the current one is then kept.
+*/
+bool MZ_force_isa(MZ_Isa isa);
+
+/*!
+    @brief Gives the instruction set the vector kernels are running on.
+    @return The instruction set.
+*/
+MZ_Isa MZ_get_isa(void);
+
+/*!
+    @brief How the reductions (dot product, magnitude) add up their terms.
+    @param MZ_SUMMATION_PAIRWISE Several accumulators per block of the vector, the blocks are then added pairwise.
+    @param MZ_SUMMATION_COMPENSATED Same as pairwise with every accumulator carrying the error of its sums and products, slower but accurate to the last bits.
+*/
+typedef enum MZ_Summation{
+    MZ_SUMMATION_PAIRWISE = 0,
+    MZ_SUMMATION_COMPENSATED,
+    MZ_SUMMATION_COUNT,
+}MZ_Summation;
+
+/*!
+    @brief Sets how the reductions add up their terms, in either mode the result does not depend on the number of threads.
+    @attention Call it while no other thread is using zMath.
+    @param summation The summation mode, MZ_SUMMATION_PAIRWISE by default.
+*/
+void MZ_set_summation(MZ_Summation summation);
+
+/*!
+    @brief Gives how the reductions add up their terms.
+    @return The summation mode.
+*/
+MZ_Summation MZ_get_summation(void);
+
+/*!
+    @brief Struct that holds the functions through which zMath gets and gives back its memory.
+    @param alloc Returns a chunk of size bytes, or NULL on failure.
+    @param realloc Resizes a chunk of old_size bytes to new_size bytes, or returns NULL on failure.
+    @param free Gives back a chunk of size bytes, ptr may be NULL.
+    @param user The context passed as first argument to every function.
+*/
+typedef struct MZ_Allocator{
+    void* (*alloc)(void* user, size_t size);
+    void* (*realloc)(void* user, void* ptr, size_t old_size, size_t new_size);
+    void  (*free)(void* user, void* ptr, size_t size);
+    void* user;
+}MZ_Allocator;
+
+/*!
+    @brief Gives the allocator built on top of the C runtime (calloc, realloc, free).
+    @return The default allocator.
+*/
+MZ_Allocator MZ_default_allocator(void);
+
+/*!
+    @brief Installs the allocator used by every thread that has not installed its own.
+    @attention Call it while no other thread is using zMath, and free every vector and matrix with the allocator that was current when it was created.
+    @param allocator The allocator to copy, NULL to go back to the default allocator.
+*/
+void MZ_set_allocator(const MZ_Allocator* allocator);
+
+/*!
+    @brief Installs the allocator used by the calling thread only, it takes precedence over the global one.
+    @param allocator The allocator to copy, NULL to go back to the global allocator.
+*/
+void MZ_set_thread_allocator(const MZ_Allocator* allocator);
+
+/*!
+    @brief Gives the allocator currently used by the calling thread.
+    @return The thread allocator if one is installed, the global allocator otherwise.
+*/
+MZ_Allocator MZ_get_allocator(void);
+
+/*!
+    @brief Struct that holds a bump pointer arena, its memory is a chain of blocks taken from a backing allocator.
+    @param first The first block of the chain.
+    @param current The block allocations are bumped from.
+    @param block_size The minimum size in bytes of a new block.
+    @param backing The allocator the blocks come from.
+*/
+typedef struct MZ_Arena{
+    struct _MZ_ArenaBlock* first;
+    struct _MZ_ArenaBlock* current;
+    size_t block_size;
+    MZ_Allocator backing;
+}MZ_Arena;
+
+/*!
+    @brief Struct that holds a position in an arena, everything allocated after it is released when the arena is popped back to it.
+    @param block The block the arena was bumping from.
+    @param used The bytes used in that block.
+*/
+typedef struct MZ_ArenaMarker{
+    struct _MZ_ArenaBlock* block;
+    size_t used;
+}MZ_ArenaMarker;
+
+/*!
+    @brief Create an arena whose blocks come from the current allocator, no memory is taken until the first allocation.
+    @param block_size The minimum size in bytes of each block, 0 for the default.
+    @return The new arena.
+*/
+MZ_Arena MZ_new_arena(size_t block_size);
+
+/*!
+    @brief Gives every block of the arena back to its backing allocator.
+    @param arena The arena to free.
+*/
+void MZ_free_arena(MZ_Arena* arena);
+
+/*!
+    @brief Allocates size bytes from the arena, aligned to 64 bytes and not initialized.
+    @param arena The arena.
+    @param size The number of bytes.
+    @return The chunk, or NULL on failure.
+*/
+void* MZ_arena_alloc(MZ_Arena* arena, size_t size);
+
+/*!
+    @brief Marks the current position of the arena.
+    @param arena The arena.
+    @return The marker to pass to MZ_arena_pop.
+*/
+MZ_ArenaMarker MZ_arena_push(MZ_Arena* arena);
+
+/*!
+    @brief Releases in O(1) everything allocated from the arena after the marker, the blocks are kept for reuse.
+    @param arena The arena.
+    @param marker A marker returned by MZ_arena_push on the same arena, markers must be popped in reverse order.
+*/
+void MZ_arena_pop(MZ_Arena* arena, MZ_ArenaMarker marker);
+
+/*!
+    @brief Gives an allocator that takes its memory from the arena, free only gives back the last allocation.
+    @attention Install it with MZ_set_thread_allocator to make every vector and matrix of a scope live in the arena.
+    @param arena The arena, it must outlive the allocator.
+    @return The allocator.
+*/
+MZ_Allocator MZ_arena_allocator(MZ_Arena* arena);
+
+/*!
+    @brief Frees the scratch arena used by the calling thread for the temporaries of the library.
+*/
+void MZ_free_thread_scratch(void);
+
+/*!
+    @brief Allocates size zero initialized bytes from the current allocator.
+    @param size The number of bytes.
+    @return The chunk, or NULL on failure.
+*/
+void* _MZ_alloc(size_t size);
+
+/*!
+    @brief Resizes a chunk from the current allocator, the new bytes are zero initialized.
+    @param ptr The chunk to resize, may be NULL.
+    @param old_size The current size of the chunk in bytes.
+    @param new_size The new size of the chunk in bytes.
+    @return The resized chunk, or NULL on failure.
+*/
+void* _MZ_realloc(void* ptr, size_t old_size, size_t new_size);
+
+/*!
+    @brief Gives a chunk back to the current allocator.
+    @param ptr The chunk to free, may be NULL.
+    @param size The size of the chunk in bytes.
+*/
+void _MZ_free(void* ptr, size_t size);
+
 /*!
     @brief Sets a random starting point for producing a series of pseudo-random integers every time the function is called.
 */
@@ -192,11 +399,13 @@ bool MZ_is_in_array(unsigned int *arr, int n, float target);
     @brief Struct that holds the dimensions of the vector and its components
     @param dim The dimension of the vector
     @param elements The elements of the vector
+    @param borrowed true if the elements belong to someone else and are not released with the vector
 
 */
 typedef struct MZ_Vec{
     size_t dim;
     float *elements;
+    bool borrowed;
 }MZ_Vec;
 
 extern MZ_Vec NULL_VECTOR;
@@ -225,11 +434,19 @@ void MZ_print_vector_by_label(FILE* fp, const char* label, MZ_Vec vector);
 void MZ_print_vector_by_index(FILE* fp, int index, MZ_Vec vector);
 
 /*!
-    @brief Free the vector and sets its dimensions to 0.
+    @brief Free the vector and sets its dimensions to 0. The elements of a borrowed vector are left to their owner.
     @param vector The vector to free.
 */
 void MZ_free_vector(MZ_Vec* vector);
 
+/*!
+    @brief Wrap a buffer of floats owned by the caller in a vector, without copying it.
+    @param elements The buffer, which must stay valid as long as the vector is used.
+    @param dim The number of floats of the buffer used as components.
+    @return The vector borrowing the buffer, freeing it does not release the buffer.
+*/
+MZ_Vec MZ_wrap_vector(float* elements, size_t dim);
+
 /*!
     @brief Copy one vector into another.
     @param source The vector to copy.
@@ -288,6 +505,19 @@ MZ_Vec _MZ_new_vector(size_t dim, ...);
 */
 MZ_Vec MZ_copy_vector(MZ_Vec source);
 
+/*
+    The _into functions write their result into a destination of matching dimensions given by the
+    caller instead of allocating it. The destination may be one of the operands unless its doc says
+    otherwise; the ones that cannot work in place assert against it with MZ_ALIAS_ERROR.
+*/
+
+/*!
+    @brief Copy the components of a vector into a destination vector.
+    @param dest The destination vector, of the same dimensions as the source.
+    @param source The vector to copy.
+*/
+void MZ_copy_vector_into(MZ_Vec* dest, MZ_Vec source);
+
 /*!
     @brief Sums the two vectors.
     @param vector1
@@ -296,6 +526,14 @@ MZ_Vec MZ_copy_vector(MZ_Vec source);
 */
 MZ_Vec MZ_add_two_vectors(MZ_Vec vector1 , MZ_Vec vector2);
 
+/*!
+    @brief Sums the two vectors into a destination vector.
+    @param dest The destination vector, of the same dimensions as the operands.
+    @param vector1
+    @param vector2
+*/
+void MZ_add_two_vectors_into(MZ_Vec* dest, MZ_Vec vector1, MZ_Vec vector2);
+
 /*!
     @brief Sums a vector and a scalar.
     @param vector1
@@ -304,6 +542,14 @@ MZ_Vec MZ_add_two_vectors(MZ_Vec vector1 , MZ_Vec vector2);
 */
 MZ_Vec MZ_add_vector_with_scalar(MZ_Vec vector1 , float scalar);
 
+/*!
+    @brief Sums a vector and a scalar into a destination vector.
+    @param dest The destination vector, of the same dimensions as the operands.
+    @param vector1
+    @param scalar
+*/
+void MZ_add_vector_with_scalar_into(MZ_Vec* dest, MZ_Vec vector1, float scalar);
+
 /*!
     @brief Sums the two vectors.
     @param vector1
@@ -312,6 +558,14 @@ MZ_Vec MZ_add_vector_with_scalar(MZ_Vec vector1 , float scalar);
 */
 MZ_Vec MZ_subtract_two_vectors(MZ_Vec vector1 , MZ_Vec vector2);
 
+/*!
+    @brief Subtract the two vectors into a destination vector.
+    @param dest The destination vector, of the same dimensions as the operands.
+    @param vector1
+    @param vector2
+*/
+void MZ_subtract_two_vectors_into(MZ_Vec* dest, MZ_Vec vector1, MZ_Vec vector2);
+
 /*!
     @brief Subtract a vector and a scalar.
     @param vector1
@@ -320,6 +574,14 @@ MZ_Vec MZ_subtract_two_vectors(MZ_Vec vector1 , MZ_Vec vector2);
 */
 MZ_Vec MZ_subtract_vector_with_scalar(MZ_Vec vector1 , float scalar);
 
+/*!
+    @brief Subtract a vector and a scalar into a destination vector.
+    @param dest The destination vector, of the same dimensions as the operands.
+    @param vector1
+    @param scalar
+*/
+void MZ_subtract_vector_with_scalar_into(MZ_Vec* dest, MZ_Vec vector1, float scalar);
+
 /*!
     @brief Multiply two vectors.
     @param vector1
@@ -328,6 +590,14 @@ MZ_Vec MZ_subtract_vector_with_scalar(MZ_Vec vector1 , float scalar);
 */
 MZ_Vec MZ_multiply_two_vectors(MZ_Vec vector1, MZ_Vec vector2);
 
+/*!
+    @brief Multiply two vectors into a destination vector.
+    @param dest The destination vector, of the same dimensions as the operands.
+    @param vector1
+    @param vector2
+*/
+void MZ_multiply_two_vectors_into(MZ_Vec* dest, MZ_Vec vector1, MZ_Vec vector2);
+
 /*!
     @brief Multiply a vector and a scalar.
     @param vector1
@@ -336,6 +606,14 @@ MZ_Vec MZ_multiply_two_vectors(MZ_Vec vector1, MZ_Vec vector2);
 */
 MZ_Vec MZ_multiply_vector_by_scalar(MZ_Vec vector1, float scalar);
 
+/*!
+    @brief Multiply a vector and a scalar into a destination vector.
+    @param dest The destination vector, of the same dimensions as the operands.
+    @param vector1
+    @param scalar
+*/
+void MZ_multiply_vector_by_scalar_into(MZ_Vec* dest, MZ_Vec vector1, float scalar);
+
 /*!
     @brief Divide two vectors.
     @param vector1
@@ -344,6 +622,15 @@ MZ_Vec MZ_multiply_vector_by_scalar(MZ_Vec vector1, float scalar);
 */
 MZ_Vec MZ_divide_two_vectors(MZ_Vec vector1, MZ_Vec vector2);
 
+/*!
+    @brief Divide two vectors into a destination vector.
+    @param dest The destination vector, of the same dimensions as the operands.
+    @param vector1
+    @param vector2
+    @return false if a component of vector2 is 0, in which case dest is left untouched.
+*/
+bool MZ_divide_two_vectors_into(MZ_Vec* dest, MZ_Vec vector1, MZ_Vec vector2);
+
 /*!
     @brief Divide a vector and a scalar.
     @param vector1
@@ -352,6 +639,14 @@ MZ_Vec MZ_divide_two_vectors(MZ_Vec vector1, MZ_Vec vector2);
 */
 MZ_Vec MZ_divide_vector_by_scalar(MZ_Vec vector1, float scalar);
 
+/*!
+    @brief Divide a vector and a scalar into a destination vector.
+    @param dest The destination vector, of the same dimensions as the operands.
+    @param vector1
+    @param scalar
+*/
+void MZ_divide_vector_by_scalar_into(MZ_Vec* dest, MZ_Vec vector1, float scalar);
+
 /*!
     @brief Raise every component of a vector to the exponent given.
     @param vector The vector to raise.
@@ -360,6 +655,14 @@ MZ_Vec MZ_divide_vector_by_scalar(MZ_Vec vector1, float scalar);
 */
 MZ_Vec MZ_raise_vector_to_exp(MZ_Vec vector, size_t exponent);
 
+/*!
+    @brief Raise every component of a vector to the exponent given into a destination vector.
+    @param dest The destination vector, of the same dimensions as the operands.
+    @param vector The vector to raise.
+    @param exponent The exponent of the power.
+*/
+void MZ_raise_vector_to_exp_into(MZ_Vec* dest, MZ_Vec vector, size_t exponent);
+
 /*!
     @brief The cross product between two vectors.
     @param vector1
@@ -368,6 +671,15 @@ MZ_Vec MZ_raise_vector_to_exp(MZ_Vec vector, size_t exponent);
 */
 MZ_Vec MZ_cross_product(MZ_Vec vector1, MZ_Vec vector2);
 
+/*!
+    @brief The cross product between two vectors into a destination vector.
+    @param dest The destination vector, of the same dimensions as the operands.
+    @param vector1
+    @param vector2
+    @return false if the vectors are not three dimensional.
+*/
+bool MZ_cross_product_into(MZ_Vec* dest, MZ_Vec vector1, MZ_Vec vector2);
+
 /*!
     @brief This function return the normalized version of a vector given.
     @param vector The vector to normalize.
@@ -375,6 +687,13 @@ MZ_Vec MZ_cross_product(MZ_Vec vector1, MZ_Vec vector2);
 */
 MZ_Vec MZ_normalized_vector(MZ_Vec vector);
 
+/*!
+    @brief Writes the normalized version of a vector into a destination vector.
+    @param dest The destination vector, of the same dimensions as the operands.
+    @param vector The vector to normalize.
+*/
+void MZ_normalized_vector_into(MZ_Vec* dest, MZ_Vec vector);
+
 /*!
     @brief Calculate the vector projection of a vector A on a vector B.
     @param vector_A The vector to project.
@@ -383,6 +702,14 @@ MZ_Vec MZ_normalized_vector(MZ_Vec vector);
 */
 MZ_Vec MZ_vector_proj_a_on_b(MZ_Vec vector_A, MZ_Vec vector_B);
 
+/*!
+    @brief Calculate the vector projection of a vector A on a vector B into a destination vector.
+    @param dest The destination vector, of the same dimensions as the operands.
+    @param vector_A The vector to project.
+    @param vector_B The vector to project onto.
+*/
+void MZ_vector_proj_a_on_b_into(MZ_Vec* dest, MZ_Vec vector_A, MZ_Vec vector_B);
+
 /*!
     @brief This function return the normalized version of a vector given.
     @param vector The vector pointer to normalize.
@@ -495,13 +822,23 @@ typedef enum Direction{
     @param rows The number of rows.
     @param cols The number of columns.
     @param elements The elements of the matrix.
+    @param stride The number of floats between the start of two rows, 0 if the rows are packed back to back.
+    @param borrowed true if the elements belong to someone else and are not released with the matrix.
 */
 typedef struct MZ_Matrix{
     unsigned int rows;
     unsigned int cols;
     float* elements;
+    unsigned int stride;
+    bool borrowed;
 }MZ_Matrix;
 
+/*!
+    @param matrix The source matrix.
+    @return The number of floats between the start of two rows of the matrix.
+*/
+#define MZ_STRIDE_OF_MATRIX(matrix) ((matrix).stride != 0 ? (matrix).stride : (matrix).cols)
+
 extern MZ_Matrix NULL_MATRIX;
 
 /*!
@@ -528,11 +865,21 @@ void MZ_print_matrix_by_label(FILE *fp, const char* label, MZ_Matrix mat);
 void MZ_print_matrix_by_index(FILE *fp, unsigned int index, MZ_Matrix mat);
 
 /*!
-    @brief Frees the matrix and set the rows and cols to 0.
+    @brief Frees the matrix and set the rows and cols to 0. The elements of a borrowed matrix are left to their owner.
     @param mat The matrix to free.
 */
 void MZ_free_matrix(MZ_Matrix* mat);
 
+/*!
+    @brief Wrap a buffer of floats owned by the caller in a matrix, without copying it.
+    @param elements The buffer, row after row, which must stay valid as long as the matrix is used.
+    @param rows The rows of the matrix.
+    @param cols The cols of the matrix.
+    @param stride The number of floats between the start of two rows, 0 if the rows are packed back to back.
+    @return The matrix borrowing the buffer, freeing it does not release the buffer.
+*/
+MZ_Matrix MZ_wrap_matrix(float* elements, unsigned int rows, unsigned int cols, unsigned int stride);
+
 /*!
     @brief Copy the source matrix to the destination matrix by the pointer.
     @param source The source matrix to copy.
@@ -548,6 +895,21 @@ void MZ_copy_matrix_pointer(MZ_Matrix *source, MZ_Matrix *dest);
 */
 MZ_Matrix MZ_alloc_matrix(unsigned int rows, unsigned int cols);
 
+/*!
+    @brief Allocate memory chunk to the matrix with every row padded to start on a cache line.
+    @param rows The rows of the matrix.
+    @param cols The cols of the matrix.
+    @return The allocated memory chunk, its stride is cols rounded up to a multiple of 16 floats.
+*/
+MZ_Matrix MZ_alloc_padded_matrix(unsigned int rows, unsigned int cols);
+
+/*!
+    @brief Copy the elements of a matrix into a destination matrix.
+    @param dest The destination matrix, of the same dimensions as the source. It may overlap the source, like two views of the same matrix.
+    @param source The matrix to copy.
+*/
+void MZ_copy_matrix_into(MZ_Matrix* dest, MZ_Matrix source);
+
 /*!
     @brief Create a matrix of rows * cols dimensions all set to 0.
     @param rows The rows of the matrix.
@@ -624,6 +986,15 @@ MZ_Vec MZ_Matrix_to_vector(MZ_Matrix source);
 */
 MZ_Vec MZ_get_vector_from_matrix_row(MZ_Matrix source, unsigned int row);
 
+/*!
+    @brief Copy a matrix's row into a destination vector.
+    @param dest The destination vector, of dimension source.cols.
+    @param source The source matrix.
+    @param row The row (starting from 1) that will be copied.
+    @return false if the row does not exist.
+*/
+bool MZ_get_vector_from_matrix_row_into(MZ_Vec* dest, MZ_Matrix source, unsigned int row);
+
 /*!
     @brief Create a vector from a matrix's col.
     @param source The source matrix.
@@ -632,6 +1003,98 @@ MZ_Vec MZ_get_vector_from_matrix_row(MZ_Matrix source, unsigned int row);
 */
 MZ_Vec MZ_get_vector_from_matrix_col(MZ_Matrix source, unsigned int col);
 
+/*!
+    @brief Copy a matrix's col into a destination vector.
+    @param dest The destination vector, of dimension source.rows.
+    @param source The source matrix.
+    @param col The col (starting from 1) that will be copied.
+    @return false if the col does not exist.
+*/
+bool MZ_get_vector_from_matrix_col_into(MZ_Vec* dest, MZ_Matrix source, unsigned int col);
+
+/*
+    Views share the elements of the matrix or vector they are taken from: nothing is copied,
+    writing through a view writes the source, and views are borrowed so freeing one leaves the
+    source untouched. A view of a block keeps the stride of its source, so it is accepted by
+    every operation taking a matrix.
+*/
+
+/*!
+    @brief View a matrix's row as a vector, without copying it.
+    @param source The source matrix.
+    @param row The row (starting from 1) to view.
+    @return The vector sharing the elements of the row, NULL_VECTOR if the row does not exist.
+*/
+MZ_Vec MZ_view_of_matrix_row(MZ_Matrix source, unsigned int row);
+
+/*!
+    @brief View a matrix's col as a matrix of a single col, without copying it.
+    @param source The source matrix.
+    @param col The col (starting from 1) to view.
+    @return The source.rows x 1 matrix sharing the elements of the col, NULL_MATRIX if the col does not exist.
+*/
+MZ_Matrix MZ_view_of_matrix_col(MZ_Matrix source, unsigned int col);
+
+/*!
+    @brief View a rectangular block of a matrix, without copying it.
+    @param source The source matrix.
+    @param row The first row of the block (starting from 0).
+    @param col The first col of the block (starting from 0).
+    @param rows The number of rows of the block.
+    @param cols The number of cols of the block.
+    @return The matrix sharing the elements of the block, NULL_MATRIX if the block goes past the source.
+*/
+MZ_Matrix MZ_view_of_matrix_block(MZ_Matrix source, unsigned int row, unsigned int col, unsigned int rows, unsigned int cols);
+
+/*!
+    @brief View the elements of a matrix with other dimensions, without copying them.
+    @param source The source matrix, whose rows must not be padded.
+    @param rows The number of rows of the view.
+    @param cols The number of cols of the view, rows * cols must be the number of elements of the source.
+    @return The matrix sharing the elements of the source.
+*/
+MZ_Matrix MZ_reshaped_view_of_matrix(MZ_Matrix source, unsigned int rows, unsigned int cols);
+
+/*!
+    @brief View the elements of a matrix as a vector, row after row, without copying them.
+    @param source The source matrix, whose rows must not be padded.
+    @return The vector of dimension source.rows * source.cols sharing the elements of the source.
+*/
+MZ_Vec MZ_view_of_matrix_as_vector(MZ_Matrix source);
+
+/*!
+    @brief View the components of a vector as a matrix, row after row, without copying them.
+    @param source The source vector.
+    @param rows The number of rows of the view.
+    @param cols The number of cols of the view, rows * cols must be the dimension of the vector.
+    @return The matrix sharing the components of the vector.
+*/
+MZ_Matrix MZ_view_of_vector_as_matrix(MZ_Vec source, unsigned int rows, unsigned int cols);
+
+/*!
+    @brief Calculate the scalar projection of every row of a matrix on a vector B in a single sweep.
+    @param vectors_A The matrix whose rows are the vectors to project.
+    @param vector_B The vector to project onto, of the same dimensions as the rows.
+    @return The vector of the scalar projections, one per row.
+*/
+MZ_Vec MZ_scalar_proj_rows_on_b(MZ_Matrix vectors_A, MZ_Vec vector_B);
+
+/*!
+    @brief Calculate the vector projection of every row of a matrix on a vector B in a single sweep.
+    @param vectors_A The matrix whose rows are the vectors to project.
+    @param vector_B The vector to project onto, of the same dimensions as the rows.
+    @return The matrix whose rows are the projections of the rows of vectors_A.
+*/
+MZ_Matrix MZ_vector_proj_rows_on_b(MZ_Matrix vectors_A, MZ_Vec vector_B);
+
+/*!
+    @brief Calculate the vector projection of every row of a matrix on a vector B into a destination matrix.
+    @param dest The destination matrix, of the same dimensions as vectors_A.
+    @param vectors_A The matrix whose rows are the vectors to project.
+    @param vector_B The vector to project onto, of the same dimensions as the rows.
+*/
+void MZ_vector_proj_rows_on_b_into(MZ_Matrix* dest, MZ_Matrix vectors_A, MZ_Vec vector_B);
+
 /*!
     @brief Flattens the given matrix in a vertical or horizontal direction
     @param matrix The matrix to flatten
@@ -648,6 +1111,14 @@ MZ_Matrix MZ_flatten_matrix(MZ_Matrix matrix, Direction dir);
 */
 MZ_Matrix MZ_add_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2);
 
+/*!
+    @brief Add two matrices together into a destination matrix.
+    @param dest The destination matrix, of the same dimensions as the operands.
+    @param matrix1
+    @param matrix2
+*/
+void MZ_add_two_matrices_into(MZ_Matrix* dest, MZ_Matrix matrix1, MZ_Matrix matrix2);
+
 /*!
     @brief Add a scalar to every single element of the matrix.
     @param matrix1.
@@ -656,6 +1127,14 @@ MZ_Matrix MZ_add_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2);
 */
 MZ_Matrix MZ_add_matrix_with_scalar(MZ_Matrix matrix1, float scalar);
 
+/*!
+    @brief Add a scalar to every single element of the matrix into a destination matrix.
+    @param dest The destination matrix, of the same dimensions as the operands.
+    @param matrix1
+    @param scalar
+*/
+void MZ_add_matrix_with_scalar_into(MZ_Matrix* dest, MZ_Matrix matrix1, float scalar);
+
 /*!
     @brief Subtract two matrices together.
     @param matrix1.
@@ -664,6 +1143,14 @@ MZ_Matrix MZ_add_matrix_with_scalar(MZ_Matrix matrix1, float scalar);
 */
 MZ_Matrix MZ_subtract_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2);
 
+/*!
+    @brief Subtract two matrices together into a destination matrix.
+    @param dest The destination matrix, of the same dimensions as the operands.
+    @param matrix1
+    @param matrix2
+*/
+void MZ_subtract_two_matrices_into(MZ_Matrix* dest, MZ_Matrix matrix1, MZ_Matrix matrix2);
+
 /*!
     @brief Subtract a scalar to every single element of the matrix.
     @param matrix1.
@@ -673,7 +1160,15 @@ MZ_Matrix MZ_subtract_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2);
 MZ_Matrix MZ_subtract_matrix_with_scalar(MZ_Matrix matrix1, float scalar);
 
 /*!
-    @brief Multiply two matrices together by the rows per cols product.
+    @brief Subtract a scalar to every single element of the matrix into a destination matrix.
+    @param dest The destination matrix, of the same dimensions as the operands.
+    @param matrix1
+    @param scalar
+*/
+void MZ_subtract_matrix_with_scalar_into(MZ_Matrix* dest, MZ_Matrix matrix1, float scalar);
+
+/*!
+    @brief Multiply two matrices together by the rows per cols product using a cache-blocked kernel.
     @param matrix1.
     @param matrix2
     @return The product of two matrices together by the rows per cols product.
@@ -681,90 +1176,258 @@ MZ_Matrix MZ_subtract_matrix_with_scalar(MZ_Matrix matrix1, float scalar);
 MZ_Matrix MZ_multiply_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2);
 
 /*!
-    @brief Multiply a scalar to every single element of the matrix.
-    @param matrix1.
-    @param scalar.
-    @return The product of every single element of the matrix to a certain scalar.
+    @brief Multiply two matrices together by the rows per cols product into a destination matrix.
+    @param dest The destination matrix of matrix1.rows x matrix2.cols. It must not be one of the operands.
+    @param matrix1
+    @param matrix2
 */
-MZ_Matrix MZ_multiply_matrix_by_scalar(MZ_Matrix matrix1, float scalar);
+void MZ_multiply_two_matrices_into(MZ_Matrix* dest, MZ_Matrix matrix1, MZ_Matrix matrix2);
 
 /*!
-    @brief Divide two matrices together.
-    @param matrix1.
-    @param matrix2.
-    @return The division of the two matrices.
+    @brief Whether an operand of MZ_gemm is used as it is or transposed.
 */
-MZ_Matrix MZ_divide_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2);
+typedef enum MZ_Transpose{
+    MZ_NO_TRANSPOSE = 0,
+    MZ_TRANSPOSE = 1,
+}MZ_Transpose;
 
 /*!
-    @brief Divide a scalar to every single element of the matrix.
-    @param matrix1.
-    @param scalar.
-    @return The division of every single element of the matrix to a certain scalar.
-*/
-MZ_Matrix MZ_divide_matrix_by_scalar(MZ_Matrix matrix1, float scalar);
+    @brief General matrix product dest = alpha * op(A) * op(B) + beta * dest computed in one pass,
+    op(X) being X or its transpose. With beta equal to 0 the previous content of dest is not read.
+    @param transpose_A Whether A is transposed.
+    @param transpose_B Whether B is transposed.
+    @param alpha The scale of the product.
+    @param matrix_A
+    @param matrix_B
+    @param beta The scale of the previous content of dest.
+    @param dest The destination matrix of op(A).rows x op(B).cols. It must not be one of the operands.
+*/
+void MZ_gemm(MZ_Transpose transpose_A, MZ_Transpose transpose_B, float alpha, MZ_Matrix matrix_A, MZ_Matrix matrix_B, float beta, MZ_Matrix* dest);
 
 /*!
-    @brief Multiply two matrices together.
-    @param matrix1.
-    @param matrix2.
-    @return The product of the two matrices element by elements.
+    @brief General matrix-vector product dest = alpha * op(A) * vector + beta * dest, op(A) being A or its transpose.
+    With beta equal to 0 the previous content of dest is not read.
+    @param transpose_A Whether A is transposed, A^T * vector is computed without copying A.
+    @param alpha The scale of the product.
+    @param matrix_A
+    @param vector A vector of op(A).cols dimensions.
+    @param beta The scale of the previous content of dest.
+    @param dest The destination vector of op(A).rows dimensions. It must not be the operand.
 */
-MZ_Matrix MZ_product_element_wise_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2);
+void MZ_gemv(MZ_Transpose transpose_A, float alpha, MZ_Matrix matrix_A, MZ_Vec vector, float beta, MZ_Vec* dest);
 
+/*!
+    @brief Scaled sum of two matrices dest = alpha * op(A) + beta * op(B), op(X) being X or its transpose.
+    With beta equal to 0 B is not read.
+    @param transpose_A Whether A is transposed.
+    @param alpha The scale of A.
+    @param matrix_A
+    @param transpose_B Whether B is transposed.
+    @param beta The scale of B.
+    @param matrix_B
+    @param dest The destination matrix of op(A).rows x op(A).cols. It may be an operand that is not transposed.
+*/
+void MZ_geam(MZ_Transpose transpose_A, float alpha, MZ_Matrix matrix_A, MZ_Transpose transpose_B, float beta, MZ_Matrix matrix_B, MZ_Matrix* dest);
 
 /*!
-    @brief Transpose a matrix.
-    @param source The matrix to transpose.
-    @return The transposed matrix.
+    @brief Product element by element dest = op(A) .* op(B), op(X) being X or its transpose.
+    @param transpose_A Whether A is transposed.
+    @param matrix_A
+    @param transpose_B Whether B is transposed.
+    @param matrix_B
+    @param dest The destination matrix of op(A).rows x op(A).cols. It may be an operand that is not transposed.
 */
-MZ_Matrix MZ_transposed_matrix(MZ_Matrix source);
+void MZ_product_element_wise_transposed_into(MZ_Transpose transpose_A, MZ_Matrix matrix_A, MZ_Transpose transpose_B, MZ_Matrix matrix_B, MZ_Matrix* dest);
 
 /*!
-    @brief Swap two rows in a matrix.
-    @param source The original matrix.
-    @param row1.
-    @param row2.
-    @return The matrix in which row1 and row2 have been swapped.
+    @brief Quotient element by element dest = op(A) ./ op(B), op(X) being X or its transpose, 0 where op(B) is 0.
+    @param transpose_A Whether A is transposed.
+    @param matrix_A
+    @param transpose_B Whether B is transposed.
+    @param matrix_B
+    @param dest The destination matrix of op(A).rows x op(A).cols. It may be an operand that is not transposed.
 */
-bool MZ_swap_two_matrix_rows(MZ_Matrix *source, unsigned int row1, unsigned int row2);
+void MZ_divide_two_matrices_transposed_into(MZ_Transpose transpose_A, MZ_Matrix matrix_A, MZ_Transpose transpose_B, MZ_Matrix matrix_B, MZ_Matrix* dest);
 
 /*!
-    @brief Add two rows in a matrix.
-    @param source The original matrix.
-    @param row1.
-    @param row2.
-    @return The matrix in which row1 and row2 have been added.
+    @brief Multiply two matrices together with the textbook triple loop.
+    @attention This is kept only as a reference to verify MZ_multiply_two_matrices.
+    @param matrix1.
+    @param matrix2
+    @return The product of two matrices together by the rows per cols product.
 */
-bool MZ_add_two_matrix_rows(MZ_Matrix *source, unsigned int row1, unsigned int row2);
+MZ_Matrix MZ_multiply_two_matrices_naive(MZ_Matrix matrix1, MZ_Matrix matrix2);
+
+/*!
+    @brief Multiply a matrix by a column vector.
+    @param matrix
+    @param vector A vector of matrix.cols dimensions.
+    @return The vector matrix * vector of matrix.rows dimensions.
+*/
+MZ_Vec MZ_multiply_matrix_by_vector(MZ_Matrix matrix, MZ_Vec vector);
+
+/*!
+    @brief Multiply a matrix by a column vector into a destination vector.
+    @param dest The destination vector of matrix.rows dimensions. It must not be the operand.
+    @param matrix
+    @param vector A vector of matrix.cols dimensions.
+*/
+void MZ_multiply_matrix_by_vector_into(MZ_Vec* dest, MZ_Matrix matrix, MZ_Vec vector);
+
+/*!
+    @brief Multiply a row vector by a matrix, that is the product of the transposed matrix by the vector.
+    @param vector A vector of matrix.rows dimensions.
+    @param matrix
+    @return The vector vector * matrix of matrix.cols dimensions.
+*/
+MZ_Vec MZ_multiply_vector_by_matrix(MZ_Vec vector, MZ_Matrix matrix);
+
+/*!
+    @brief Multiply a row vector by a matrix into a destination vector.
+    @param dest The destination vector of matrix.cols dimensions. It must not be the operand.
+    @param vector A vector of matrix.rows dimensions.
+    @param matrix
+*/
+void MZ_multiply_vector_by_matrix_into(MZ_Vec* dest, MZ_Vec vector, MZ_Matrix matrix);
+
+/*!
+    @brief Multiply a scalar to every single element of the matrix.
+    @param matrix1.
+    @param scalar.
+    @return The product of every single element of the matrix to a certain scalar.
+*/
+MZ_Matrix MZ_multiply_matrix_by_scalar(MZ_Matrix matrix1, float scalar);
+
+/*!
+    @brief Multiply a scalar to every single element of the matrix into a destination matrix.
+    @param dest The destination matrix, of the same dimensions as the operands.
+    @param matrix1
+    @param scalar
+*/
+void MZ_multiply_matrix_by_scalar_into(MZ_Matrix* dest, MZ_Matrix matrix1, float scalar);
+
+/*!
+    @brief Divide two matrices together.
+    @param matrix1.
+    @param matrix2.
+    @return The division of the two matrices.
+*/
+MZ_Matrix MZ_divide_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2);
+
+/*!
+    @brief Divide two matrices together into a destination matrix.
+    @param dest The destination matrix, of the same dimensions as the operands.
+    @param matrix1
+    @param matrix2
+*/
+void MZ_divide_two_matrices_into(MZ_Matrix* dest, MZ_Matrix matrix1, MZ_Matrix matrix2);
+
+/*!
+    @brief Divide a scalar to every single element of the matrix.
+    @param matrix1.
+    @param scalar.
+    @return The division of every single element of the matrix to a certain scalar.
+*/
+MZ_Matrix MZ_divide_matrix_by_scalar(MZ_Matrix matrix1, float scalar);
+
+/*!
+    @brief Divide a scalar to every single element of the matrix into a destination matrix.
+    @param dest The destination matrix, of the same dimensions as the operands.
+    @param matrix1
+    @param scalar
+    @return false if the scalar is 0, in which case dest is left untouched.
+*/
+bool MZ_divide_matrix_by_scalar_into(MZ_Matrix* dest, MZ_Matrix matrix1, float scalar);
+
+/*!
+    @brief Multiply two matrices together.
+    @param matrix1.
+    @param matrix2.
+    @return The product of the two matrices element by elements.
+*/
+MZ_Matrix MZ_product_element_wise_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2);
+
+/*!
+    @brief Multiply two matrices together element by element into a destination matrix.
+    @param dest The destination matrix, of the same dimensions as the operands.
+    @param matrix1
+    @param matrix2
+*/
+void MZ_product_element_wise_two_matrices_into(MZ_Matrix* dest, MZ_Matrix matrix1, MZ_Matrix matrix2);
+
+
+/*!
+    @brief Transpose a matrix.
+    @param source The matrix to transpose.
+    @return The transposed matrix.
+*/
+MZ_Matrix MZ_transposed_matrix(MZ_Matrix source);
+
+/*!
+    @brief Transpose a matrix into a destination matrix.
+    @param dest The destination matrix of source.cols x source.rows. It may be the source only if the matrix is square.
+    @param source The matrix to transpose.
+*/
+void MZ_transposed_matrix_into(MZ_Matrix* dest, MZ_Matrix source);
 
 /*!
-    @brief Multiply two rows in a matrix.
+    @brief Swap two rows in a matrix.
     @param source The original matrix.
     @param row1.
     @param row2.
-    @return The matrix in which row1 and row2 have been multiplied.
+    @return The matrix in which row1 and row2 have been swapped.
 */
-bool MZ_multiply_two_matrix_rows(MZ_Matrix *source, unsigned int row, int scalar);
+bool MZ_swap_two_matrix_rows(MZ_Matrix *source, unsigned int row1, unsigned int row2);
 
 /*!
-    @brief Multiply one row to a scalar and then add it to the other row.
+    @brief Add two rows in a matrix.
     @param source The original matrix.
     @param row1.
     @param row2.
-    @return The matrix in which row2 have been multiplied to a scalar and then add it to the row1.
+    @return The matrix in which row1 and row2 have been added.
+*/
+bool MZ_add_two_matrix_rows(MZ_Matrix *source, unsigned int row1, unsigned int row2);
+
+/*!
+    @brief Multiply a row of a matrix by a scalar.
+    @param source The original matrix.
+    @param row The row to multiply.
+    @param scalar The scalar, not 0.
+    @return false if the row is out of range or the scalar is 0.
+*/
+bool MZ_multiply_two_matrix_rows(MZ_Matrix *source, unsigned int row, float scalar);
+
+/*!
+    @brief Multiply one row to a scalar and then add it to the other row.
+    @param source The original matrix.
+    @param row1 The row to which the scaled row2 is added.
+    @param row2 The row to scale.
+    @param scalar The scalar, not 0.
+    @return false if a row is out of range, the two rows are the same or the scalar is 0.
+*/
+bool MZ_multiply_add_two_matrix_rows(MZ_Matrix *source, unsigned int row1, unsigned int row2, float scalar);
+
+/*!
+    @brief Multiply one row to a different scalar for each of a range of rows and add it to them, in one pass over the row.
+    @param source The original matrix.
+    @param row The row to scale, outside of the range.
+    @param first The first row of the range.
+    @param count The number of rows in the range.
+    @param scalars The count scalars, scalars[i] is used for the row first + i.
+    @return false if a row is out of range or the row is inside the range.
 */
-bool MZ_multiply_add_two_matrix_rows(MZ_Matrix *source, unsigned int row1, unsigned int row2, int scalar);
+bool MZ_multiply_add_matrix_row_to_rows(MZ_Matrix *source, unsigned int row, unsigned int first, unsigned int count, const float* scalars);
 
 /*!
-    @brief Convert a matrix to its Row Echelon Form.
+    @brief Convert a matrix to its Row Echelon Form, with partial pivoting and every pivot scaled to 1.
+           Elements not larger than max(rows, cols) * FLT_EPSILON times the infinity norm of the matrix are counted as zeros.
     @param source The source matrix.
     @return The Row Echelon Form of the Matrix.
 */
 void MZ_to_echelon_form(MZ_Matrix *source);
 
 /*!
-    @brief Convert a matrix to its Reduced Row Echelon Form.
+    @brief Convert a matrix to its Reduced Row Echelon Form, with the same pivoting and tolerance as MZ_to_echelon_form.
     @param source The source matrix.
     @return The Reduced Row Echelon Form of the Matrix.
 */
@@ -813,12 +1476,20 @@ float MZ_minor(MZ_Matrix source, unsigned int row, unsigned int col);
 */
 float MZ_cofactor(MZ_Matrix source, unsigned int row, unsigned int col);
 /*!
-    @brief Find the determinant of a matrix through cofactor expansion with an exclusion list.
+    @brief Find the determinant of a matrix through its LU factorization.
     @param source The source Matrix.
     @return The determinant of the matrix.
 */
 float MZ_determinant_of_matrix(MZ_Matrix source);
 
+/*!
+    @brief Find the determinant of a matrix through cofactor expansion.
+    @attention This runs in O(n!) and is kept only as a reference for MZ_determinant_of_matrix.
+    @param source The source Matrix.
+    @return The determinant of the matrix.
+*/
+float MZ_determinant_of_matrix_by_cofactor(MZ_Matrix source);
+
 /*!
     @brief Calculates the matrix in which the elements are the cofactor of every element of the source matrix.
     @param source The source matrix.
@@ -841,12 +1512,28 @@ MZ_Matrix MZ_adjugate_matrix(MZ_Matrix source);
 bool MZ_is_matrix_invertible(MZ_Matrix source);
 
 /*!
-    @brief Calculates the inverse of the source matrix.
+    @brief Calculates the inverse of the source matrix through its LU factorization.
     @param source The source matrix.
     @return The inverse of the source matrix.
 */
 MZ_Matrix MZ_inverse_of_matrix(MZ_Matrix source);
 
+/*!
+    @brief Calculates the inverse of the source matrix into a destination matrix through its LU factorization.
+    @param dest The destination matrix, of the same dimensions as the source.
+    @param source The source matrix.
+    @return false if the matrix is not invertible, in which case dest is left untouched.
+*/
+bool MZ_inverse_of_matrix_into(MZ_Matrix* dest, MZ_Matrix source);
+
+/*!
+    @brief Calculates the inverse of the source matrix through the adjugate matrix.
+    @attention This runs in O(n!) and is kept only as a reference for MZ_inverse_of_matrix.
+    @param source The source matrix.
+    @return The inverse of the source matrix.
+*/
+MZ_Matrix MZ_inverse_of_matrix_by_adjugate(MZ_Matrix source);
+
 /*!
     @brief Calculates the inverse of the source matrix using Gaussian Elimination.
     @param source The source matrix.
@@ -872,6 +1559,249 @@ bool MZ_are_two_matrices_orthogonal(MZ_Matrix matrix1, MZ_Matrix matrix2);
 
 bool MZ_is_matrix_orthonormal(MZ_Matrix source);
 
+/*!
+    @brief The struct that holds the LU factorization with partial pivoting of a square matrix (P * A = L * U).
+    @param dim The dimension of the factorized matrix.
+    @param elements The packed factors: L below the diagonal (its unit diagonal is implied) and U on and above it.
+    @param pivots The row permutation: row i of the factors comes from row pivots[i] of the source matrix.
+    @param sign The sign of the permutation, +1 or -1.
+    @param singular true if a zero pivot has been found.
+*/
+typedef struct MZ_LU{
+    unsigned int dim;
+    float* elements;
+    unsigned int* pivots;
+    int sign;
+    bool singular;
+}MZ_LU;
+
+/*!
+    @brief Factorize a square matrix as P * A = L * U using partial pivoting.
+    @param source The source matrix.
+    @return The LU factorization, stored in a single allocation.
+*/
+MZ_LU MZ_lu_decomposition_of_matrix(MZ_Matrix source);
+
+/*!
+    @brief Frees the factorization and sets its dimension to 0.
+    @param lu The factorization to free.
+*/
+void MZ_free_lu(MZ_LU* lu);
+
+/*!
+    @brief Calculate the determinant of the matrix from its LU factorization.
+    @param lu The factorization of the matrix.
+    @return The determinant of the factorized matrix.
+*/
+float MZ_determinant_of_lu(MZ_LU lu);
+
+/*!
+    @brief The struct that holds the Cholesky factorization of a symmetric positive definite matrix (A = L * L^T).
+    @param dim The dimension of the factorized matrix.
+    @param elements The lower triangular factor L, row after row, with zeros above the diagonal.
+    @param singular true if the matrix is not positive definite, in which case the factor is not usable.
+*/
+typedef struct MZ_Cholesky{
+    unsigned int dim;
+    float* elements;
+    bool singular;
+}MZ_Cholesky;
+
+/*!
+    @brief Factorize a symmetric positive definite matrix as A = L * L^T, in about half the operations of LU.
+    @param source The source matrix, only its lower triangle is read.
+    @return The Cholesky factorization.
+*/
+MZ_Cholesky MZ_cholesky(MZ_Matrix source);
+
+/*!
+    @brief Frees the factorization and sets its dimension to 0.
+    @param cholesky The factorization to free.
+*/
+void MZ_free_cholesky(MZ_Cholesky* cholesky);
+
+/*!
+    @brief Calculate the natural logarithm of the determinant of the matrix from its Cholesky factorization.
+    @param cholesky The factorization of the matrix.
+    @return The log of the determinant, which does not overflow like the determinant of a large matrix would.
+*/
+float MZ_log_determinant_of_cholesky(MZ_Cholesky cholesky);
+
+/*!
+    @brief Calculate the inverse of a symmetric positive definite matrix through its Cholesky factorization.
+    @param source The source matrix, only its lower triangle is read.
+    @return The inverse of the source matrix, or a NULL_MATRIX if it is not positive definite.
+*/
+MZ_Matrix MZ_inverse_of_matrix_by_cholesky(MZ_Matrix source);
+
+/*!
+    @brief The kind of factorization held by a MZ_Factorization.
+    @param MZ_FACTORIZATION_LU = 0, LU with partial pivoting.
+    @param MZ_FACTORIZATION_CHOLESKY, Cholesky of a symmetric positive definite matrix.
+*/
+typedef enum MZ_FactorizationKind{
+    MZ_FACTORIZATION_LU = 0,
+    MZ_FACTORIZATION_CHOLESKY,
+    MZ_FACTORIZATION_COUNT,
+}MZ_FactorizationKind;
+
+/*!
+    @brief Reusable handle of a factorized square matrix, used to solve A * x = b for many right-hand sides.
+    @param kind The kind of factorization stored.
+    @param lu The LU factorization (kind == MZ_FACTORIZATION_LU).
+    @param cholesky The Cholesky factorization (kind == MZ_FACTORIZATION_CHOLESKY).
+*/
+typedef struct MZ_Factorization{
+    MZ_FactorizationKind kind;
+    MZ_LU lu;
+    MZ_Cholesky cholesky;
+}MZ_Factorization;
+
+/*!
+    @brief Factorize a square matrix once so that it can be solved against many right-hand sides.
+    @param source The square matrix A.
+    @return The factorization handle, to be released with MZ_free_factorization.
+*/
+MZ_Factorization MZ_factorize(MZ_Matrix source);
+
+/*!
+    @brief Factorize a symmetric positive definite matrix once with Cholesky, so that it can be solved against many right-hand sides.
+    @param source The square matrix A, only its lower triangle is read.
+    @return The factorization handle, singular if A is not positive definite, to be released with MZ_free_factorization.
+*/
+MZ_Factorization MZ_factorize_spd(MZ_Matrix source);
+
+/*!
+    @brief Frees the factorization handle.
+    @param factorization The handle to free.
+*/
+void MZ_free_factorization(MZ_Factorization* factorization);
+
+/*!
+    @brief Checks if the factorized matrix is singular.
+    @param factorization The factorization handle.
+    @return true if the system can not be solved.
+*/
+bool MZ_is_factorization_singular(MZ_Factorization factorization);
+
+/*!
+    @brief Solve A * x = b by forward and backward substitution.
+    @param factorization The factorization of A.
+    @param b The right-hand side.
+    @return The solution x, or a NULL_VECTOR if A is singular.
+*/
+MZ_Vec MZ_solve_vec(MZ_Factorization factorization, MZ_Vec b);
+
+/*!
+    @brief Solve A * x = b into a destination vector.
+    @param dest The destination vector x. It must not be b.
+    @param factorization The factorization of A.
+    @param b The right-hand side.
+    @return false if A is singular, in which case dest is left untouched.
+*/
+bool MZ_solve_vec_into(MZ_Vec* dest, MZ_Factorization factorization, MZ_Vec b);
+
+/*!
+    @brief Solve A * X = B for every column of B at once.
+    @param factorization The factorization of A.
+    @param b The right-hand sides, one per column.
+    @return The solutions X, one per column, or a NULL_MATRIX if A is singular.
+*/
+MZ_Matrix MZ_solve_mat(MZ_Factorization factorization, MZ_Matrix b);
+
+/*!
+    @brief Solve A * X = B for every column of B into a destination matrix.
+    @param dest The destination matrix X. It must not be b.
+    @param factorization The factorization of A.
+    @param b The right-hand sides, one per column.
+    @return false if A is singular, in which case dest is left untouched.
+*/
+bool MZ_solve_mat_into(MZ_Matrix* dest, MZ_Factorization factorization, MZ_Matrix b);
+
+/*!
+    @brief The struct that holds the Householder QR factorization of a matrix (A = Q * R), Q being kept as its reflectors.
+    @param rows The rows of the factorized matrix.
+    @param cols The cols of the factorized matrix.
+    @param elements The packed factors: R on and above the diagonal, the reflectors below it (their leading 1 is implied).
+    @param tau The scale of every reflector, min(rows, cols) of them.
+    @param t The triangular factors of the compact WY form of every block of reflectors (Q_block = I - V * T * V^T).
+*/
+typedef struct MZ_QR{
+    unsigned int rows;
+    unsigned int cols;
+    float* elements;
+    float* tau;
+    float* t;
+}MZ_QR;
+
+/*!
+    @brief Factorize a matrix as A = Q * R with blocked Householder reflections.
+    @param source The source matrix, of any dimensions.
+    @return The QR factorization, stored in a single allocation.
+*/
+MZ_QR MZ_qr(MZ_Matrix source);
+
+/*!
+    @brief Frees the factorization and sets its dimensions to 0.
+    @param qr The factorization to free.
+*/
+void MZ_free_qr(MZ_QR* qr);
+
+/*!
+    @brief Multiply a matrix in place by Q or Q^T without forming Q.
+    @param qr The factorization holding Q.
+    @param trans MZ_TRANSPOSE to multiply by Q^T, MZ_NO_TRANSPOSE to multiply by Q.
+    @param target The matrix to multiply, of qr.rows rows. It is overwritten by the product.
+*/
+void MZ_apply_q_of_qr(MZ_QR qr, MZ_Transpose trans, MZ_Matrix* target);
+
+/*!
+    @brief Form the first min(rows, cols) cols of Q explicitly.
+    @param qr The factorization.
+    @return The qr.rows x min(qr.rows, qr.cols) matrix with orthonormal cols.
+*/
+MZ_Matrix MZ_q_of_qr(MZ_QR qr);
+
+/*!
+    @brief Copy the upper triangular factor R.
+    @param qr The factorization.
+    @return The min(qr.rows, qr.cols) x qr.cols matrix R.
+*/
+MZ_Matrix MZ_r_of_qr(MZ_QR qr);
+
+/*!
+    @brief Find x minimizing the norm of A * x - b through the QR factorization of A, without forming A^T * A.
+    @param source The matrix A, with at least as many rows as cols.
+    @param b The right-hand side, of source.rows components.
+    @return The solution x of source.cols components, or a NULL_VECTOR if the cols of A are linearly dependent, that is if a diagonal element of R is not larger than max(rows, cols) * FLT_EPSILON * the largest one.
+*/
+MZ_Vec MZ_least_squares(MZ_Matrix source, MZ_Vec b);
+
+/*!
+    @brief Find x minimizing the norm of A * x - b into a destination vector.
+    @param dest The destination vector x, of source.cols components.
+    @param source The matrix A, with at least as many rows as cols.
+    @param b The right-hand side, of source.rows components.
+    @return false if the cols of A are linearly dependent, in which case dest is left untouched.
+*/
+bool MZ_least_squares_into(MZ_Vec* dest, MZ_Matrix source, MZ_Vec b);
+
+/*!
+    @brief Calculate the rank of a matrix by QR with column pivoting, with the default tolerance
+    max(rows, cols) * FLT_EPSILON * the largest diagonal element of R.
+    @param source The source matrix, left untouched.
+    @return The number of linearly independent rows or cols of the matrix.
+*/
+unsigned int MZ_rank(MZ_Matrix source);
+
+/*!
+    @brief Calculate the rank of a matrix by QR with column pivoting.
+    @param source The source matrix, left untouched.
+    @param tolerance The diagonal elements of R not larger than it, in absolute value, are counted as 0.
+    @return The number of diagonal elements of R larger than the tolerance.
+*/
+unsigned int MZ_rank_with_tolerance(MZ_Matrix source, float tolerance);
+
 #define sSTRAIGHT_LINE 196
 #define STRAIGHT_LINE '_'
 #define sLEFT_UP_CORNER 218
@@ -891,7 +1821,7 @@ bool MZ_is_matrix_orthonormal(MZ_Matrix source);
     @param y The y coordinate
     @return The value of the element at the specified coordinates in the matrix
 */
-#define MZ_VALUE_OF_MAT_AT(matrix, x, y) (matrix.elements[(x) * (matrix.cols) + (y)])
+#define MZ_VALUE_OF_MAT_AT(matrix, x, y) (matrix.elements[(x) * MZ_STRIDE_OF_MATRIX(matrix) + (y)])
 
 /*!
     @param matrix The source matrix
@@ -899,7 +1829,7 @@ bool MZ_is_matrix_orthonormal(MZ_Matrix source);
     @param y The y coordinate
     @return the value of the element at the specified coordinates in the matrix pointer
 */
-#define MZ_VALUE_OF_MAT_POINTER_AT(matrix, x, y) (matrix->elements[(x) * (matrix->cols) + (y)])
+#define MZ_VALUE_OF_MAT_POINTER_AT(matrix, x, y) (matrix->elements[(x) * MZ_STRIDE_OF_MATRIX(*matrix) + (y)])
 
 /*!
     @brief Create a matrix of rows * cols dimensions.
@@ -917,57 +1847,565 @@ bool MZ_is_matrix_orthonormal(MZ_Matrix source);
 */
 #define MZ_print_matrix_by_var_name(fp, matrix) MZ_print_matrix_by_label(fp, #matrix, matrix)
 
-#endif // ZMATH_H
-
-#ifdef ZMATH_IMPLEMENTATION
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <math.h>
-#include <stdarg.h>
-#include <stdbool.h>
-#include <time.h>
+/*!
+    @brief Three dimensional vector held by value, no allocation is ever done for it.
+    @param x, y, z The components of the vector.
+    @param elements The components of the vector as an array.
+*/
+typedef union MZ_Vec3{
+    struct { float x, y, z; };
+    float elements[3];
+}MZ_Vec3;
 
-#if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
-#include <unistd.h>
-#elif _WIN32
-#include <process.h>
-#endif 
+/*!
+    @brief Four dimensional vector held by value, aligned to fit a SIMD register.
+    @param x, y, z, w The components of the vector.
+    @param elements The components of the vector as an array.
+*/
+typedef union MZ_Vec4{
+    struct { float x, y, z, w; };
+    _Alignas(16) float elements[4];
+}MZ_Vec4;
 
-#if VISUALIZE_RATIONAL
-#define ZSTRING_IMPLEMENTATION
-#include "zstring.h"
-#else 
-#include <string.h> 
-#endif
+/*!
+    @brief 3x3 matrix held by value, row major like MZ_Matrix.
+    @param elements The elements of the matrix, elements[row][col].
+*/
+typedef struct MZ_Mat3{
+    float elements[3][3];
+}MZ_Mat3;
 
-/*
+/*!
+    @brief 4x4 matrix held by value, row major like MZ_Matrix, every row fits a SIMD register.
+    @param elements The elements of the matrix, elements[row][col].
 */
-void _MZ_assert(bool condition, const char* message, const char* filepath, size_t line){
-    if(!condition){
-        fprintf(stderr, "\n[ERROR] : %s:%zu > %s\n", filepath, line, message);
-        #if EXIT_ON_ASSERT_FAILURE 
-            exit(EXIT_FAILURE);
-        #endif
-    }
-}
+typedef struct MZ_Mat4{
+    _Alignas(16) float elements[4][4];
+}MZ_Mat4;
 
-/*
+/*!
+    @brief Create a three dimensional vector.
+    @param x, y, z The components of the vector.
+    @return The new vector.
 */
-float MZ_rand_float( float min, float max ){
-    float scale = rand() / (float) RAND_MAX; 
-    return min + scale * ( max - min );      
-}
+MZ_Vec3 MZ_new_vec3(float x, float y, float z);
 
 /*!
+    @brief Sum two three dimensional vectors.
+    @param vector1
+    @param vector2
+    @return The sum of the two vectors.
 */
-int MZ_rand_int( int min, int max ){
-    return (rand() % (max - min)) + min;
-}
+MZ_Vec3 MZ_add_two_vec3(MZ_Vec3 vector1, MZ_Vec3 vector2);
 
-/*
+/*!
+    @brief Subtract two three dimensional vectors.
+    @param vector1
+    @param vector2
+    @return The difference of the two vectors.
 */
-void MZ_swap_int(int* a, int* b){
+MZ_Vec3 MZ_subtract_two_vec3(MZ_Vec3 vector1, MZ_Vec3 vector2);
+
+/*!
+    @brief Multiply a three dimensional vector by a scalar.
+    @param vector
+    @param scalar
+    @return The scaled vector.
+*/
+MZ_Vec3 MZ_multiply_vec3_by_scalar(MZ_Vec3 vector, float scalar);
+
+/*!
+    @brief The dot product of two three dimensional vectors.
+    @param vector1
+    @param vector2
+    @return The dot product of the two vectors.
+*/
+float MZ_dot_two_vec3(MZ_Vec3 vector1, MZ_Vec3 vector2);
+
+/*!
+    @brief The cross product of two three dimensional vectors.
+    @param vector1
+    @param vector2
+    @return The vector orthogonal to both.
+*/
+MZ_Vec3 MZ_cross_product_vec3(MZ_Vec3 vector1, MZ_Vec3 vector2);
+
+/*!
+    @brief The magnitude of a three dimensional vector.
+    @param vector
+    @return The magnitude of the vector.
+*/
+float MZ_magnitude_of_vec3(MZ_Vec3 vector);
+
+/*!
+    @brief The normalized version of a three dimensional vector.
+    @param vector The vector to normalize.
+    @return The normalized vector.
+*/
+MZ_Vec3 MZ_normalized_vec3(MZ_Vec3 vector);
+
+/*!
+    @brief Create a four dimensional vector.
+    @param x, y, z, w The components of the vector.
+    @return The new vector.
+*/
+MZ_Vec4 MZ_new_vec4(float x, float y, float z, float w);
+
+/*!
+    @brief Sum two four dimensional vectors.
+    @param vector1
+    @param vector2
+    @return The sum of the two vectors.
+*/
+MZ_Vec4 MZ_add_two_vec4(MZ_Vec4 vector1, MZ_Vec4 vector2);
+
+/*!
+    @brief Subtract two four dimensional vectors.
+    @param vector1
+    @param vector2
+    @return The difference of the two vectors.
+*/
+MZ_Vec4 MZ_subtract_two_vec4(MZ_Vec4 vector1, MZ_Vec4 vector2);
+
+/*!
+    @brief Multiply a four dimensional vector by a scalar.
+    @param vector
+    @param scalar
+    @return The scaled vector.
+*/
+MZ_Vec4 MZ_multiply_vec4_by_scalar(MZ_Vec4 vector, float scalar);
+
+/*!
+    @brief The dot product of two four dimensional vectors.
+    @param vector1
+    @param vector2
+    @return The dot product of the two vectors.
+*/
+float MZ_dot_two_vec4(MZ_Vec4 vector1, MZ_Vec4 vector2);
+
+/*!
+    @brief The magnitude of a four dimensional vector.
+    @param vector
+    @return The magnitude of the vector.
+*/
+float MZ_magnitude_of_vec4(MZ_Vec4 vector);
+
+/*!
+    @brief The normalized version of a four dimensional vector.
+    @param vector The vector to normalize.
+    @return The normalized vector.
+*/
+MZ_Vec4 MZ_normalized_vec4(MZ_Vec4 vector);
+
+/*!
+    @brief Create a 3x3 identity matrix.
+    @return The identity matrix.
+*/
+MZ_Mat3 MZ_identity_mat3(void);
+
+/*!
+    @brief Multiply two 3x3 matrices.
+    @param matrix1
+    @param matrix2
+    @return The product matrix1 * matrix2.
+*/
+MZ_Mat3 MZ_multiply_two_mat3(MZ_Mat3 matrix1, MZ_Mat3 matrix2);
+
+/*!
+    @brief Multiply a 3x3 matrix by a column vector.
+    @param matrix
+    @param vector
+    @return The product matrix * vector.
+*/
+MZ_Vec3 MZ_multiply_mat3_by_vec3(MZ_Mat3 matrix, MZ_Vec3 vector);
+
+/*!
+    @brief Transpose a 3x3 matrix.
+    @param source
+    @return The transposed matrix.
+*/
+MZ_Mat3 MZ_transposed_mat3(MZ_Mat3 source);
+
+/*!
+    @brief The determinant of a 3x3 matrix.
+    @param source
+    @return The determinant of the matrix.
+*/
+float MZ_determinant_of_mat3(MZ_Mat3 source);
+
+/*!
+    @brief The inverse of a 3x3 matrix in closed form.
+    @param source The matrix to invert.
+    @param result Where the inverse is written.
+    @return false if the matrix is singular, result is then left untouched.
+*/
+bool MZ_inverse_of_mat3(MZ_Mat3 source, MZ_Mat3* result);
+
+/*!
+    @brief Create a 4x4 identity matrix.
+    @return The identity matrix.
+*/
+MZ_Mat4 MZ_identity_mat4(void);
+
+/*!
+    @brief Multiply two 4x4 matrices.
+    @param matrix1
+    @param matrix2
+    @return The product matrix1 * matrix2.
+*/
+MZ_Mat4 MZ_multiply_two_mat4(MZ_Mat4 matrix1, MZ_Mat4 matrix2);
+
+/*!
+    @brief Multiply a 4x4 matrix by a column vector.
+    @param matrix
+    @param vector
+    @return The product matrix * vector.
+*/
+MZ_Vec4 MZ_multiply_mat4_by_vec4(MZ_Mat4 matrix, MZ_Vec4 vector);
+
+/*!
+    @brief Transpose a 4x4 matrix.
+    @param source
+    @return The transposed matrix.
+*/
+MZ_Mat4 MZ_transposed_mat4(MZ_Mat4 source);
+
+/*!
+    @brief The determinant of a 4x4 matrix.
+    @param source
+    @return The determinant of the matrix.
+*/
+float MZ_determinant_of_mat4(MZ_Mat4 source);
+
+/*!
+    @brief The inverse of a 4x4 matrix in closed form.
+    @param source The matrix to invert.
+    @param result Where the inverse is written.
+    @return false if the matrix is singular, result is then left untouched.
+*/
+bool MZ_inverse_of_mat4(MZ_Mat4 source, MZ_Mat4* result);
+
+/*!
+    @brief Convert a three dimensional vector to an allocated vector.
+    @param source
+    @return The new vector of dimension 3.
+*/
+MZ_Vec MZ_Vec3_to_vector(MZ_Vec3 source);
+
+/*!
+    @brief Convert a vector of dimension 3 to a three dimensional vector.
+    @param source
+    @return The vector held by value.
+*/
+MZ_Vec3 MZ_Vector_to_vec3(MZ_Vec source);
+
+/*!
+    @brief Convert a four dimensional vector to an allocated vector.
+    @param source
+    @return The new vector of dimension 4.
+*/
+MZ_Vec MZ_Vec4_to_vector(MZ_Vec4 source);
+
+/*!
+    @brief Convert a vector of dimension 4 to a four dimensional vector.
+    @param source
+    @return The vector held by value.
+*/
+MZ_Vec4 MZ_Vector_to_vec4(MZ_Vec source);
+
+/*!
+    @brief Convert a 3x3 matrix to an allocated matrix.
+    @param source
+    @return The new 3x3 matrix.
+*/
+MZ_Matrix MZ_Mat3_to_matrix(MZ_Mat3 source);
+
+/*!
+    @brief Convert a 3x3 matrix to a matrix held by value.
+    @param source
+    @return The matrix held by value.
+*/
+MZ_Mat3 MZ_Matrix_to_mat3(MZ_Matrix source);
+
+/*!
+    @brief Convert a 4x4 matrix to an allocated matrix.
+    @param source
+    @return The new 4x4 matrix.
+*/
+MZ_Matrix MZ_Mat4_to_matrix(MZ_Mat4 source);
+
+/*!
+    @brief Convert a 4x4 matrix to a matrix held by value.
+    @param source
+    @return The matrix held by value.
+*/
+MZ_Mat4 MZ_Matrix_to_mat4(MZ_Matrix source);
+
+/*!
+    @brief Many vectors of the same dimension stored component by component (struct of arrays).
+    The component c of every vector is contiguous, so the batch operations run across the vectors.
+    @param count The number of vectors.
+    @param dim The dimension of every vector.
+    @param stride The distance in floats between two components, count rounded up to a cache line.
+    @param elements The components, the component c of the vector i is at elements[c * stride + i].
+*/
+typedef struct MZ_VecBatch{
+    size_t count;
+    size_t dim;
+    size_t stride;
+    float* elements;
+}MZ_VecBatch;
+
+extern MZ_VecBatch NULL_VEC_BATCH;
+
+#define MZ_COMPONENT_OF_BATCH(batch, c) ((batch).elements + (size_t)(c) * (batch).stride)
+#define MZ_VALUE_OF_BATCH_AT(batch, index, c) (MZ_COMPONENT_OF_BATCH(batch, c)[(index)])
+
+/*!
+    @brief Allocate a batch of vectors with every component set to 0.
+    @param count The number of vectors.
+    @param dim The dimension of every vector.
+    @return The new batch.
+*/
+MZ_VecBatch MZ_alloc_vec_batch(size_t count, size_t dim);
+
+/*!
+    @brief Free the batch and sets its dimensions to 0.
+    @param batch The batch to free.
+*/
+void MZ_free_vec_batch(MZ_VecBatch* batch);
+
+/*!
+    @brief Gather an array of vectors in a new batch.
+    @param vectors The vectors, all of the same dimension.
+    @param count The number of vectors.
+    @return The new batch.
+*/
+MZ_VecBatch MZ_vectors_to_batch(const MZ_Vec* vectors, size_t count);
+
+/*!
+    @brief Scatter a batch in an array of new vectors.
+    @param batch The batch to convert.
+    @param vectors The array that receives the batch.count new vectors.
+*/
+void MZ_batch_to_vectors(MZ_VecBatch batch, MZ_Vec* vectors);
+
+/*!
+    @brief Copy one vector of the batch in a new vector.
+    @param batch The batch.
+    @param index The index of the vector in the batch.
+    @return The new vector.
+*/
+MZ_Vec MZ_get_vector_from_batch(MZ_VecBatch batch, size_t index);
+
+/*!
+    @brief Overwrite one vector of the batch.
+    @param batch The batch.
+    @param index The index of the vector in the batch.
+    @param vector The vector to store, of the dimension of the batch.
+*/
+void MZ_set_vector_in_batch(MZ_VecBatch* batch, size_t index, MZ_Vec vector);
+
+/*!
+    @brief Sum two batches vector by vector.
+    @param batch1
+    @param batch2
+    @return The batch of the sums.
+*/
+MZ_VecBatch MZ_add_two_vec_batches(MZ_VecBatch batch1, MZ_VecBatch batch2);
+
+/*!
+    @brief Sum two batches vector by vector into a destination batch.
+    @param dest The destination batch, of the same dimensions as the operands.
+    @param batch1
+    @param batch2
+*/
+void MZ_add_two_vec_batches_into(MZ_VecBatch* dest, MZ_VecBatch batch1, MZ_VecBatch batch2);
+
+/*!
+    @brief Subtract two batches vector by vector.
+    @param batch1
+    @param batch2
+    @return The batch of the differences.
+*/
+MZ_VecBatch MZ_subtract_two_vec_batches(MZ_VecBatch batch1, MZ_VecBatch batch2);
+
+/*!
+    @brief Subtract two batches vector by vector into a destination batch.
+    @param dest The destination batch, of the same dimensions as the operands.
+    @param batch1
+    @param batch2
+*/
+void MZ_subtract_two_vec_batches_into(MZ_VecBatch* dest, MZ_VecBatch batch1, MZ_VecBatch batch2);
+
+/*!
+    @brief Multiply every vector of a batch by a scalar.
+    @param batch
+    @param scalar
+    @return The scaled batch.
+*/
+MZ_VecBatch MZ_multiply_vec_batch_by_scalar(MZ_VecBatch batch, float scalar);
+
+/*!
+    @brief Multiply every vector of a batch by a scalar into a destination batch.
+    @param dest The destination batch, of the same dimensions as the operand.
+    @param batch
+    @param scalar
+*/
+void MZ_multiply_vec_batch_by_scalar_into(MZ_VecBatch* dest, MZ_VecBatch batch, float scalar);
+
+/*!
+    @brief The dot products of two batches, vector by vector.
+    @param batch1
+    @param batch2
+    @return A vector of batch1.count dimensions with the dot product of every pair.
+*/
+MZ_Vec MZ_dot_two_vec_batches(MZ_VecBatch batch1, MZ_VecBatch batch2);
+
+/*!
+    @brief The dot products of two batches, vector by vector, into a destination vector.
+    @param dest The destination vector, of batch1.count dimensions.
+    @param batch1
+    @param batch2
+*/
+void MZ_dot_two_vec_batches_into(MZ_Vec* dest, MZ_VecBatch batch1, MZ_VecBatch batch2);
+
+/*!
+    @brief The cross products of two batches of three dimensional vectors, vector by vector.
+    @param batch1
+    @param batch2
+    @return The batch of the cross products, or a NULL_VEC_BATCH if the vectors are not three dimensional.
+*/
+MZ_VecBatch MZ_cross_product_vec_batches(MZ_VecBatch batch1, MZ_VecBatch batch2);
+
+/*!
+    @brief The cross products of two batches of three dimensional vectors into a destination batch.
+    @param dest The destination batch, of the same dimensions as the operands.
+    @param batch1
+    @param batch2
+    @return false if the vectors are not three dimensional.
+*/
+bool MZ_cross_product_vec_batches_into(MZ_VecBatch* dest, MZ_VecBatch batch1, MZ_VecBatch batch2);
+
+/*!
+    @brief The magnitude of every vector of a batch.
+    @param batch
+    @return A vector of batch.count dimensions with the magnitude of every vector.
+*/
+MZ_Vec MZ_magnitude_of_vec_batch(MZ_VecBatch batch);
+
+/*!
+    @brief The magnitude of every vector of a batch into a destination vector.
+    @param dest The destination vector, of batch.count dimensions.
+    @param batch
+*/
+void MZ_magnitude_of_vec_batch_into(MZ_Vec* dest, MZ_VecBatch batch);
+
+/*!
+    @brief Normalize every vector of a batch.
+    @param batch
+    @return The batch of the normalized vectors.
+*/
+MZ_VecBatch MZ_normalized_vec_batch(MZ_VecBatch batch);
+
+/*!
+    @brief Normalize every vector of a batch into a destination batch.
+    @param dest The destination batch, of the same dimensions as the operand.
+    @param batch
+*/
+void MZ_normalized_vec_batch_into(MZ_VecBatch* dest, MZ_VecBatch batch);
+
+/*!
+    @brief Apply a transform to a buffer of three dimensional points, in place.
+    @param transform A 3x4 affine transform or a 4x4 one, the points are taken with w = 1.
+    When the last row of a 4x4 transform is not (0, 0, 0, 1) the results are divided by their w.
+    @param points The points, count x, y, z triples one after the other.
+    @param count The number of points.
+*/
+void MZ_transform_points(MZ_Matrix transform, float* points, size_t count);
+
+/*!
+    @brief Apply a transform to a buffer of three dimensional points into a destination buffer.
+    @param dest The destination buffer of count x, y, z triples. It may be the source buffer.
+    @param transform A 3x4 affine transform or a 4x4 one, the points are taken with w = 1.
+    When the last row of a 4x4 transform is not (0, 0, 0, 1) the results are divided by their w.
+    @param points The points, count x, y, z triples one after the other.
+    @param count The number of points.
+*/
+void MZ_transform_points_into(float* dest, MZ_Matrix transform, const float* points, size_t count);
+
+#endif // ZMATH_H
+
+#ifdef ZMATH_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define _MZ_X86_DISPATCH 1
+#include <immintrin.h>
+#else
+#define _MZ_X86_DISPATCH 0
+#endif
+
+#if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
+#include <unistd.h>
+#include <pthread.h>
+#elif _WIN32
+#include <process.h>
+#include <windows.h>
+#endif 
+
+#if defined(_MSC_VER)
+#define MZ_THREAD_LOCAL __declspec(thread)
+#else
+#define MZ_THREAD_LOCAL _Thread_local
+#endif
+
+#if VISUALIZE_RATIONAL
+#define ZSTRING_IMPLEMENTATION
+#include "zstring.h"
+#else 
+#include <string.h> 
+#endif
+
+static void _MZ_lu_substitute(MZ_LU lu, float* x, size_t ldx, unsigned int nrhs);
+static bool _MZ_try_cholesky(MZ_Matrix source, MZ_Cholesky* cholesky);
+static void _MZ_cholesky_substitute(MZ_Cholesky cholesky, float* x, size_t ldx, unsigned int nrhs);
+
+/*
+*/
+void _MZ_assert(bool condition, const char* message, const char* filepath, size_t line){
+    if(!condition){
+        fprintf(stderr, "\n[ERROR] : %s:%zu > %s\n", filepath, line, message);
+        #if EXIT_ON_ASSERT_FAILURE 
+            exit(EXIT_FAILURE);
+        #endif
+    }
+}
+
+/*
+*/
+float MZ_rand_float( float min, float max ){
+    float scale = rand() / (float) RAND_MAX; 
+    return min + scale * ( max - min );      
+}
+
+/*!
+*/
+int MZ_rand_int( int min, int max ){
+    return (rand() % (max - min)) + min;
+}
+
+/*
+*/
+void MZ_swap_int(int* a, int* b){
 
     int* tmp = a;
     a = b;
@@ -992,951 +2430,6032 @@ void MZ_print_value(FILE* fp, const char* label, const char* name_of_value, floa
 
 /*
 */
-bool MZ_is_in_array(unsigned int *arr, int n, float target){
-    for (int i = 0; i < n; i++){
-        if (arr[i] == target)
-        {
-            return true;
-        }
+bool MZ_is_in_array(unsigned int *arr, int n, float target){
+    for (int i = 0; i < n; i++){
+        if (arr[i] == target)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void _MZ_SRAND(unsigned int _Seed){
+    #if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
+        srand((_Seed * getpid()); 
+    #elif _WIN32
+        srand(_Seed * _getpid()); 
+    #endif   
+}
+
+/*
+    Thread pool: the workers are created the first time a kernel has enough work to split, and each
+    call hands out task indices to them while the calling thread takes its share of the tasks too.
+*/
+#if defined(_WIN32)
+typedef HANDLE _MZ_thread;
+typedef SRWLOCK _MZ_mutex;
+typedef CONDITION_VARIABLE _MZ_cond;
+#define _MZ_MUTEX_INIT SRWLOCK_INIT
+#define _MZ_COND_INIT CONDITION_VARIABLE_INIT
+#define _MZ_mutex_lock(m) AcquireSRWLockExclusive(m)
+#define _MZ_mutex_try_lock(m) (TryAcquireSRWLockExclusive(m) != 0)
+#define _MZ_mutex_unlock(m) ReleaseSRWLockExclusive(m)
+#define _MZ_cond_wait(c, m) SleepConditionVariableSRW(c, m, INFINITE, 0)
+#define _MZ_cond_signal(c) WakeConditionVariable(c)
+#define _MZ_cond_broadcast(c) WakeAllConditionVariable(c)
+#else
+typedef pthread_t _MZ_thread;
+typedef pthread_mutex_t _MZ_mutex;
+typedef pthread_cond_t _MZ_cond;
+#define _MZ_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+#define _MZ_COND_INIT PTHREAD_COND_INITIALIZER
+#define _MZ_mutex_lock(m) pthread_mutex_lock(m)
+#define _MZ_mutex_try_lock(m) (pthread_mutex_trylock(m) == 0)
+#define _MZ_mutex_unlock(m) pthread_mutex_unlock(m)
+#define _MZ_cond_wait(c, m) pthread_cond_wait(c, m)
+#define _MZ_cond_signal(c) pthread_cond_signal(c)
+#define _MZ_cond_broadcast(c) pthread_cond_broadcast(c)
+#endif
+
+typedef void (*_MZ_TaskFn)(void* ctx, unsigned int task, unsigned int tasks);
+
+typedef struct _MZ_ThreadPool{
+    _MZ_mutex dispatch;
+    _MZ_mutex lock;
+    _MZ_cond wake;
+    _MZ_cond done;
+    unsigned int requested;
+    unsigned int size;
+    unsigned int started;
+    _MZ_thread* workers;
+    unsigned long generation;
+    bool shutdown;
+    _MZ_TaskFn fn;
+    void* ctx;
+    unsigned int tasks;
+    unsigned int next;
+    unsigned int finished;
+}_MZ_ThreadPool;
+
+static _MZ_ThreadPool _MZ_pool = { _MZ_MUTEX_INIT, _MZ_MUTEX_INIT, _MZ_COND_INIT, _MZ_COND_INIT, 0, 0, 0, NULL, 0, false, NULL, NULL, 0, 0, 0 };
+
+static MZ_THREAD_LOCAL bool _MZ_inside_pool = false;
+
+/*
+    Runs the pending tasks of the current job, must be called with the pool lock held.
+*/
+static void _MZ_pool_run_tasks(void){
+
+    while(_MZ_pool.next < _MZ_pool.tasks){
+        unsigned int task = _MZ_pool.next++;
+        unsigned int tasks = _MZ_pool.tasks;
+        _MZ_TaskFn fn = _MZ_pool.fn;
+        void* ctx = _MZ_pool.ctx;
+
+        _MZ_mutex_unlock(&_MZ_pool.lock);
+        fn(ctx, task, tasks);
+        _MZ_mutex_lock(&_MZ_pool.lock);
+
+        if(++_MZ_pool.finished == _MZ_pool.tasks){
+            _MZ_cond_signal(&_MZ_pool.done);
+        }
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI _MZ_worker_main(LPVOID arg){
+#else
+static void* _MZ_worker_main(void* arg){
+#endif
+
+    (void)arg;
+    _MZ_inside_pool = true;
+
+    _MZ_mutex_lock(&_MZ_pool.lock);
+
+    unsigned long seen = _MZ_pool.generation;
+
+    for(;;){
+        while(!_MZ_pool.shutdown && _MZ_pool.generation == seen){
+            _MZ_cond_wait(&_MZ_pool.wake, &_MZ_pool.lock);
+        }
+        if(_MZ_pool.shutdown) break;
+
+        seen = _MZ_pool.generation;
+        _MZ_pool_run_tasks();
+    }
+
+    _MZ_mutex_unlock(&_MZ_pool.lock);
+
+    return 0;
+}
+
+/*
+    Resolves the size of the pool: MZ_set_num_threads, then ZMATH_NUM_THREADS, then the number of cores.
+    Any thread can ask for it while MZ_set_num_threads resets it, so it is read and written under the lock.
+*/
+static unsigned int _MZ_pool_size(void){
+
+    _MZ_mutex_lock(&_MZ_pool.lock);
+
+    if(_MZ_pool.size != 0){
+        unsigned int size = _MZ_pool.size;
+        _MZ_mutex_unlock(&_MZ_pool.lock);
+        return size;
+    }
+
+    unsigned int size = _MZ_pool.requested;
+
+    if(size == 0){
+        const char* env = getenv("ZMATH_NUM_THREADS");
+        if(env != NULL && atoi(env) > 0) size = (unsigned int)atoi(env);
+    }
+
+    if(size == 0){
+        #if defined(_WIN32)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        size = (unsigned int)info.dwNumberOfProcessors;
+        #elif defined(_SC_NPROCESSORS_ONLN)
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        size = cores > 0 ? (unsigned int)cores : 1;
+        #endif
+    }
+
+    size = size == 0 ? 1 : size;
+    _MZ_pool.size = size;
+
+    _MZ_mutex_unlock(&_MZ_pool.lock);
+
+    return size;
+}
+
+/*
+    Creates the workers, must be called with the dispatch lock held.
+*/
+static void _MZ_pool_start(void){
+
+    unsigned int size = _MZ_pool_size();
+
+    if(_MZ_pool.started == size) return;
+
+    // the pool outlives any allocator installed by the user, so it stays on the C runtime
+    _MZ_pool.workers = (_MZ_thread*)calloc(size - 1, sizeof(_MZ_thread));
+    MZ_assert(_MZ_pool.workers != NULL, MZ_ALLOC_ERROR);
+
+    for(unsigned int i = 0; i < size - 1; i++){
+        #if defined(_WIN32)
+        _MZ_pool.workers[i] = CreateThread(NULL, 0, _MZ_worker_main, NULL, 0, NULL);
+        MZ_assert(_MZ_pool.workers[i] != NULL, "Could not create a worker thread.");
+        #else
+        int error = pthread_create(&_MZ_pool.workers[i], NULL, _MZ_worker_main, NULL);
+        MZ_assert(error == 0, "Could not create a worker thread.");
+        #endif
+    }
+
+    _MZ_pool.started = size;
+}
+
+/*
+    Joins the workers, must be called with the dispatch lock held.
+*/
+static void _MZ_pool_stop(void){
+
+    if(_MZ_pool.started == 0) return;
+
+    _MZ_mutex_lock(&_MZ_pool.lock);
+    _MZ_pool.shutdown = true;
+    _MZ_cond_broadcast(&_MZ_pool.wake);
+    _MZ_mutex_unlock(&_MZ_pool.lock);
+
+    for(unsigned int i = 0; i + 1 < _MZ_pool.started; i++){
+        #if defined(_WIN32)
+        WaitForSingleObject(_MZ_pool.workers[i], INFINITE);
+        CloseHandle(_MZ_pool.workers[i]);
+        #else
+        pthread_join(_MZ_pool.workers[i], NULL);
+        #endif
+    }
+
+    free(_MZ_pool.workers);
+    _MZ_pool.workers = NULL;
+    _MZ_pool.started = 0;
+    _MZ_pool.shutdown = false;
+}
+
+/*
+    Gives the number of tasks worth creating for an amount of work, each task getting at least grain of it.
+*/
+static unsigned int _MZ_parallel_tasks(size_t work, size_t grain){
+
+    size_t tasks = grain == 0 ? work : work / grain;
+    size_t size = _MZ_pool_size();
+
+    if(tasks > size) tasks = size;
+    if(tasks < 1) tasks = 1;
+
+    return (unsigned int)tasks;
+}
+
+/*
+    Runs fn(ctx, task, tasks) for every task in [0, tasks), on the pool when it is free and inline otherwise.
+*/
+static void _MZ_parallel_run(unsigned int tasks, _MZ_TaskFn fn, void* ctx){
+
+    if(tasks <= 1 || _MZ_inside_pool || !_MZ_mutex_try_lock(&_MZ_pool.dispatch)){
+        for(unsigned int task = 0; task < tasks; task++){
+            fn(ctx, task, tasks);
+        }
+        return;
+    }
+
+    _MZ_pool_start();
+
+    _MZ_mutex_lock(&_MZ_pool.lock);
+
+    _MZ_pool.fn = fn;
+    _MZ_pool.ctx = ctx;
+    _MZ_pool.tasks = tasks;
+    _MZ_pool.next = 0;
+    _MZ_pool.finished = 0;
+    _MZ_pool.generation++;
+    _MZ_cond_broadcast(&_MZ_pool.wake);
+
+    _MZ_inside_pool = true;
+    _MZ_pool_run_tasks();
+    _MZ_inside_pool = false;
+
+    while(_MZ_pool.finished < _MZ_pool.tasks){
+        _MZ_cond_wait(&_MZ_pool.done, &_MZ_pool.lock);
+    }
+
+    _MZ_mutex_unlock(&_MZ_pool.lock);
+    _MZ_mutex_unlock(&_MZ_pool.dispatch);
+}
+
+typedef void (*_MZ_RangeFn)(void* ctx, size_t begin, size_t end);
+
+typedef struct _MZ_RangeJob{
+    _MZ_RangeFn fn;
+    void* ctx;
+    size_t count;
+}_MZ_RangeJob;
+
+static void _MZ_range_task(void* ctx, unsigned int task, unsigned int tasks){
+
+    _MZ_RangeJob* job = (_MZ_RangeJob*)ctx;
+
+    size_t begin = job->count * task / tasks;
+    size_t end = job->count * (task + 1) / tasks;
+
+    if(begin < end) job->fn(job->ctx, begin, end);
+}
+
+/*
+    Splits [0, count) in contiguous ranges of at least grain items and runs fn on each of them.
+*/
+static void _MZ_parallel_for(size_t count, size_t grain, _MZ_RangeFn fn, void* ctx){
+
+    unsigned int tasks = _MZ_parallel_tasks(count, grain);
+
+    if(tasks <= 1){
+        if(count > 0) fn(ctx, 0, count);
+        return;
+    }
+
+    _MZ_RangeJob job = { fn, ctx, count };
+    _MZ_parallel_run(tasks, _MZ_range_task, &job);
+}
+
+/*
+*/
+void MZ_set_num_threads(unsigned int num_threads){
+
+    _MZ_mutex_lock(&_MZ_pool.dispatch);
+
+    _MZ_pool_stop();
+
+    _MZ_mutex_lock(&_MZ_pool.lock);
+    _MZ_pool.requested = num_threads;
+    _MZ_pool.size = 0;
+    _MZ_mutex_unlock(&_MZ_pool.lock);
+
+    _MZ_mutex_unlock(&_MZ_pool.dispatch);
+}
+
+/*
+*/
+unsigned int MZ_get_num_threads(void){
+    return _MZ_pool_size();
+}
+
+/*
+    Allocators, the thread one wins over the global one when installed.
+*/
+static void* _MZ_default_alloc(void* user, size_t size){
+    (void)user;
+    return calloc(1, size == 0 ? 1 : size);
+}
+
+static void* _MZ_default_realloc(void* user, void* ptr, size_t old_size, size_t new_size){
+    (void)user;
+    (void)old_size;
+    return realloc(ptr, new_size == 0 ? 1 : new_size);
+}
+
+static void _MZ_default_free(void* user, void* ptr, size_t size){
+    (void)user;
+    (void)size;
+    free(ptr);
+}
+
+static MZ_Allocator _MZ_global_allocator = { _MZ_default_alloc, _MZ_default_realloc, _MZ_default_free, NULL };
+static MZ_THREAD_LOCAL MZ_Allocator _MZ_thread_allocator = { NULL, NULL, NULL, NULL };
+
+static inline const MZ_Allocator* _MZ_current_allocator(void){
+    return _MZ_thread_allocator.alloc != NULL ? &_MZ_thread_allocator : &_MZ_global_allocator;
+}
+
+/*
+*/
+MZ_Allocator MZ_default_allocator(void){
+    MZ_Allocator result = { _MZ_default_alloc, _MZ_default_realloc, _MZ_default_free, NULL };
+    return result;
+}
+
+/*
+*/
+void MZ_set_allocator(const MZ_Allocator* allocator){
+
+    if(allocator == NULL){
+        _MZ_global_allocator = MZ_default_allocator();
+        return;
+    }
+
+    MZ_assert(allocator->alloc != NULL && allocator->realloc != NULL && allocator->free != NULL, "Allocator functions must not be NULL.");
+
+    _MZ_global_allocator = *allocator;
+}
+
+/*
+*/
+void MZ_set_thread_allocator(const MZ_Allocator* allocator){
+
+    if(allocator == NULL){
+        MZ_Allocator none = { NULL, NULL, NULL, NULL };
+        _MZ_thread_allocator = none;
+        return;
+    }
+
+    MZ_assert(allocator->alloc != NULL && allocator->realloc != NULL && allocator->free != NULL, "Allocator functions must not be NULL.");
+
+    _MZ_thread_allocator = *allocator;
+}
+
+/*
+*/
+MZ_Allocator MZ_get_allocator(void){
+    return *_MZ_current_allocator();
+}
+
+/*
+    Every chunk handed out by _MZ_alloc starts on a cache line: the allocator is asked for
+    _MZ_ALIGNMENT more bytes and the distance back to what it returned is kept in the byte
+    just before the chunk.
+*/
+#define _MZ_ALIGNMENT 64
+
+static inline unsigned char* _MZ_align_chunk(unsigned char* base){
+
+    size_t offset = _MZ_ALIGNMENT - (size_t)((uintptr_t)base & (_MZ_ALIGNMENT - 1));
+
+    unsigned char* result = base + offset;
+    result[-1] = (unsigned char)offset;
+
+    return result;
+}
+
+/*
+*/
+void* _MZ_alloc(size_t size){
+
+    const MZ_Allocator* allocator = _MZ_current_allocator();
+
+    unsigned char* base = (unsigned char*)allocator->alloc(allocator->user, size + _MZ_ALIGNMENT);
+
+    if(base == NULL) return NULL;
+
+    unsigned char* result = _MZ_align_chunk(base);
+
+    // calloc already hands out zeroed pages, anything else is cleared here
+    if(allocator->alloc != _MZ_default_alloc){
+        memset(result, 0, size);
+    }
+
+    return result;
+}
+
+/*
+*/
+void* _MZ_realloc(void* ptr, size_t old_size, size_t new_size){
+
+    if(ptr == NULL) return _MZ_alloc(new_size);
+
+    const MZ_Allocator* allocator = _MZ_current_allocator();
+
+    size_t oldOffset = ((unsigned char*)ptr)[-1];
+
+    unsigned char* base = (unsigned char*)allocator->realloc(allocator->user, (unsigned char*)ptr - oldOffset, old_size + _MZ_ALIGNMENT, new_size + _MZ_ALIGNMENT);
+
+    if(base == NULL) return NULL;
+
+    unsigned char* result = _MZ_align_chunk(base);
+
+    // the allocator may have moved the chunk to an address with a different misalignment
+    if((size_t)(result - base) != oldOffset){
+        memmove(result, base + oldOffset, old_size < new_size ? old_size : new_size);
+        result[-1] = (unsigned char)(result - base);
+    }
+
+    if(new_size > old_size){
+        memset(result + old_size, 0, new_size - old_size);
+    }
+
+    return result;
+}
+
+/*
+*/
+void _MZ_free(void* ptr, size_t size){
+
+    if(ptr == NULL) return;
+
+    const MZ_Allocator* allocator = _MZ_current_allocator();
+
+    size_t offset = ((unsigned char*)ptr)[-1];
+
+    allocator->free(allocator->user, (unsigned char*)ptr - offset, size + _MZ_ALIGNMENT);
+}
+
+/*
+    Arenas, a chain of blocks each bumped from the front. Popping moves back to an older
+    block and keeps the newer ones in the chain to be reused by the next allocations.
+*/
+#define _MZ_ARENA_DEFAULT_BLOCK (1024 * 1024)
+
+typedef struct _MZ_ArenaBlock{
+    struct _MZ_ArenaBlock* prev;
+    struct _MZ_ArenaBlock* next;
+    size_t size;
+    size_t used;
+}_MZ_ArenaBlock;
+
+static inline unsigned char* _MZ_arena_block_data(_MZ_ArenaBlock* block){
+    return (unsigned char*)(block + 1);
+}
+
+// offset of the next allocation in the block once aligned, or SIZE_MAX if size does not fit
+static inline size_t _MZ_arena_block_fit(_MZ_ArenaBlock* block, size_t size){
+
+    uintptr_t base = (uintptr_t)_MZ_arena_block_data(block);
+    size_t offset = (size_t)(((base + block->used + _MZ_ALIGNMENT - 1) & ~(uintptr_t)(_MZ_ALIGNMENT - 1)) - base);
+
+    return offset <= block->size && size <= block->size - offset ? offset : SIZE_MAX;
+}
+
+/*
+*/
+MZ_Arena MZ_new_arena(size_t block_size){
+
+    MZ_Arena result;
+    result.first = NULL;
+    result.current = NULL;
+    result.block_size = block_size == 0 ? _MZ_ARENA_DEFAULT_BLOCK : block_size;
+    result.backing = MZ_get_allocator();
+
+    return result;
+}
+
+/*
+*/
+void MZ_free_arena(MZ_Arena* arena){
+
+    MZ_assert(arena != NULL, "Arena must not be NULL.");
+
+    _MZ_ArenaBlock* block = arena->first;
+
+    while(block != NULL){
+        _MZ_ArenaBlock* next = block->next;
+        arena->backing.free(arena->backing.user, block, sizeof(_MZ_ArenaBlock) + block->size);
+        block = next;
+    }
+
+    arena->first = NULL;
+    arena->current = NULL;
+}
+
+/*
+*/
+void* MZ_arena_alloc(MZ_Arena* arena, size_t size){
+
+    _MZ_ArenaBlock* block = arena->current;
+    size_t offset;
+
+    if(block != NULL && (offset = _MZ_arena_block_fit(block, size)) != SIZE_MAX){
+        block->used = offset + size;
+        return _MZ_arena_block_data(block) + offset;
+    }
+
+    // reuse the block left behind by a pop when it is big enough
+    _MZ_ArenaBlock* next = block != NULL ? block->next : arena->first;
+
+    if(next != NULL){
+        next->used = 0;
+        if((offset = _MZ_arena_block_fit(next, size)) != SIZE_MAX){
+            arena->current = next;
+            next->used = offset + size;
+            return _MZ_arena_block_data(next) + offset;
+        }
+    }
+
+    size_t blockSize = size + _MZ_ALIGNMENT > arena->block_size ? size + _MZ_ALIGNMENT : arena->block_size;
+
+    _MZ_ArenaBlock* fresh = (_MZ_ArenaBlock*)arena->backing.alloc(arena->backing.user, sizeof(_MZ_ArenaBlock) + blockSize);
+
+    if(fresh == NULL) return NULL;
+
+    // the new block goes right after the current one, the reusable ones stay behind it
+    fresh->size = blockSize;
+    fresh->used = 0;
+    fresh->prev = block;
+    fresh->next = next;
+
+    if(next != NULL) next->prev = fresh;
+    if(block != NULL) block->next = fresh;
+    else arena->first = fresh;
+
+    arena->current = fresh;
+
+    offset = _MZ_arena_block_fit(fresh, size);
+    fresh->used = offset + size;
+
+    return _MZ_arena_block_data(fresh) + offset;
+}
+
+/*
+*/
+MZ_ArenaMarker MZ_arena_push(MZ_Arena* arena){
+
+    MZ_ArenaMarker result;
+    result.block = arena->current;
+    result.used = arena->current != NULL ? arena->current->used : 0;
+
+    return result;
+}
+
+/*
+*/
+void MZ_arena_pop(MZ_Arena* arena, MZ_ArenaMarker marker){
+
+    if(marker.block == NULL){
+        // pushed while the arena was still empty, go back to the start of the chain
+        arena->current = NULL;
+        return;
+    }
+
+    arena->current = marker.block;
+    marker.block->used = marker.used;
+}
+
+static void* _MZ_arena_allocator_alloc(void* user, size_t size){
+    return MZ_arena_alloc((MZ_Arena*)user, size);
+}
+
+static void* _MZ_arena_allocator_realloc(void* user, void* ptr, size_t old_size, size_t new_size){
+
+    MZ_Arena* arena = (MZ_Arena*)user;
+    _MZ_ArenaBlock* block = arena->current;
+
+    // the last allocation can grow or shrink in place
+    if(ptr != NULL && block != NULL && (unsigned char*)ptr + old_size == _MZ_arena_block_data(block) + block->used){
+        size_t offset = (size_t)((unsigned char*)ptr - _MZ_arena_block_data(block));
+        if(new_size <= block->size - offset){
+            block->used = offset + new_size;
+            return ptr;
+        }
+    }
+
+    void* result = MZ_arena_alloc(arena, new_size);
+
+    if(result != NULL && ptr != NULL){
+        memcpy(result, ptr, old_size < new_size ? old_size : new_size);
+    }
+
+    return result;
+}
+
+static void _MZ_arena_allocator_free(void* user, void* ptr, size_t size){
+
+    MZ_Arena* arena = (MZ_Arena*)user;
+    _MZ_ArenaBlock* block = arena->current;
+
+    // only the last allocation can be given back, the rest goes away with MZ_arena_pop
+    if(ptr != NULL && block != NULL && (unsigned char*)ptr + size == _MZ_arena_block_data(block) + block->used){
+        block->used = (size_t)((unsigned char*)ptr - _MZ_arena_block_data(block));
+    }
+}
+
+/*
+*/
+MZ_Allocator MZ_arena_allocator(MZ_Arena* arena){
+    MZ_Allocator result = { _MZ_arena_allocator_alloc, _MZ_arena_allocator_realloc, _MZ_arena_allocator_free, arena };
+    return result;
+}
+
+/*
+    Scratch arena of each thread for the temporaries of the library. Between begin and end it is
+    installed as the thread allocator, so nothing allocated in between may be returned to the user.
+*/
+static MZ_THREAD_LOCAL MZ_Arena _MZ_scratch_arena = { NULL, NULL, 0, { NULL, NULL, NULL, NULL } };
+
+typedef struct _MZ_Scratch{
+    MZ_ArenaMarker marker;
+    MZ_Allocator previous;
+}_MZ_Scratch;
+
+static _MZ_Scratch _MZ_scratch_begin(void){
+
+    if(_MZ_scratch_arena.block_size == 0){
+        // blocks come from the global allocator, a thread allocator may be an arena popped under our feet
+        _MZ_scratch_arena.block_size = _MZ_ARENA_DEFAULT_BLOCK;
+        _MZ_scratch_arena.backing = _MZ_global_allocator;
+    }
+
+    _MZ_Scratch result;
+    result.marker = MZ_arena_push(&_MZ_scratch_arena);
+    result.previous = _MZ_thread_allocator;
+
+    _MZ_thread_allocator = MZ_arena_allocator(&_MZ_scratch_arena);
+
+    return result;
+}
+
+static void _MZ_scratch_end(_MZ_Scratch scratch){
+    _MZ_thread_allocator = scratch.previous;
+    MZ_arena_pop(&_MZ_scratch_arena, scratch.marker);
+}
+
+/*
+*/
+void MZ_free_thread_scratch(void){
+
+    if(_MZ_scratch_arena.block_size == 0) return;
+
+    MZ_free_arena(&_MZ_scratch_arena);
+    _MZ_scratch_arena.block_size = 0;
+}
+
+/*
+    Elementwise kernels shared by the vector and matrix operations.
+*/
+typedef enum _MZ_ElementOp{
+    _MZ_OP_ADD,
+    _MZ_OP_SUB,
+    _MZ_OP_MUL,
+    _MZ_OP_DIV,
+    _MZ_OP_SAFE_DIV,
+}_MZ_ElementOp;
+
+typedef struct _MZ_ElementJob{
+    float* dest;
+    const float* a;
+    const float* b;
+    float scalar;
+    _MZ_ElementOp op;
+}_MZ_ElementJob;
+
+typedef void (*_MZ_ElementKernel)(float* dest, const float* a, const float* b, float s, size_t n, _MZ_ElementOp op);
+
+static void _MZ_element_kernel_scalar(float* dest, const float* a, const float* b, float s, size_t n, _MZ_ElementOp op){
+
+    if(b != NULL){
+        switch(op){
+            case _MZ_OP_ADD: for(size_t i = 0; i < n; i++) dest[i] = a[i] + b[i]; break;
+            case _MZ_OP_SUB: for(size_t i = 0; i < n; i++) dest[i] = a[i] - b[i]; break;
+            case _MZ_OP_MUL: for(size_t i = 0; i < n; i++) dest[i] = a[i] * b[i]; break;
+            case _MZ_OP_DIV: for(size_t i = 0; i < n; i++) dest[i] = a[i] / b[i]; break;
+            case _MZ_OP_SAFE_DIV: for(size_t i = 0; i < n; i++) dest[i] = b[i] != 0.0f ? a[i] / b[i] : 0.0f; break;
+        }
+    }else {
+        switch(op){
+            case _MZ_OP_ADD: for(size_t i = 0; i < n; i++) dest[i] = a[i] + s; break;
+            case _MZ_OP_SUB: for(size_t i = 0; i < n; i++) dest[i] = a[i] - s; break;
+            case _MZ_OP_MUL: for(size_t i = 0; i < n; i++) dest[i] = a[i] * s; break;
+            case _MZ_OP_DIV: for(size_t i = 0; i < n; i++) dest[i] = a[i] / s; break;
+            case _MZ_OP_SAFE_DIV: for(size_t i = 0; i < n; i++) dest[i] = s != 0.0f ? a[i] / s : 0.0f; break;
+        }
+    }
+}
+
+#if _MZ_X86_DISPATCH
+
+/*
+    One loop per operation, the second operand is either loaded or the broadcast scalar.
+    The tail is finished with masked loads and stores where the instruction set has them,
+    SSE2 does not so it falls back to the scalar kernel for the last 3 elements at most.
+*/
+#define _MZ_ELEMENT_LOOPS(STEP, LOOP)                                                            \
+    switch(op){                                                                                  \
+        case _MZ_OP_ADD: LOOP(STEP##_ADD); break;                                                \
+        case _MZ_OP_SUB: LOOP(STEP##_SUB); break;                                                \
+        case _MZ_OP_MUL: LOOP(STEP##_MUL); break;                                                \
+        case _MZ_OP_DIV: LOOP(STEP##_DIV); break;                                                \
+        case _MZ_OP_SAFE_DIV: LOOP(STEP##_SAFE_DIV); break;                                      \
+    }
+
+#define _MZ_SSE2_ADD(x, y) _mm_add_ps(x, y)
+#define _MZ_SSE2_SUB(x, y) _mm_sub_ps(x, y)
+#define _MZ_SSE2_MUL(x, y) _mm_mul_ps(x, y)
+#define _MZ_SSE2_DIV(x, y) _mm_div_ps(x, y)
+#define _MZ_SSE2_SAFE_DIV(x, y) _mm_and_ps(_mm_div_ps(x, y), _mm_cmpneq_ps(y, _mm_setzero_ps()))
+
+#define _MZ_SSE2_LOOP(OP)                                                                        \
+    for(; i + 4 <= n; i += 4){                                                                   \
+        __m128 va = _mm_loadu_ps(a + i);                                                         \
+        __m128 vb = b != NULL ? _mm_loadu_ps(b + i) : vs;                                        \
+        _mm_storeu_ps(dest + i, OP(va, vb));                                                     \
+    }
+
+__attribute__((target("sse2")))
+static void _MZ_element_kernel_sse2(float* dest, const float* a, const float* b, float s, size_t n, _MZ_ElementOp op){
+
+    __m128 vs = _mm_set1_ps(s);
+    size_t i = 0;
+
+    _MZ_ELEMENT_LOOPS(_MZ_SSE2, _MZ_SSE2_LOOP)
+
+    if(i < n){
+        _MZ_element_kernel_scalar(dest + i, a + i, b != NULL ? b + i : NULL, s, n - i, op);
+    }
+}
+
+#define _MZ_AVX2_ADD(x, y) _mm256_add_ps(x, y)
+#define _MZ_AVX2_SUB(x, y) _mm256_sub_ps(x, y)
+#define _MZ_AVX2_MUL(x, y) _mm256_mul_ps(x, y)
+#define _MZ_AVX2_DIV(x, y) _mm256_div_ps(x, y)
+#define _MZ_AVX2_SAFE_DIV(x, y) _mm256_and_ps(_mm256_div_ps(x, y), _mm256_cmp_ps(y, _mm256_setzero_ps(), _CMP_NEQ_UQ))
+
+#define _MZ_AVX2_LOOP(OP)                                                                        \
+    for(; i + 8 <= n; i += 8){                                                                   \
+        __m256 va = _mm256_loadu_ps(a + i);                                                      \
+        __m256 vb = b != NULL ? _mm256_loadu_ps(b + i) : vs;                                     \
+        _mm256_storeu_ps(dest + i, OP(va, vb));                                                  \
+    }                                                                                            \
+    if(i < n){                                                                                   \
+        __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32((int)(n - i)),                       \
+                                          _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));            \
+        __m256 va = _mm256_maskload_ps(a + i, mask);                                             \
+        __m256 vb = b != NULL ? _mm256_maskload_ps(b + i, mask) : vs;                            \
+        _mm256_maskstore_ps(dest + i, mask, OP(va, vb));                                         \
+    }
+
+__attribute__((target("avx2")))
+static void _MZ_element_kernel_avx2(float* dest, const float* a, const float* b, float s, size_t n, _MZ_ElementOp op){
+
+    __m256 vs = _mm256_set1_ps(s);
+    size_t i = 0;
+
+    _MZ_ELEMENT_LOOPS(_MZ_AVX2, _MZ_AVX2_LOOP)
+}
+
+#define _MZ_AVX512_ADD(x, y) _mm512_add_ps(x, y)
+#define _MZ_AVX512_SUB(x, y) _mm512_sub_ps(x, y)
+#define _MZ_AVX512_MUL(x, y) _mm512_mul_ps(x, y)
+#define _MZ_AVX512_DIV(x, y) _mm512_div_ps(x, y)
+#define _MZ_AVX512_SAFE_DIV(x, y) _mm512_maskz_div_ps(_mm512_cmp_ps_mask(y, _mm512_setzero_ps(), _CMP_NEQ_UQ), x, y)
+
+#define _MZ_AVX512_LOOP(OP)                                                                      \
+    for(; i + 16 <= n; i += 16){                                                                 \
+        __m512 va = _mm512_loadu_ps(a + i);                                                      \
+        __m512 vb = b != NULL ? _mm512_loadu_ps(b + i) : vs;                                     \
+        _mm512_storeu_ps(dest + i, OP(va, vb));                                                  \
+    }                                                                                            \
+    if(i < n){                                                                                   \
+        __mmask16 mask = (__mmask16)((1u << (n - i)) - 1);                                       \
+        __m512 va = _mm512_maskz_loadu_ps(mask, a + i);                                          \
+        __m512 vb = b != NULL ? _mm512_maskz_loadu_ps(mask, b + i) : vs;                         \
+        _mm512_mask_storeu_ps(dest + i, mask, OP(va, vb));                                       \
+    }
+
+__attribute__((target("avx512f")))
+static void _MZ_element_kernel_avx512(float* dest, const float* a, const float* b, float s, size_t n, _MZ_ElementOp op){
+
+    __m512 vs = _mm512_set1_ps(s);
+    size_t i = 0;
+
+    _MZ_ELEMENT_LOOPS(_MZ_AVX512, _MZ_AVX512_LOOP)
+}
+
+static MZ_Isa _MZ_detect_isa(void){
+
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx512f")) return MZ_ISA_AVX512;
+    if(__builtin_cpu_supports("avx2")) return MZ_ISA_AVX2;
+    if(__builtin_cpu_supports("sse2")) return MZ_ISA_SSE2;
+
+    return MZ_ISA_SCALAR;
+}
+
+static const _MZ_ElementKernel _MZ_element_kernels[MZ_ISA_COUNT] = {
+    _MZ_element_kernel_scalar,
+    _MZ_element_kernel_scalar,
+    _MZ_element_kernel_sse2,
+    _MZ_element_kernel_avx2,
+    _MZ_element_kernel_avx512,
+};
+
+#else
+
+static MZ_Isa _MZ_detect_isa(void){
+    return MZ_ISA_SCALAR;
+}
+
+static const _MZ_ElementKernel _MZ_element_kernels[MZ_ISA_COUNT] = {
+    _MZ_element_kernel_scalar,
+    _MZ_element_kernel_scalar,
+    _MZ_element_kernel_scalar,
+    _MZ_element_kernel_scalar,
+    _MZ_element_kernel_scalar,
+};
+
+#endif // _MZ_X86_DISPATCH
+
+/*
+    The instruction set is picked once, before main when the compiler allows it.
+*/
+static MZ_Isa _MZ_supported_isa = MZ_ISA_AUTO;
+static MZ_Isa _MZ_isa = MZ_ISA_AUTO;
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((constructor))
+#endif
+static void _MZ_init_isa(void){
+
+    _MZ_supported_isa = _MZ_detect_isa();
+    _MZ_isa = _MZ_supported_isa;
+
+    const char* env = getenv("ZMATH_ISA");
+    if(env == NULL) return;
+
+    const char* names[MZ_ISA_COUNT] = { "auto", "scalar", "sse2", "avx2", "avx512" };
+
+    for(int i = 0; i < MZ_ISA_COUNT; i++){
+        if(strcmp(env, names[i]) == 0 && i != MZ_ISA_AUTO && (MZ_Isa)i <= _MZ_supported_isa){
+            _MZ_isa = (MZ_Isa)i;
+        }
+    }
+}
+
+static inline MZ_Isa _MZ_current_isa(void){
+
+    #if !defined(__GNUC__) && !defined(__clang__)
+    if(_MZ_isa == MZ_ISA_AUTO) _MZ_init_isa();
+    #endif
+
+    return _MZ_isa;
+}
+
+/*
+*/
+bool MZ_force_isa(MZ_Isa isa){
+
+    _MZ_current_isa();
+
+    if(isa == MZ_ISA_AUTO){
+        _MZ_isa = _MZ_supported_isa;
+        return true;
+    }
+
+    if(isa >= MZ_ISA_COUNT || isa > _MZ_supported_isa) return false;
+
+    _MZ_isa = isa;
+
+    return true;
+}
+
+/*
+*/
+MZ_Isa MZ_get_isa(void){
+    return _MZ_current_isa();
+}
+
+static void _MZ_elementwise_range(void* ctx, size_t begin, size_t end){
+
+    _MZ_ElementJob* job = (_MZ_ElementJob*)ctx;
+
+    _MZ_element_kernels[_MZ_current_isa()](job->dest + begin, job->a + begin, job->b != NULL ? job->b + begin : NULL, job->scalar, end - begin, job->op);
+}
+
+/*
+    dest[i] = a[i] op b[i], or dest[i] = a[i] op scalar when b is NULL.
+*/
+static void _MZ_elementwise(float* dest, const float* a, const float* b, float scalar, size_t n, _MZ_ElementOp op){
+
+    _MZ_ElementJob job = { dest, a, b, scalar, op };
+
+    _MZ_parallel_for(n, MZ_PARALLEL_THRESHOLD, _MZ_elementwise_range, &job);
+}
+
+static inline bool _MZ_is_matrix_packed(MZ_Matrix matrix){
+    return MZ_STRIDE_OF_MATRIX(matrix) == matrix.cols;
+}
+
+typedef struct _MZ_ElementRowsJob{
+    _MZ_ElementJob row;
+    size_t cols;
+    size_t ldd;
+    size_t lda;
+    size_t ldb;
+}_MZ_ElementRowsJob;
+
+static void _MZ_elementwise_rows(void* ctx, size_t begin, size_t end){
+
+    _MZ_ElementRowsJob* job = (_MZ_ElementRowsJob*)ctx;
+
+    for(size_t i = begin; i < end; i++){
+        _MZ_ElementJob row = job->row;
+        row.dest += i * job->ldd;
+        row.a += i * job->lda;
+        if(row.b != NULL) row.b += i * job->ldb;
+        _MZ_elementwise_range(&row, 0, job->cols);
+    }
+}
+
+// same as _MZ_elementwise on whole matrices, row by row when one of them has padded rows
+static void _MZ_elementwise_matrix(MZ_Matrix* dest, MZ_Matrix a, const MZ_Matrix* b, float scalar, _MZ_ElementOp op){
+
+    if(_MZ_is_matrix_packed(*dest) && _MZ_is_matrix_packed(a) && (b == NULL || _MZ_is_matrix_packed(*b))){
+        _MZ_elementwise(dest->elements, a.elements, b != NULL ? b->elements : NULL, scalar, (size_t)a.rows * a.cols, op);
+        return;
+    }
+
+    _MZ_ElementRowsJob job;
+    job.row.dest = dest->elements;
+    job.row.a = a.elements;
+    job.row.b = b != NULL ? b->elements : NULL;
+    job.row.scalar = scalar;
+    job.row.op = op;
+    job.cols = a.cols;
+    job.ldd = MZ_STRIDE_OF_MATRIX(*dest);
+    job.lda = MZ_STRIDE_OF_MATRIX(a);
+    job.ldb = b != NULL ? MZ_STRIDE_OF_MATRIX(*b) : 0;
+
+    _MZ_parallel_for(a.rows, MZ_PARALLEL_THRESHOLD / (a.cols == 0 ? 1 : a.cols) + 1, _MZ_elementwise_rows, &job);
+}
+
+/*
+    Reductions. The vector is cut in blocks of fixed size, each one reduced with several
+    independent accumulators, then the partial sums are added pairwise in a fixed order:
+    the result only depends on the instruction set and the summation mode, never on the
+    number of threads. The compensated kernels keep the rounding error of every sum (Kahan)
+    and, where FMA is available, of every product.
+*/
+#define _MZ_REDUCE_BLOCK 4096
+#define _MZ_REDUCE_STACK 64
+
+typedef double (*_MZ_DotKernel)(const float* a, const float* b, size_t n);
+
+static double _MZ_dot_kernel_scalar(const float* a, const float* b, size_t n){
+
+    float acc[8] = { 0.0f };
+    size_t i = 0;
+
+    for(; i + 8 <= n; i += 8){
+        for(int l = 0; l < 8; l++) acc[l] += a[i + l] * b[i + l];
+    }
+    for(; i < n; i++){
+        acc[i & 7] += a[i] * b[i];
+    }
+
+    return ((double)acc[0] + acc[1] + ((double)acc[2] + acc[3])) + ((double)acc[4] + acc[5] + ((double)acc[6] + acc[7]));
+}
+
+static double _MZ_dot_kernel_compensated_scalar(const float* a, const float* b, size_t n){
+
+    // the product of two floats is exact in double, only the sums need compensating
+    double sum = 0.0;
+    double c = 0.0;
+
+    for(size_t i = 0; i < n; i++){
+        double y = (double)a[i] * b[i] - c;
+        double t = sum + y;
+        c = (t - sum) - y;
+        sum = t;
+    }
+
+    return sum - c;
+}
+
+#if _MZ_X86_DISPATCH
+
+__attribute__((target("sse2")))
+static double _MZ_dot_kernel_sse2(const float* a, const float* b, size_t n){
+
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps(), acc2 = _mm_setzero_ps(), acc3 = _mm_setzero_ps();
+    size_t i = 0;
+
+    for(; i + 16 <= n; i += 16){
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(a + i + 8), _mm_loadu_ps(b + i + 8)));
+        acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_loadu_ps(a + i + 12), _mm_loadu_ps(b + i + 12)));
+    }
+    for(; i + 4 <= n; i += 4){
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(_mm_add_ps(acc0, acc1), _mm_add_ps(acc2, acc3)));
+
+    double result = ((double)lanes[0] + lanes[1]) + ((double)lanes[2] + lanes[3]);
+
+    // SSE2 has no masked loads, the last 3 elements at most are added one by one
+    for(; i < n; i++){
+        result += (double)a[i] * b[i];
+    }
+
+    return result;
+}
+
+__attribute__((target("avx2,fma")))
+static inline double _MZ_sum_lanes_avx2(__m256 v){
+
+    float lanes[8];
+    _mm256_storeu_ps(lanes, v);
+
+    return (((double)lanes[0] + lanes[1]) + ((double)lanes[2] + lanes[3])) + (((double)lanes[4] + lanes[5]) + ((double)lanes[6] + lanes[7]));
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256i _MZ_tail_mask_avx2(size_t remaining){
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32((int)remaining), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+__attribute__((target("avx2,fma")))
+static double _MZ_dot_kernel_avx2(const float* a, const float* b, size_t n){
+
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps(), acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for(; i + 32 <= n; i += 32){
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+        acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), acc2);
+        acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), acc3);
+    }
+    for(; i + 8 <= n; i += 8){
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    if(i < n){
+        __m256i mask = _MZ_tail_mask_avx2(n - i);
+        acc1 = _mm256_fmadd_ps(_mm256_maskload_ps(a + i, mask), _mm256_maskload_ps(b + i, mask), acc1);
+    }
+
+    return _MZ_sum_lanes_avx2(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+}
+
+// s += x * y keeping in c the rounding error of the sum and in e the one of the product
+#define _MZ_DOT2_STEP_AVX2(s, c, e, x, y) do{                                                   \
+        __m256 _p = _mm256_mul_ps(x, y);                                                         \
+        e = _mm256_add_ps(e, _mm256_fmsub_ps(x, y, _p));                                         \
+        __m256 _y = _mm256_sub_ps(_p, c);                                                        \
+        __m256 _t = _mm256_add_ps(s, _y);                                                        \
+        c = _mm256_sub_ps(_mm256_sub_ps(_t, s), _y);                                             \
+        s = _t;                                                                                  \
+    }while(0)
+
+__attribute__((target("avx2,fma")))
+static double _MZ_dot_kernel_compensated_avx2(const float* a, const float* b, size_t n){
+
+    __m256 s0 = _mm256_setzero_ps(), c0 = _mm256_setzero_ps(), e0 = _mm256_setzero_ps();
+    __m256 s1 = _mm256_setzero_ps(), c1 = _mm256_setzero_ps(), e1 = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for(; i + 16 <= n; i += 16){
+        _MZ_DOT2_STEP_AVX2(s0, c0, e0, _mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        _MZ_DOT2_STEP_AVX2(s1, c1, e1, _mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+    }
+    for(; i + 8 <= n; i += 8){
+        _MZ_DOT2_STEP_AVX2(s0, c0, e0, _mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    }
+    if(i < n){
+        __m256i mask = _MZ_tail_mask_avx2(n - i);
+        _MZ_DOT2_STEP_AVX2(s1, c1, e1, _mm256_maskload_ps(a + i, mask), _mm256_maskload_ps(b + i, mask));
+    }
+
+    return (_MZ_sum_lanes_avx2(s0) + _MZ_sum_lanes_avx2(s1)) - (_MZ_sum_lanes_avx2(c0) + _MZ_sum_lanes_avx2(c1))
+         + (_MZ_sum_lanes_avx2(e0) + _MZ_sum_lanes_avx2(e1));
+}
+
+__attribute__((target("avx512f")))
+static inline double _MZ_sum_lanes_avx512(__m512 v){
+
+    float lanes[16];
+    _mm512_storeu_ps(lanes, v);
+
+    double half[8];
+    for(int l = 0; l < 8; l++) half[l] = (double)lanes[l] + lanes[l + 8];
+
+    return ((half[0] + half[1]) + (half[2] + half[3])) + ((half[4] + half[5]) + (half[6] + half[7]));
+}
+
+__attribute__((target("avx512f")))
+static double _MZ_dot_kernel_avx512(const float* a, const float* b, size_t n){
+
+    __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps(), acc2 = _mm512_setzero_ps(), acc3 = _mm512_setzero_ps();
+    size_t i = 0;
+
+    for(; i + 64 <= n; i += 64){
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), acc1);
+        acc2 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 32), _mm512_loadu_ps(b + i + 32), acc2);
+        acc3 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 48), _mm512_loadu_ps(b + i + 48), acc3);
+    }
+    for(; i + 16 <= n; i += 16){
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+    }
+    if(i < n){
+        __mmask16 mask = (__mmask16)((1u << (n - i)) - 1);
+        acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i), acc1);
+    }
+
+    return _MZ_sum_lanes_avx512(_mm512_add_ps(_mm512_add_ps(acc0, acc1), _mm512_add_ps(acc2, acc3)));
+}
+
+#define _MZ_DOT2_STEP_AVX512(s, c, e, x, y) do{                                                 \
+        __m512 _p = _mm512_mul_ps(x, y);                                                         \
+        e = _mm512_add_ps(e, _mm512_fmsub_ps(x, y, _p));                                         \
+        __m512 _y = _mm512_sub_ps(_p, c);                                                        \
+        __m512 _t = _mm512_add_ps(s, _y);                                                        \
+        c = _mm512_sub_ps(_mm512_sub_ps(_t, s), _y);                                             \
+        s = _t;                                                                                  \
+    }while(0)
+
+__attribute__((target("avx512f")))
+static double _MZ_dot_kernel_compensated_avx512(const float* a, const float* b, size_t n){
+
+    __m512 s0 = _mm512_setzero_ps(), c0 = _mm512_setzero_ps(), e0 = _mm512_setzero_ps();
+    __m512 s1 = _mm512_setzero_ps(), c1 = _mm512_setzero_ps(), e1 = _mm512_setzero_ps();
+    size_t i = 0;
+
+    for(; i + 32 <= n; i += 32){
+        _MZ_DOT2_STEP_AVX512(s0, c0, e0, _mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        _MZ_DOT2_STEP_AVX512(s1, c1, e1, _mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16));
+    }
+    for(; i + 16 <= n; i += 16){
+        _MZ_DOT2_STEP_AVX512(s0, c0, e0, _mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    }
+    if(i < n){
+        __mmask16 mask = (__mmask16)((1u << (n - i)) - 1);
+        _MZ_DOT2_STEP_AVX512(s1, c1, e1, _mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i));
+    }
+
+    return (_MZ_sum_lanes_avx512(s0) + _MZ_sum_lanes_avx512(s1)) - (_MZ_sum_lanes_avx512(c0) + _MZ_sum_lanes_avx512(c1))
+         + (_MZ_sum_lanes_avx512(e0) + _MZ_sum_lanes_avx512(e1));
+}
+
+static const _MZ_DotKernel _MZ_dot_kernels[MZ_SUMMATION_COUNT][MZ_ISA_COUNT] = {
+    { _MZ_dot_kernel_scalar, _MZ_dot_kernel_scalar, _MZ_dot_kernel_sse2, _MZ_dot_kernel_avx2, _MZ_dot_kernel_avx512 },
+    // SSE2 has no FMA to recover the product errors, it uses the exact double products of the scalar kernel
+    { _MZ_dot_kernel_compensated_scalar, _MZ_dot_kernel_compensated_scalar, _MZ_dot_kernel_compensated_scalar,
+      _MZ_dot_kernel_compensated_avx2, _MZ_dot_kernel_compensated_avx512 },
+};
+
+#else
+
+static const _MZ_DotKernel _MZ_dot_kernels[MZ_SUMMATION_COUNT][MZ_ISA_COUNT] = {
+    { _MZ_dot_kernel_scalar, _MZ_dot_kernel_scalar, _MZ_dot_kernel_scalar, _MZ_dot_kernel_scalar, _MZ_dot_kernel_scalar },
+    { _MZ_dot_kernel_compensated_scalar, _MZ_dot_kernel_compensated_scalar, _MZ_dot_kernel_compensated_scalar,
+      _MZ_dot_kernel_compensated_scalar, _MZ_dot_kernel_compensated_scalar },
+};
+
+#endif // _MZ_X86_DISPATCH
+
+static MZ_Summation _MZ_summation = MZ_SUMMATION_PAIRWISE;
+
+/*
+*/
+void MZ_set_summation(MZ_Summation summation){
+
+    MZ_assert(summation < MZ_SUMMATION_COUNT, "Invalid summation mode.");
+
+    _MZ_summation = summation;
+}
+
+/*
+*/
+MZ_Summation MZ_get_summation(void){
+    return _MZ_summation;
+}
+
+typedef struct _MZ_DotJob{
+    _MZ_DotKernel kernel;
+    const float* a;
+    const float* b;
+    size_t n;
+    size_t blocks;
+    bool withNorm;
+    double* partials;
+}_MZ_DotJob;
+
+static void _MZ_dot_blocks(void* ctx, size_t begin, size_t end){
+
+    _MZ_DotJob* job = (_MZ_DotJob*)ctx;
+
+    for(size_t block = begin; block < end; block++){
+        size_t start = block * _MZ_REDUCE_BLOCK;
+        size_t count = job->n - start < _MZ_REDUCE_BLOCK ? job->n - start : _MZ_REDUCE_BLOCK;
+        job->partials[block] = job->kernel(job->a + start, job->b + start, count);
+        // the block of b is still in L1, its norm costs no extra trip to memory
+        if(job->withNorm){
+            job->partials[job->blocks + block] = job->kernel(job->b + start, job->b + start, count);
+        }
+    }
+}
+
+// pairwise sum of the partials in a fixed order
+static double _MZ_sum_partials(double* partials, size_t count){
+
+    for(; count > 1; count = (count + 1) / 2){
+        for(size_t i = 0; i < count / 2; i++){
+            partials[i] = partials[2 * i] + partials[2 * i + 1];
+        }
+        if(count % 2 == 1){
+            partials[count / 2] = partials[count - 1];
+        }
+    }
+
+    return partials[0];
+}
+
+// a . b and, if norm is not NULL, b . b in the same sweep; the same for any number of threads
+static double _MZ_dot_and_norm(const float* a, const float* b, size_t n, double* norm){
+
+    _MZ_DotKernel kernel = _MZ_dot_kernels[_MZ_summation][_MZ_current_isa()];
+
+    if(n <= _MZ_REDUCE_BLOCK){
+        if(norm != NULL) *norm = kernel(b, b, n);
+        return kernel(a, b, n);
+    }
+
+    size_t blocks = (n + _MZ_REDUCE_BLOCK - 1) / _MZ_REDUCE_BLOCK;
+    size_t needed = norm != NULL ? 2 * blocks : blocks;
+
+    double stackPartials[_MZ_REDUCE_STACK];
+    _MZ_Scratch scratch = _MZ_scratch_begin();
+
+    _MZ_DotJob job = { kernel, a, b, n, blocks, norm != NULL, stackPartials };
+
+    if(needed > _MZ_REDUCE_STACK){
+        job.partials = (double*)MZ_arena_alloc(&_MZ_scratch_arena, needed * sizeof(double));
+        MZ_assert(job.partials != NULL, MZ_ALLOC_ERROR);
+    }
+
+    _MZ_parallel_for(blocks, MZ_PARALLEL_THRESHOLD / _MZ_REDUCE_BLOCK, _MZ_dot_blocks, &job);
+
+    double result = _MZ_sum_partials(job.partials, blocks);
+
+    if(norm != NULL) *norm = _MZ_sum_partials(job.partials + blocks, blocks);
+
+    _MZ_scratch_end(scratch);
+
+    return result;
+}
+
+// sum of a[i] * b[i], the same for any number of threads
+static inline double _MZ_dot(const float* a, const float* b, size_t n){
+    return _MZ_dot_and_norm(a, b, n, NULL);
+}
+
+// (a . b) / (b . b) with a single sweep over both vectors, 0 when they are orthogonal
+static inline float _MZ_scalar_proj(const float* a, const float* b, size_t n){
+
+    double norm;
+    double dot = _MZ_dot_and_norm(a, b, n, &norm);
+
+    return dot == 0.0 ? 0.0f : (float)(dot / norm);
+}
+
+/*
+    Row operations. _MZ_axpy_rows adds alphas[t] * x to the k rows y + t * ldy: a chunk of x
+    is kept in registers while it is added to every row, so that eliminating k rows with one
+    pivot row is a single pass over the pivot row. Rows with a zero alpha are skipped.
+*/
+typedef void (*_MZ_AxpyRowsKernel)(float* y, size_t ldy, size_t k, const float* alphas, const float* x, size_t n);
+
+static void _MZ_axpy_rows_kernel_scalar(float* y, size_t ldy, size_t k, const float* alphas, const float* x, size_t n){
+
+    for(size_t t = 0; t < k; t++){
+        float alpha = alphas[t];
+        if(alpha == 0.0f) continue;
+        float* row = y + t * ldy;
+        for(size_t i = 0; i < n; i++){
+            row[i] += alpha * x[i];
+        }
+    }
+}
+
+#if _MZ_X86_DISPATCH
+
+__attribute__((target("sse2")))
+static void _MZ_axpy_rows_kernel_sse2(float* y, size_t ldy, size_t k, const float* alphas, const float* x, size_t n){
+
+    size_t i = 0;
+
+    for(; i + 16 <= n; i += 16){
+        __m128 x0 = _mm_loadu_ps(x + i), x1 = _mm_loadu_ps(x + i + 4);
+        __m128 x2 = _mm_loadu_ps(x + i + 8), x3 = _mm_loadu_ps(x + i + 12);
+        for(size_t t = 0; t < k; t++){
+            if(alphas[t] == 0.0f) continue;
+            __m128 va = _mm_set1_ps(alphas[t]);
+            float* row = y + t * ldy + i;
+            _mm_storeu_ps(row, _mm_add_ps(_mm_loadu_ps(row), _mm_mul_ps(va, x0)));
+            _mm_storeu_ps(row + 4, _mm_add_ps(_mm_loadu_ps(row + 4), _mm_mul_ps(va, x1)));
+            _mm_storeu_ps(row + 8, _mm_add_ps(_mm_loadu_ps(row + 8), _mm_mul_ps(va, x2)));
+            _mm_storeu_ps(row + 12, _mm_add_ps(_mm_loadu_ps(row + 12), _mm_mul_ps(va, x3)));
+        }
+    }
+
+    for(; i + 4 <= n; i += 4){
+        __m128 x0 = _mm_loadu_ps(x + i);
+        for(size_t t = 0; t < k; t++){
+            if(alphas[t] == 0.0f) continue;
+            float* row = y + t * ldy + i;
+            _mm_storeu_ps(row, _mm_add_ps(_mm_loadu_ps(row), _mm_mul_ps(_mm_set1_ps(alphas[t]), x0)));
+        }
+    }
+
+    if(i < n){
+        _MZ_axpy_rows_kernel_scalar(y + i, ldy, k, alphas, x + i, n - i);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void _MZ_axpy_rows_kernel_avx2(float* y, size_t ldy, size_t k, const float* alphas, const float* x, size_t n){
+
+    size_t i = 0;
+
+    for(; i + 32 <= n; i += 32){
+        __m256 x0 = _mm256_loadu_ps(x + i), x1 = _mm256_loadu_ps(x + i + 8);
+        __m256 x2 = _mm256_loadu_ps(x + i + 16), x3 = _mm256_loadu_ps(x + i + 24);
+        for(size_t t = 0; t < k; t++){
+            if(alphas[t] == 0.0f) continue;
+            __m256 va = _mm256_set1_ps(alphas[t]);
+            float* row = y + t * ldy + i;
+            _mm256_storeu_ps(row, _mm256_fmadd_ps(va, x0, _mm256_loadu_ps(row)));
+            _mm256_storeu_ps(row + 8, _mm256_fmadd_ps(va, x1, _mm256_loadu_ps(row + 8)));
+            _mm256_storeu_ps(row + 16, _mm256_fmadd_ps(va, x2, _mm256_loadu_ps(row + 16)));
+            _mm256_storeu_ps(row + 24, _mm256_fmadd_ps(va, x3, _mm256_loadu_ps(row + 24)));
+        }
+    }
+
+    for(; i + 8 <= n; i += 8){
+        __m256 x0 = _mm256_loadu_ps(x + i);
+        for(size_t t = 0; t < k; t++){
+            if(alphas[t] == 0.0f) continue;
+            float* row = y + t * ldy + i;
+            _mm256_storeu_ps(row, _mm256_fmadd_ps(_mm256_set1_ps(alphas[t]), x0, _mm256_loadu_ps(row)));
+        }
+    }
+
+    if(i < n){
+        __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32((int)(n - i)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256 x0 = _mm256_maskload_ps(x + i, mask);
+        for(size_t t = 0; t < k; t++){
+            if(alphas[t] == 0.0f) continue;
+            float* row = y + t * ldy + i;
+            _mm256_maskstore_ps(row, mask, _mm256_fmadd_ps(_mm256_set1_ps(alphas[t]), x0, _mm256_maskload_ps(row, mask)));
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+static void _MZ_axpy_rows_kernel_avx512(float* y, size_t ldy, size_t k, const float* alphas, const float* x, size_t n){
+
+    size_t i = 0;
+
+    for(; i + 64 <= n; i += 64){
+        __m512 x0 = _mm512_loadu_ps(x + i), x1 = _mm512_loadu_ps(x + i + 16);
+        __m512 x2 = _mm512_loadu_ps(x + i + 32), x3 = _mm512_loadu_ps(x + i + 48);
+        for(size_t t = 0; t < k; t++){
+            if(alphas[t] == 0.0f) continue;
+            __m512 va = _mm512_set1_ps(alphas[t]);
+            float* row = y + t * ldy + i;
+            _mm512_storeu_ps(row, _mm512_fmadd_ps(va, x0, _mm512_loadu_ps(row)));
+            _mm512_storeu_ps(row + 16, _mm512_fmadd_ps(va, x1, _mm512_loadu_ps(row + 16)));
+            _mm512_storeu_ps(row + 32, _mm512_fmadd_ps(va, x2, _mm512_loadu_ps(row + 32)));
+            _mm512_storeu_ps(row + 48, _mm512_fmadd_ps(va, x3, _mm512_loadu_ps(row + 48)));
+        }
+    }
+
+    for(; i < n; i += 16){
+        __mmask16 mask = n - i >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (n - i)) - 1);
+        __m512 x0 = _mm512_maskz_loadu_ps(mask, x + i);
+        for(size_t t = 0; t < k; t++){
+            if(alphas[t] == 0.0f) continue;
+            float* row = y + t * ldy + i;
+            _mm512_mask_storeu_ps(row, mask, _mm512_fmadd_ps(_mm512_set1_ps(alphas[t]), x0, _mm512_maskz_loadu_ps(mask, row)));
+        }
+    }
+}
+
+static const _MZ_AxpyRowsKernel _MZ_axpy_rows_kernels[MZ_ISA_COUNT] = {
+    _MZ_axpy_rows_kernel_scalar,
+    _MZ_axpy_rows_kernel_scalar,
+    _MZ_axpy_rows_kernel_sse2,
+    _MZ_axpy_rows_kernel_avx2,
+    _MZ_axpy_rows_kernel_avx512,
+};
+
+#else
+
+static const _MZ_AxpyRowsKernel _MZ_axpy_rows_kernels[MZ_ISA_COUNT] = {
+    _MZ_axpy_rows_kernel_scalar,
+    _MZ_axpy_rows_kernel_scalar,
+    _MZ_axpy_rows_kernel_scalar,
+    _MZ_axpy_rows_kernel_scalar,
+    _MZ_axpy_rows_kernel_scalar,
+};
+
+#endif // _MZ_X86_DISPATCH
+
+typedef struct _MZ_AxpyRowsJob{
+    _MZ_AxpyRowsKernel kernel;
+    float* y;
+    size_t ldy;
+    const float* alphas;
+    const float* x;
+    size_t n;
+}_MZ_AxpyRowsJob;
+
+static void _MZ_axpy_rows_range(void* ctx, size_t begin, size_t end){
+
+    _MZ_AxpyRowsJob* job = (_MZ_AxpyRowsJob*)ctx;
+
+    job->kernel(job->y + begin * job->ldy, job->ldy, end - begin, job->alphas + begin, job->x, job->n);
+}
+
+// y[t] += alphas[t] * x for the k rows y + t * ldy, which must not overlap x; the rows are split across the pool
+static void _MZ_axpy_rows(float* y, size_t ldy, size_t k, const float* alphas, const float* x, size_t n){
+
+    if(k == 0 || n == 0) return;
+
+    _MZ_AxpyRowsJob job = { _MZ_axpy_rows_kernels[_MZ_current_isa()], y, ldy, alphas, x, n };
+
+    _MZ_parallel_for(k, MZ_PARALLEL_THRESHOLD / n + 1, _MZ_axpy_rows_range, &job);
+}
+
+// y += alpha * x
+static inline void _MZ_axpy(float* y, const float* x, float alpha, size_t n){
+    _MZ_axpy_rows_kernels[_MZ_current_isa()](y, 0, 1, &alpha, x, n);
+}
+
+// x *= alpha
+static inline void _MZ_scal(float* x, float alpha, size_t n){
+    _MZ_element_kernels[_MZ_current_isa()](x, x, NULL, alpha, n, _MZ_OP_MUL);
+}
+
+MZ_Vec NULL_VECTOR = {0, NULL, false};
+
+/*
+*/
+void MZ_print_vector(FILE* fp, MZ_Vec vector){
+
+    fprintf(fp ,"\n\n   | Vector of size %zu: {\n   |\t[", MZ_DIM_OF_VECTOR(vector));
+
+    if(vector.elements == NULL){
+        fprintf(fp ," %s ", MZ_NULL_VECTOR);
+    }else {
+        for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector); i++){
+            #if !VISUALIZE_RATIONAL
+            fprintf(fp ," %f", MZ_VALUE_OF_VECTOR_AT(vector, i));
+            #else
+            zstring value = rationalizeFloatToStr(MZ_VALUE_OF_VECTOR_AT(vector, i), 3);
+            fprintf(fp, " %s", value.data);
+            #endif
+            fprintf(fp ,"%c", (i < MZ_DIM_OF_VECTOR(vector) - 1 ? ',' : ' '));
+        }
+    }
+    fprintf(fp ,"]\n   |  }\n\n");
+}
+
+/*
+*/
+void MZ_print_vector_by_label(FILE* fp, const char* label, MZ_Vec vector){
+
+    fprintf(fp ,"\n\n   | [%s] of size %zu: {\n   |\t[", label, MZ_DIM_OF_VECTOR(vector));
+
+    if(vector.elements == NULL){
+        fprintf(fp ," %s ", MZ_NULL_VECTOR);
+    }else {
+        for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector); i++){
+            #if !VISUALIZE_RATIONAL 
+            fprintf(fp ," %f", MZ_VALUE_OF_VECTOR_AT(vector, i));
+            #else
+            zstring value = rationalizeFloatToStr(MZ_VALUE_OF_VECTOR_AT(vector, i), 3);
+            fprintf(fp, " %s", value.data);
+            #endif
+            fprintf(fp ,"%c", (i < MZ_DIM_OF_VECTOR(vector) - 1 ? ',' : ' '));
+        }
+    }
+    fprintf(fp ,"]\n   |  }\n\n");
+}
+
+/*
+*/
+void MZ_print_vector_by_index(FILE* fp, int index, MZ_Vec vector){
+
+    fprintf(fp ,"\n\n   | [VECTOR %d] of size %zu: {\n   |\t[", index, MZ_DIM_OF_VECTOR(vector));
+
+    if(vector.elements == NULL){
+        fprintf(fp ," %s ", MZ_NULL_VECTOR);
+    }else {
+        for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector); i++){
+            #if !VISUALIZE_RATIONAL 
+            fprintf(fp ," %f", MZ_VALUE_OF_VECTOR_AT(vector, i));
+            #else
+            zstring value = rationalizeFloatToStr(MZ_VALUE_OF_VECTOR_AT(vector, i), 3);
+            fprintf(fp, " %s", value.data);
+            #endif
+            fprintf(fp ,"%c", (i < MZ_DIM_OF_VECTOR(vector) - 1 ? ',' : ' '));
+        }
+    }
+    fprintf(fp ,"]\n   |  }\n\n");
+}
+
+/*
+*/
+void MZ_free_vector(MZ_Vec* vector){
+
+    MZ_assert(vector != NULL, "Vector must not be NULL.");
+
+    if(!vector->borrowed){
+        MZ_FREE(vector->elements, vector->dim, float);
+    }
+    vector->elements = NULL;
+    vector->dim = 0;
+    vector->borrowed = false;
+}
+
+/*
+*/
+MZ_Vec MZ_wrap_vector(float* elements, size_t dim){
+
+    MZ_assert(elements != NULL || dim == 0, "Elements must not be NULL.");
+
+    MZ_Vec result = { dim, elements, true };
+
+    return result;
+}
+
+/*
+*/
+void MZ_copy_vector_pointer(MZ_Vec* source, MZ_Vec* dest){
+
+    if(dest->elements == NULL){ 
+        *dest= MZ_alloc_vector(source->dim); 
+    }
+
+    dest->dim = source->dim;
+    dest->elements = source->elements;
+    dest->borrowed = source->borrowed;
+
+}
+
+/*
+*/
+MZ_Vec MZ_alloc_vector(size_t dim){
+    MZ_Vec result;
+    result.dim = dim;
+    result.borrowed = false;
+    result.elements = MZ_ALLOC(dim, float);
+
+    MZ_assert(result.elements != NULL, MZ_ALLOC_ERROR);
+
+    return result;
+}
+
+/*
+*/
+MZ_Vec MZ_new_zero_vector(size_t dim){
+
+    MZ_Vec result = MZ_alloc_vector(dim);
+
+    for(size_t i = 0; i < dim; i++){
+        MZ_VALUE_OF_VECTOR_AT(result, i) = 0.0f;
+    }
+
+    return result;
+
+}
+
+/*
+*/
+MZ_Vec MZ_new_default_vector(size_t dim, float element){
+
+    MZ_Vec result = MZ_alloc_vector(dim);
+
+    for(size_t i = 0; i < dim; i++){
+        MZ_VALUE_OF_VECTOR_AT(result, i) = element;
+    }
+
+    return result;
+
+}
+
+/*
+*/
+MZ_Vec MZ_new_random_float_vector(size_t dim, float min, float max){
+
+    MZ_Vec result = MZ_alloc_vector(dim);
+
+    MZ_SRAND();
+
+    for(size_t i = 0; i < dim; i++){
+        MZ_VALUE_OF_VECTOR_AT(result, i) = MZ_rand_float(min, max);
+    }
+
+    return result;
+}
+
+/*
+*/
+MZ_Vec MZ_new_random_int_vector(size_t dim, float min, float max){
+
+    MZ_Vec result = MZ_alloc_vector(dim);
+
+    MZ_SRAND();
+    
+    for(size_t i = 0; i < dim; i++){
+        MZ_VALUE_OF_VECTOR_AT(result, i) = MZ_rand_int(min, max);
+    }
+
+    return result;
+}
+
+/*
+*/
+MZ_Vec _MZ_new_vector(size_t dim, ...){
+
+    MZ_Vec result = MZ_alloc_vector(dim);
+
+    va_list elem;
+    va_start(elem, dim);
+
+    for(size_t i = 0 ; i < dim; i++){
+        MZ_VALUE_OF_VECTOR_AT(result, i) = va_arg(elem, double);
+    }
+
+    va_end(elem);
+
+    return result;
+
+}
+
+/*
+*/
+MZ_Vec MZ_copy_vector(MZ_Vec source){
+
+    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(source));
+
+    MZ_copy_vector_into(&result, source);
+
+    return result;
+
+}
+
+/*
+*/
+void MZ_copy_vector_into(MZ_Vec* dest, MZ_Vec source){
+
+    MZ_assert(dest->dim == MZ_DIM_OF_VECTOR(source), MZ_EQUAL_ERROR);
+
+    if(dest->elements != source.elements && source.dim != 0){
+        memcpy(dest->elements, source.elements, source.dim * sizeof(float));
+    }
+}
+
+/*
+*/
+MZ_Vec MZ_add_two_vectors(MZ_Vec vector1 , MZ_Vec vector2){
+
+    MZ_assert(MZ_DIM_OF_VECTOR(vector1) == MZ_DIM_OF_VECTOR(vector2), MZ_EQUAL_ERROR);
+
+    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+
+    MZ_add_two_vectors_into(&result, vector1, vector2);
+
+    return result;
+}
+
+/*
+*/
+void MZ_add_two_vectors_into(MZ_Vec* dest, MZ_Vec vector1, MZ_Vec vector2){
+
+    MZ_assert(MZ_DIM_OF_VECTOR(vector1) == MZ_DIM_OF_VECTOR(vector2) && dest->dim == MZ_DIM_OF_VECTOR(vector1), MZ_EQUAL_ERROR);
+
+    _MZ_elementwise(dest->elements, vector1.elements, vector2.elements, 0.0f, MZ_DIM_OF_VECTOR(vector1), _MZ_OP_ADD);
+}
+
+/*
+*/
+MZ_Vec MZ_add_vector_with_scalar(MZ_Vec vector1 , float scalar){
+
+    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+
+    MZ_add_vector_with_scalar_into(&result, vector1, scalar);
+
+    return result;
+}
+
+/*
+*/
+void MZ_add_vector_with_scalar_into(MZ_Vec* dest, MZ_Vec vector1, float scalar){
+
+    MZ_assert(dest->dim == MZ_DIM_OF_VECTOR(vector1), MZ_EQUAL_ERROR);
+
+    _MZ_elementwise(dest->elements, vector1.elements, NULL, scalar, MZ_DIM_OF_VECTOR(vector1), _MZ_OP_ADD);
+}
+    
+/*
+*/
+MZ_Vec MZ_subtract_two_vectors(MZ_Vec vector1 , MZ_Vec vector2){
+
+    MZ_assert(MZ_DIM_OF_VECTOR(vector1) == MZ_DIM_OF_VECTOR(vector2), MZ_EQUAL_ERROR);
+
+    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+
+    MZ_subtract_two_vectors_into(&result, vector1, vector2);
+
+    return result;
+}
+
+/*
+*/
+void MZ_subtract_two_vectors_into(MZ_Vec* dest, MZ_Vec vector1, MZ_Vec vector2){
+
+    MZ_assert(MZ_DIM_OF_VECTOR(vector1) == MZ_DIM_OF_VECTOR(vector2) && dest->dim == MZ_DIM_OF_VECTOR(vector1), MZ_EQUAL_ERROR);
+
+    _MZ_elementwise(dest->elements, vector1.elements, vector2.elements, 0.0f, MZ_DIM_OF_VECTOR(vector1), _MZ_OP_SUB);
+}
+
+/*
+*/
+MZ_Vec MZ_subtract_vector_with_scalar(MZ_Vec vector1 , float scalar){
+
+    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+
+    MZ_subtract_vector_with_scalar_into(&result, vector1, scalar);
+
+    return result;
+}
+
+/*
+*/
+void MZ_subtract_vector_with_scalar_into(MZ_Vec* dest, MZ_Vec vector1, float scalar){
+
+    MZ_assert(dest->dim == MZ_DIM_OF_VECTOR(vector1), MZ_EQUAL_ERROR);
+
+    _MZ_elementwise(dest->elements, vector1.elements, NULL, scalar, MZ_DIM_OF_VECTOR(vector1), _MZ_OP_SUB);
+}
+
+/*
+*/
+MZ_Vec MZ_multiply_two_vectors(MZ_Vec vector1, MZ_Vec vector2){
+
+    MZ_assert(MZ_DIM_OF_VECTOR(vector1) == MZ_DIM_OF_VECTOR(vector2), MZ_EQUAL_ERROR);
+
+    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+
+    MZ_multiply_two_vectors_into(&result, vector1, vector2);
+
+    return result;
+}
+
+/*
+*/
+void MZ_multiply_two_vectors_into(MZ_Vec* dest, MZ_Vec vector1, MZ_Vec vector2){
+
+    MZ_assert(MZ_DIM_OF_VECTOR(vector1) == MZ_DIM_OF_VECTOR(vector2) && dest->dim == MZ_DIM_OF_VECTOR(vector1), MZ_EQUAL_ERROR);
+
+    _MZ_elementwise(dest->elements, vector1.elements, vector2.elements, 0.0f, MZ_DIM_OF_VECTOR(vector1), _MZ_OP_MUL);
+}
+
+/*
+*/
+MZ_Vec MZ_multiply_vector_by_scalar(MZ_Vec vector1, float scalar){
+
+    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+
+    MZ_multiply_vector_by_scalar_into(&result, vector1, scalar);
+
+    return result;
+}
+
+/*
+*/
+void MZ_multiply_vector_by_scalar_into(MZ_Vec* dest, MZ_Vec vector1, float scalar){
+
+    MZ_assert(dest->dim == MZ_DIM_OF_VECTOR(vector1), MZ_EQUAL_ERROR);
+
+    _MZ_elementwise(dest->elements, vector1.elements, NULL, scalar, MZ_DIM_OF_VECTOR(vector1), _MZ_OP_MUL);
+}
+
+/*
+*/
+MZ_Vec MZ_divide_two_vectors(MZ_Vec vector1, MZ_Vec vector2){
+
+    MZ_assert(MZ_DIM_OF_VECTOR(vector1) == MZ_DIM_OF_VECTOR(vector2), MZ_EQUAL_ERROR);
+
+    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector2); i++){
+        if(MZ_VALUE_OF_VECTOR_AT(vector2 , i) == 0.0f) return NULL_VECTOR;
+    }
+
+    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+
+    _MZ_elementwise(result.elements, vector1.elements, vector2.elements, 0.0f, MZ_DIM_OF_VECTOR(vector1), _MZ_OP_DIV);
+
+    return result;  
+}
+
+/*
+*/
+bool MZ_divide_two_vectors_into(MZ_Vec* dest, MZ_Vec vector1, MZ_Vec vector2){
+
+    MZ_assert(MZ_DIM_OF_VECTOR(vector1) == MZ_DIM_OF_VECTOR(vector2) && dest->dim == MZ_DIM_OF_VECTOR(vector1), MZ_EQUAL_ERROR);
+
+    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector2); i++){
+        if(MZ_VALUE_OF_VECTOR_AT(vector2 , i) == 0.0f) return false;
+    }
+
+    _MZ_elementwise(dest->elements, vector1.elements, vector2.elements, 0.0f, MZ_DIM_OF_VECTOR(vector1), _MZ_OP_DIV);
+
+    return true;
+}
+
+/*
+*/
+MZ_Vec MZ_divide_vector_by_scalar(MZ_Vec vector1, float scalar){
+
+    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+
+    MZ_divide_vector_by_scalar_into(&result, vector1, scalar);
+
+    return result;
+}
+
+/*
+*/
+void MZ_divide_vector_by_scalar_into(MZ_Vec* dest, MZ_Vec vector1, float scalar){
+
+    MZ_assert(dest->dim == MZ_DIM_OF_VECTOR(vector1), MZ_EQUAL_ERROR);
+
+    _MZ_elementwise(dest->elements, vector1.elements, NULL, scalar, MZ_DIM_OF_VECTOR(vector1), _MZ_OP_DIV);
+}
+
+/*
+*/
+MZ_Vec MZ_raise_vector_to_exp(MZ_Vec vector, size_t exponent){
+
+    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector));
+
+    MZ_raise_vector_to_exp_into(&result, vector, exponent);
+
+    return result;
+
+}
+
+/*
+*/
+void MZ_raise_vector_to_exp_into(MZ_Vec* dest, MZ_Vec vector, size_t exponent){
+
+    MZ_assert(dest->dim == MZ_DIM_OF_VECTOR(vector), MZ_EQUAL_ERROR);
+
+    #if VISUALIZE_STEPS
+    printf("\n");
+    #endif
+    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector); i++){
+        float base = MZ_VALUE_OF_VECTOR_AT(vector, i);
+        float value = base;
+        for(size_t j = 0; j < exponent; j++){
+            value *= base;
+
+            #if VISUALIZE_STEPS
+            printf("%f -> %f |", value / base, value);
+            #endif
+        }
+        MZ_VALUE_OF_VECTOR_POINTER_AT(dest, i) = value;
+
+        #if VISUALIZE_STEPS
+        printf("\n");
+        #endif
+    }
+
+}
+
+/*
+*/
+MZ_Vec MZ_cross_product(MZ_Vec vector1, MZ_Vec vector2){
+
+    if(MZ_DIM_OF_VECTOR(vector1) != 3 || MZ_DIM_OF_VECTOR(vector2) != 3){
+        return NULL_VECTOR;
+    }
+
+    MZ_Vec result = MZ_alloc_vector(3);
+
+    MZ_cross_product_into(&result, vector1, vector2);
+
+    return result;
+}
+
+/*
+*/
+bool MZ_cross_product_into(MZ_Vec* dest, MZ_Vec vector1, MZ_Vec vector2){
+
+    if(MZ_DIM_OF_VECTOR(vector1) != 3 || MZ_DIM_OF_VECTOR(vector2) != 3 || dest->dim != 3){
+        return false;
+    }
+
+    // computed before storing so that dest can be one of the operands
+    float x = (MZ_VALUE_OF_VECTOR_AT(vector1, 1) * MZ_VALUE_OF_VECTOR_AT( vector2, 2)) - (MZ_VALUE_OF_VECTOR_AT(vector1 , 2) * MZ_VALUE_OF_VECTOR_AT(vector2 , 1));
+    float y = (MZ_VALUE_OF_VECTOR_AT(vector1, 2) * MZ_VALUE_OF_VECTOR_AT( vector2, 0)) - (MZ_VALUE_OF_VECTOR_AT(vector1 , 0) * MZ_VALUE_OF_VECTOR_AT(vector2 , 2));
+    float z = (MZ_VALUE_OF_VECTOR_AT(vector1, 0) * MZ_VALUE_OF_VECTOR_AT( vector2, 1)) - (MZ_VALUE_OF_VECTOR_AT(vector1 , 1) * MZ_VALUE_OF_VECTOR_AT(vector2 , 0));
+
+    MZ_VALUE_OF_VECTOR_POINTER_AT(dest, 0) = x;
+    MZ_VALUE_OF_VECTOR_POINTER_AT(dest, 1) = y;
+    MZ_VALUE_OF_VECTOR_POINTER_AT(dest, 2) = z;
+
+    return true;
+}
+
+/*
+*/
+MZ_Vec MZ_normalized_vector(MZ_Vec vector){
+
+    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector));
+
+    MZ_normalized_vector_into(&result, vector);
+
+    return result;
+
+}
+
+/*
+*/
+void MZ_normalized_vector_into(MZ_Vec* dest, MZ_Vec vector){
+
+    MZ_assert(dest->dim == MZ_DIM_OF_VECTOR(vector), MZ_EQUAL_ERROR);
+
+    // one sweep for the magnitude and one to scale, nothing in between
+    float inv = (float)(1.0 / sqrt(_MZ_dot(vector.elements, vector.elements, MZ_DIM_OF_VECTOR(vector))));
+
+    _MZ_elementwise(dest->elements, vector.elements, NULL, inv, MZ_DIM_OF_VECTOR(vector), _MZ_OP_MUL);
+
+}
+
+/*
+*/
+MZ_Vec MZ_vector_proj_a_on_b(MZ_Vec vector_A, MZ_Vec vector_B){
+  
+  MZ_assert(vector_A.dim == vector_B.dim, MZ_EQUAL_ERROR);
+
+  MZ_Vec result = MZ_alloc_vector(vector_A.dim);
+
+  MZ_vector_proj_a_on_b_into(&result, vector_A, vector_B);
+
+  return result;
+}
+
+/*
+*/
+void MZ_vector_proj_a_on_b_into(MZ_Vec* dest, MZ_Vec vector_A, MZ_Vec vector_B){
+
+  MZ_assert(vector_A.dim == vector_B.dim && dest->dim == vector_A.dim, MZ_EQUAL_ERROR);
+
+  // the scalar is computed before writing so that dest can be one of the operands
+  float scalar = _MZ_scalar_proj(vector_A.elements, vector_B.elements, vector_B.dim);
+
+  _MZ_elementwise(dest->elements, vector_B.elements, NULL, scalar, vector_B.dim, _MZ_OP_MUL);
+}
+
+/*
+*/
+void MZ_normalize_vector(MZ_Vec* vector){
+
+    MZ_normalized_vector_into(vector, *vector);
+}
+
+/*
+*/
+bool MZ_are_two_vectors_equal(MZ_Vec vector1, MZ_Vec vector2){
+
+    if(MZ_DIM_OF_VECTOR(vector1) != MZ_DIM_OF_VECTOR(vector2)) return false;
+
+    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector1); i++){
+        if(MZ_VALUE_OF_VECTOR_AT(vector1, i) != MZ_VALUE_OF_VECTOR_AT(vector2, i)) return false;
+    }
+
+    return true;
+
+}
+
+/*
+*/
+bool MZ_are_two_vectors_orthogonal(MZ_Vec vector1, MZ_Vec vector2){
+    return MZ_dot_two_vectors(vector1, vector2) == 0; 
+}
+
+/*
+*/
+bool MZ_is_vector_normalized(MZ_Vec vector){
+
+    return fabs(MZ_magnitude_of_vector(vector) - 1.0) < 0.0001;
+}
+
+/*
+*/
+float MZ_dot_two_vectors(MZ_Vec vector1, MZ_Vec vector2){
+
+    MZ_assert(MZ_DIM_OF_VECTOR(vector1) == MZ_DIM_OF_VECTOR(vector2), MZ_EQUAL_ERROR);
+
+    return (float)_MZ_dot(vector1.elements, vector2.elements, MZ_DIM_OF_VECTOR(vector1));
+
+}
+
+/*
+*/
+float MZ_magnitude_of_vector(MZ_Vec vector){
+
+    return (float)sqrt(_MZ_dot(vector.elements, vector.elements, MZ_DIM_OF_VECTOR(vector)));
+
+}
+
+float MZ_scalar_proj_a_on_b(MZ_Vec vector_A, MZ_Vec vector_B){
+
+  MZ_assert(vector_A.dim == vector_B.dim, MZ_EQUAL_ERROR);
+
+  return _MZ_scalar_proj(vector_A.elements, vector_B.elements, vector_B.dim);
+  
+}
+
+MZ_Matrix NULL_MATRIX = {0, 0, NULL, 0, false};
+
+/*
+*/
+void MZ_print_matrix(FILE *fp, MZ_Matrix mat){
+	
+	#if VISUALIZE_RATIONAL
+	int spaces = 12;
+    #else
+    int spaces = 11;
+    #endif
+
+	fprintf(fp, "\n\n   | Matrix of size %ux%u: {\n", mat.rows, mat.cols);
+	
+    if(mat.elements == NULL){
+
+        int spaces = 13;
+
+        fprintf(fp, "   |\t\t%c   ", LEFT_UP_CORNER);
+        for(unsigned int i = 0; i < 2; i++){
+            for(int i = 0; i < spaces; i++){
+                fprintf(fp, " ");
+            }	
+        }
+        fprintf(fp, "    %c   \n", RIGHT_UP_CORNER);
+        
+        for(unsigned int i = 0; i < 2; i++){
+            
+            fprintf(fp, "   |\t\t%c   ", SIDE_CHAR);
+            
+            for(unsigned int j = 0; j < 2; j++){
+                fprintf(fp, "%-13s ", MZ_NULL_MATRIX);
+            }		
+            fprintf(fp, "  %c\n", SIDE_CHAR);
+        }
+
+        fprintf(fp, "   |\t\t%c   ", LEFT_DOWN_CORNER);
+        for(unsigned int i = 0; i < 2; i++){
+            for(int i = 0; i < spaces; i++){
+                fprintf(fp, " ");
+            }
+        }
+        fprintf(fp, "    %c   \n", RIGHT_DOWN_CORNER);
+        fprintf(fp, "   | }\n\n");
+
+    }else {
+
+        fprintf(fp, "   |\t\t%c   ", LEFT_UP_CORNER);
+        for(unsigned int i = 0; i < mat.cols; i++){
+            for(int i = 0; i < spaces; i++){
+                fprintf(fp, " ");
+            }	
+        }
+        fprintf(fp, "%c   \n", RIGHT_UP_CORNER);
+        
+        for(unsigned int i = 0; i < mat.rows; i++){
+            
+            fprintf(fp, "   |\t\t%c   ", SIDE_CHAR);
+            
+            for(unsigned int j = 0; j < mat.cols; j++){
+                #if !VISUALIZE_RATIONAL
+                fprintf(fp, "%-11f", MZ_VALUE_OF_MAT_AT(mat, i, j));
+                #else
+                zstring value = rationalizeFloatToStr(MZ_VALUE_OF_MAT_AT(mat, i, j), 3);
+                fprintf(fp, " %-11s", value.data);
+                #endif
+            }		
+            fprintf(fp, "%c\n", SIDE_CHAR);
+        }
+
+        fprintf(fp, "   |\t\t%c   ", LEFT_DOWN_CORNER);
+        for(unsigned int i = 0; i < mat.cols; i++){
+            for(int i = 0; i < spaces; i++){
+                fprintf(fp, " ");
+            }
+        }
+        fprintf(fp, "%c   \n", RIGHT_DOWN_CORNER);
+        fprintf(fp, "   | }\n\n");
+
+    }
+	
+}
+
+/*
+*/
+void MZ_print_matrix_by_label(FILE *fp, const char* label, MZ_Matrix mat){
+	
+	#if VISUALIZE_RATIONAL
+	int spaces = 12;
+    #else
+    int spaces = 11;
+    #endif
+
+	fprintf(fp, "\n\n   | [%s] of size %ux%u: {\n", label, mat.rows, mat.cols);
+
+    if(mat.elements == NULL){
+
+        int spaces = 13;
+
+        fprintf(fp, "   |\t\t%c   ", LEFT_UP_CORNER);
+        for(unsigned int i = 0; i < 2; i++){
+            for(int i = 0; i < spaces; i++){
+                fprintf(fp, " ");
+            }	
+        }
+        fprintf(fp, "    %c   \n", RIGHT_UP_CORNER);
+        
+        for(unsigned int i = 0; i < 2; i++){
+            
+            fprintf(fp, "   |\t\t%c   ", SIDE_CHAR);
+            
+            for(unsigned int j = 0; j < 2; j++){
+                fprintf(fp, "%-13s ", MZ_NULL_MATRIX);
+            }		
+            fprintf(fp, "  %c\n", SIDE_CHAR);
+        }
+
+        fprintf(fp, "   |\t\t%c   ", LEFT_DOWN_CORNER);
+        for(unsigned int i = 0; i < 2; i++){
+            for(int i = 0; i < spaces; i++){
+                fprintf(fp, " ");
+            }
+        }
+        fprintf(fp, "    %c   \n", RIGHT_DOWN_CORNER);
+        fprintf(fp, "   | }\n\n");
+
+    }else {
+
+        fprintf(fp, "   |\t\t%c   ", LEFT_UP_CORNER);
+        for(unsigned int i = 0; i < mat.cols; i++){
+            for(int i = 0; i < spaces; i++){
+                fprintf(fp, " ");
+            }	
+        }
+        fprintf(fp, "%c   \n", RIGHT_UP_CORNER);
+	
+        for(unsigned int i = 0; i < mat.rows; i++){
+            
+            fprintf(fp, "   |\t\t%c   ", SIDE_CHAR);
+            
+            for(unsigned int j = 0; j < mat.cols; j++){
+                #if !VISUALIZE_RATIONAL
+                fprintf(fp, "%-11f", MZ_VALUE_OF_MAT_AT(mat, i, j));
+                #else
+                zstring value = rationalizeFloatToStr(MZ_VALUE_OF_MAT_AT(mat, i, j), 3);
+                fprintf(fp, " %-11s", value.data);
+                #endif
+            }		
+            fprintf(fp, "%c\n", SIDE_CHAR);
+        }
+
+        fprintf(fp, "   |\t\t%c   ", LEFT_DOWN_CORNER);
+        for(unsigned int i = 0; i < mat.cols; i++){
+            for(int i = 0; i < spaces; i++){
+                fprintf(fp, " ");
+            }
+        }
+        fprintf(fp, "%c   \n", RIGHT_DOWN_CORNER);
+        fprintf(fp, "   | }\n\n");
+
+    }
+	
+}
+
+/*
+*/
+void MZ_print_matrix_by_index(FILE *fp, unsigned int index, MZ_Matrix mat){
+	
+    #if VISUALIZE_RATIONAL
+	int spaces = 12;
+    #else
+    int spaces = 11;
+    #endif
+    
+    fprintf(fp, "\n\n   | [MATRIX %d] of size %ux%u: {\n", index, mat.rows, mat.cols);
+
+    if(mat.elements == NULL){
+
+        int spaces = 13;
+
+        fprintf(fp, "   |\t\t%c   ", LEFT_UP_CORNER);
+        for(unsigned int i = 0; i < 2; i++){
+            for(int i = 0; i < spaces; i++){
+                fprintf(fp, " ");
+            }	
+        }
+        fprintf(fp, "    %c   \n", RIGHT_UP_CORNER);
+        
+        for(unsigned int i = 0; i < 2; i++){
+            
+            fprintf(fp, "   |\t\t%c   ", SIDE_CHAR);
+            
+            for(unsigned int j = 0; j < 2; j++){
+                fprintf(fp, "%-13s ", MZ_NULL_MATRIX);
+            }		
+            fprintf(fp, "  %c\n", SIDE_CHAR);
+        }
+
+        fprintf(fp, "   |\t\t%c   ", LEFT_DOWN_CORNER);
+        for(unsigned int i = 0; i < 2; i++){
+            for(int i = 0; i < spaces; i++){
+                fprintf(fp, " ");
+            }
+        }
+        fprintf(fp, "    %c   \n", RIGHT_DOWN_CORNER);
+        fprintf(fp, "   | }\n\n");
+
+    }else {
+
+        fprintf(fp, "   |\t\t%c   ", LEFT_UP_CORNER);
+        for(unsigned int i = 0; i < mat.cols; i++){
+            for(int i = 0; i < spaces; i++){
+                fprintf(fp, " ");
+            }	
+        }
+        fprintf(fp, "%c   \n", RIGHT_UP_CORNER);
+	
+        for(unsigned int i = 0; i < mat.rows; i++){
+            
+            fprintf(fp, "   |\t\t%c   ", SIDE_CHAR);
+            
+            for(unsigned int j = 0; j < mat.cols; j++){
+                #if !VISUALIZE_RATIONAL
+                fprintf(fp, "%-11f", MZ_VALUE_OF_MAT_AT(mat, i, j));
+                #else
+                zstring value = rationalizeFloatToStr(MZ_VALUE_OF_MAT_AT(mat, i, j), 3);
+                fprintf(fp, " %-11s", value.data);
+                #endif
+            }		
+            fprintf(fp, "%c\n", SIDE_CHAR);
+        }
+
+        fprintf(fp, "   |\t\t%c   ", LEFT_DOWN_CORNER);
+        for(unsigned int i = 0; i < mat.cols; i++){
+            for(int i = 0; i < spaces; i++){
+                fprintf(fp, " ");
+            }
+        }
+        fprintf(fp, "%c   \n", RIGHT_DOWN_CORNER);
+        fprintf(fp, "   | }\n\n");
+
+    }
+	
+}
+
+/*
+*/
+void MZ_free_matrix(MZ_Matrix* mat){
+    MZ_assert(mat->elements != NULL, "Matrix must not be NULL.");
+
+    if(!mat->borrowed){
+        MZ_FREE(mat->elements, (size_t)mat->rows * MZ_STRIDE_OF_MATRIX(*mat), float);
+    }
+    mat->elements = NULL;
+    mat->rows = 0;
+    mat->cols = 0;
+    mat->stride = 0;
+    mat->borrowed = false;
+}
+
+/*
+*/
+MZ_Matrix MZ_wrap_matrix(float* elements, unsigned int rows, unsigned int cols, unsigned int stride){
+
+    MZ_assert(elements != NULL || rows == 0 || cols == 0, "Elements must not be NULL.");
+    MZ_assert(stride == 0 || stride >= cols, "Stride must not be smaller than the cols.");
+
+    MZ_Matrix result = { rows, cols, elements, stride, true };
+
+    return result;
+}
+
+/*
+*/
+void MZ_copy_matrix_pointer(MZ_Matrix *source, MZ_Matrix *dest){
+
+    if(dest->elements == NULL){ 
+        *dest= MZ_alloc_matrix(source->rows, source->cols); 
+    }
+
+    dest->rows = source->rows;
+    dest->cols = source->cols;
+    dest->elements = source->elements;
+    dest->stride = source->stride;
+
+    memcpy(dest, source, sizeof(MZ_Matrix));
+
+}
+
+/*
+*/
+MZ_Matrix MZ_alloc_matrix(unsigned int rows, unsigned int cols){
+
+    MZ_Matrix result;
+    result.rows = rows;
+    result.cols = cols;
+    result.stride = cols;
+    result.borrowed = false;
+
+    result.elements = MZ_ALLOC((size_t)rows * cols, float);
+
+    MZ_assert(result.elements != NULL, MZ_ALLOC_ERROR);
+
+    return result;
+
+}
+
+/*
+*/
+MZ_Matrix MZ_alloc_padded_matrix(unsigned int rows, unsigned int cols){
+
+    const unsigned int line = _MZ_ALIGNMENT / sizeof(float);
+
+    MZ_Matrix result;
+    result.rows = rows;
+    result.cols = cols;
+    result.stride = (cols + line - 1) / line * line;
+    result.borrowed = false;
+
+    result.elements = MZ_ALLOC((size_t)rows * result.stride, float);
+
+    MZ_assert(result.elements != NULL, MZ_ALLOC_ERROR);
+
+    return result;
+
+}
+
+// true if the elements of two non empty matrices share some memory, like two views of the same matrix can
+static bool _MZ_matrices_overlap(MZ_Matrix a, MZ_Matrix b){
+
+    const float* aEnd = &MZ_VALUE_OF_MAT_AT(a, a.rows - 1, a.cols);
+    const float* bEnd = &MZ_VALUE_OF_MAT_AT(b, b.rows - 1, b.cols);
+
+    return a.elements < bEnd && b.elements < aEnd;
+}
+
+/*
+*/
+void MZ_copy_matrix_into(MZ_Matrix* dest, MZ_Matrix source){
+
+    MZ_assert(dest->rows == source.rows && dest->cols == source.cols, MZ_EQUAL_ERROR);
+
+    if(source.rows == 0 || source.cols == 0) return;
+
+    if(dest->elements == source.elements && MZ_STRIDE_OF_MATRIX(*dest) == MZ_STRIDE_OF_MATRIX(source)) return;
+
+    // overlapping views of the same matrix, the source is staged in a packed copy first
+    if(_MZ_matrices_overlap(*dest, source)){
+        _MZ_Scratch scratch = _MZ_scratch_begin();
+        MZ_Matrix staged = MZ_alloc_matrix(source.rows, source.cols);
+        MZ_copy_matrix_into(&staged, source);
+        MZ_copy_matrix_into(dest, staged);
+        _MZ_scratch_end(scratch);
+        return;
+    }
+
+    if(_MZ_is_matrix_packed(*dest) && _MZ_is_matrix_packed(source)){
+        memcpy(dest->elements, source.elements, (size_t)source.rows * source.cols * sizeof(float));
+        return;
+    }
+
+    for(unsigned int i = 0; i < source.rows; i++){
+        memcpy(&MZ_VALUE_OF_MAT_POINTER_AT(dest, i, 0), &MZ_VALUE_OF_MAT_AT(source, i, 0), source.cols * sizeof(float));
+    }
+
+}
+
+/*
+*/
+MZ_Matrix MZ_new_zero_matrix(unsigned int rows, unsigned int cols){
+
+    MZ_Matrix result = MZ_alloc_matrix(rows, cols);
+
+    for(unsigned int i = 0; i < rows; i++){
+        for(unsigned int j = 0; j < cols; j++){
+            MZ_VALUE_OF_MAT_AT(result, i, j) = 0.0f;
+        }
+    }
+
+    return result;
+
+}
+
+/*
+*/
+MZ_Matrix MZ_new_random_float_matrix(unsigned int rows, unsigned int cols, float min, float max){
+
+    MZ_Matrix result = MZ_alloc_matrix(rows, cols);
+    
+    MZ_SRAND();
+
+    for(unsigned int i = 0; i < rows; i++){
+        for(unsigned int j = 0; j < cols; j++){
+            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_rand_float(min, max);
+        }
+    }
+
+    return result;
+   
+}
+
+/*
+*/
+MZ_Matrix MZ_new_random_int_matrix(unsigned int rows, unsigned int cols, int min, int max){
+
+    MZ_Matrix result = MZ_alloc_matrix(rows, cols);
+
+    MZ_SRAND();
+
+    for(unsigned int i = 0; i < rows; i++){
+        for(unsigned int j = 0; j < cols; j++){
+            MZ_VALUE_OF_MAT_AT(result, i, j) = (float)MZ_rand_int(min, max);
+        }
+    }
+
+    return result;
+   
+}
+
+/*
+*/
+MZ_Matrix MZ_new_default_matrix(unsigned int rows, unsigned int cols, float value){
+
+    MZ_Matrix result = MZ_alloc_matrix(rows, cols);
+
+    for(unsigned int i = 0; i < rows; i++){
+        for(unsigned int j = 0; j < cols; j++){
+            MZ_VALUE_OF_MAT_AT(result, i, j) = value;
+        }
+    }
+
+    return result;
+
+}
+
+MZ_Matrix MZ_new_identity_matrix(unsigned int dim){
+    MZ_Matrix result = MZ_alloc_matrix(dim, dim);
+
+    for(unsigned int i = 0; i < dim; i++){
+        for(unsigned int j = 0; j < dim; j++){
+            if(i == j){
+                MZ_VALUE_OF_MAT_AT(result, i, j) = 1.0f;
+            }else {
+                MZ_VALUE_OF_MAT_AT(result, i, j) = 0.0f;
+            }
+        }
+    }
+
+    return result;
+
+}
+
+/*
+*/
+MZ_Matrix _MZ_new_matrix(unsigned int rows, unsigned int cols, unsigned int numVals, ...){
+
+    MZ_Matrix result = MZ_alloc_matrix(rows, cols);
+    
+    va_list args;
+    va_start(args, numVals);
+
+    unsigned int vals = 0;
+
+    for(unsigned int i = 0; i < result.rows; i++){
+        for(unsigned int j = 0 ; j < result.cols; j++){
+            if(vals++ < numVals){
+                MZ_VALUE_OF_MAT_AT(result, i, j) =  va_arg(args, double);
+            }else {
+                MZ_VALUE_OF_MAT_AT(result, i, j) = 0.0f;
+            }
+        }
+    }
+
+    va_end(args);
+
+    return result;
+
+}
+
+/*
+*/
+MZ_Matrix MZ_Vector_to_matrix(MZ_Vec source, Direction dir){
+
+    MZ_assert(dir < DIR_COUNT, MZ_DIRECTION_ERROR);
+
+    MZ_Matrix result;
+
+    switch(dir){
+        case HORIZONTAL: {
+            result = MZ_alloc_matrix(1, MZ_DIM_OF_VECTOR(source));
+
+            for(unsigned int i = 0; i < result.cols; i++){
+                MZ_VALUE_OF_MAT_AT(result, 0, i) = source.elements[i];
+            }       
+
+        } break;
+        case VERTICAL: {
+            result = MZ_alloc_matrix(source.dim, 1); 
+
+            for(unsigned int i = 0; i < result.rows; i++){
+                MZ_VALUE_OF_MAT_AT(result, i, 0) = source.elements[i];
+            }  
+
+        } break;
+        default: break;
+    }
+
+    return result;
+
+}
+
+/*
+*/
+MZ_Vec MZ_Matrix_to_vector(MZ_Matrix source){
+
+    MZ_Vec result = MZ_alloc_vector(source.rows * source.cols);   
+
+    for(unsigned int i = 0; i < source.rows; i++){
+        for(unsigned int j = 0; j < source.cols; j++){
+            result.elements[j + i * source.cols] = MZ_VALUE_OF_MAT_AT(source, i, j);
+        }
+    }
+
+    return result;
+}
+
+/*
+*/
+MZ_Vec MZ_get_vector_from_matrix_row(MZ_Matrix source, unsigned int row){
+
+    if(row == 0 || row > source.rows){ return NULL_VECTOR; }
+
+    MZ_Vec result = MZ_alloc_vector(source.cols);   
+
+    MZ_get_vector_from_matrix_row_into(&result, source, row);
+
+    return result;
+}
+
+/*
+*/
+bool MZ_get_vector_from_matrix_row_into(MZ_Vec* dest, MZ_Matrix source, unsigned int row){
+
+    if(row == 0 || row > source.rows){ return false; }
+
+    MZ_assert(dest->dim == source.cols, MZ_EQUAL_ERROR);
+
+    row--;
+
+    for(unsigned int i = 0; i < source.cols; i++){
+        dest->elements[i] = MZ_VALUE_OF_MAT_AT(source, row, i);
+    }
+
+    return true;
+}
+
+/*
+*/
+MZ_Vec MZ_get_vector_from_matrix_col(MZ_Matrix source, unsigned int col){
+
+    if(col == 0 || col > source.cols){ return NULL_VECTOR; }
+
+    MZ_Vec result = MZ_alloc_vector(source.rows);   
+
+    MZ_get_vector_from_matrix_col_into(&result, source, col);
+
+    return result;
+}
+
+/*
+*/
+bool MZ_get_vector_from_matrix_col_into(MZ_Vec* dest, MZ_Matrix source, unsigned int col){
+
+    if(col == 0 || col > source.cols){ return false; }
+
+    MZ_assert(dest->dim == source.rows, MZ_EQUAL_ERROR);
+
+    col--;
+
+    for(unsigned int i = 0; i < source.rows; i++){
+        dest->elements[i] = MZ_VALUE_OF_MAT_AT(source, i, col);
+    }
+
+    return true;
+}
+
+/*
+*/
+MZ_Vec MZ_view_of_matrix_row(MZ_Matrix source, unsigned int row){
+
+    if(row == 0 || row > source.rows){ return NULL_VECTOR; }
+
+    MZ_Vec result = { source.cols, &MZ_VALUE_OF_MAT_AT(source, row - 1, 0), true };
+
+    return result;
+}
+
+/*
+*/
+MZ_Matrix MZ_view_of_matrix_col(MZ_Matrix source, unsigned int col){
+
+    return MZ_view_of_matrix_block(source, 0, col - 1, source.rows, 1);
+}
+
+/*
+*/
+MZ_Matrix MZ_view_of_matrix_block(MZ_Matrix source, unsigned int row, unsigned int col, unsigned int rows, unsigned int cols){
+
+    // compared as differences so that a col of 0 - 1 from MZ_view_of_matrix_col is rejected too
+    if(row > source.rows || rows > source.rows - row || col >= source.cols || cols > source.cols - col){ return NULL_MATRIX; }
+
+    MZ_Matrix result = { rows, cols, &MZ_VALUE_OF_MAT_AT(source, row, 0) + col, MZ_STRIDE_OF_MATRIX(source), true };
+
+    return result;
+}
+
+/*
+*/
+MZ_Matrix MZ_reshaped_view_of_matrix(MZ_Matrix source, unsigned int rows, unsigned int cols){
+
+    MZ_assert(_MZ_is_matrix_packed(source), "Matrix rows must not be padded.");
+    MZ_assert((size_t)rows * cols == (size_t)source.rows * source.cols, MZ_EQUAL_ERROR);
+
+    MZ_Matrix result = { rows, cols, source.elements, 0, true };
+
+    return result;
+}
+
+/*
+*/
+MZ_Vec MZ_view_of_matrix_as_vector(MZ_Matrix source){
+
+    MZ_assert(_MZ_is_matrix_packed(source), "Matrix rows must not be padded.");
+
+    MZ_Vec result = { (size_t)source.rows * source.cols, source.elements, true };
+
+    return result;
+}
+
+/*
+*/
+MZ_Matrix MZ_view_of_vector_as_matrix(MZ_Vec source, unsigned int rows, unsigned int cols){
+
+    MZ_assert((size_t)rows * cols == source.dim, MZ_EQUAL_ERROR);
+
+    MZ_Matrix result = { rows, cols, source.elements, 0, true };
+
+    return result;
+}
+
+/*
+    Batched projections: the norm of B is computed once, then every row costs one dot
+    product and, for the vector projection, one scaled copy of B while it is still in cache.
+*/
+typedef struct _MZ_ProjRowsJob{
+    MZ_Matrix vectors;
+    const float* b;
+    double norm;
+    float* scalars;
+    MZ_Matrix* dest;
+}_MZ_ProjRowsJob;
+
+static void _MZ_proj_rows(void* ctx, size_t begin, size_t end){
+
+    _MZ_ProjRowsJob* job = (_MZ_ProjRowsJob*)ctx;
+    size_t n = job->vectors.cols;
+
+    for(size_t i = begin; i < end; i++){
+        double dot = _MZ_dot(&MZ_VALUE_OF_MAT_AT(job->vectors, i, 0), job->b, n);
+        float scalar = dot == 0.0 ? 0.0f : (float)(dot / job->norm);
+
+        if(job->scalars != NULL){
+            job->scalars[i] = scalar;
+        }else {
+            _MZ_element_kernels[_MZ_current_isa()](&MZ_VALUE_OF_MAT_POINTER_AT(job->dest, i, 0), job->b, NULL, scalar, n, _MZ_OP_MUL);
+        }
+    }
+}
+
+static void _MZ_proj_rows_on_b(MZ_Matrix vectors_A, MZ_Vec vector_B, float* scalars, MZ_Matrix* dest){
+
+    MZ_assert(vectors_A.cols == vector_B.dim, MZ_EQUAL_ERROR);
+
+    _MZ_ProjRowsJob job = { vectors_A, vector_B.elements, _MZ_dot(vector_B.elements, vector_B.elements, vector_B.dim), scalars, dest };
+
+    size_t grain = MZ_PARALLEL_THRESHOLD / (vectors_A.cols == 0 ? 1 : vectors_A.cols) + 1;
+    _MZ_parallel_for(vectors_A.rows, grain, _MZ_proj_rows, &job);
+}
+
+/*
+*/
+MZ_Vec MZ_scalar_proj_rows_on_b(MZ_Matrix vectors_A, MZ_Vec vector_B){
+
+    MZ_Vec result = MZ_alloc_vector(vectors_A.rows);
+
+    _MZ_proj_rows_on_b(vectors_A, vector_B, result.elements, NULL);
+
+    return result;
+}
+
+/*
+*/
+MZ_Matrix MZ_vector_proj_rows_on_b(MZ_Matrix vectors_A, MZ_Vec vector_B){
+
+    MZ_Matrix result = MZ_alloc_matrix(vectors_A.rows, vectors_A.cols);
+
+    MZ_vector_proj_rows_on_b_into(&result, vectors_A, vector_B);
+
+    return result;
+}
+
+/*
+*/
+void MZ_vector_proj_rows_on_b_into(MZ_Matrix* dest, MZ_Matrix vectors_A, MZ_Vec vector_B){
+
+    MZ_assert(dest->rows == vectors_A.rows && dest->cols == vectors_A.cols, MZ_EQUAL_ERROR);
+
+    // each row is read before it is overwritten, so dest can be vectors_A
+    _MZ_proj_rows_on_b(vectors_A, vector_B, NULL, dest);
+}
+
+/*
+*/
+MZ_Matrix MZ_flatten_matrix(MZ_Matrix matrix, Direction dir){
+    MZ_Matrix result;
+
+    switch(dir){
+        case VERTICAL:{
+            result = MZ_alloc_matrix(matrix.rows * matrix.cols, 1);
+        }break;
+        case HORIZONTAL:{
+            result = MZ_alloc_matrix(1, matrix.rows * matrix.cols);
+        }break;
+    }
+
+    for(unsigned int i = 0; i < matrix.rows; i++){
+        for(unsigned int j = 0; j < matrix.cols; j++){
+            switch(dir){
+                case VERTICAL:{
+                    MZ_VALUE_OF_MAT_AT(result, i*matrix.cols + j, 0) = MZ_VALUE_OF_MAT_AT(matrix, i, j);
+                }break;
+                case HORIZONTAL:{
+                    MZ_VALUE_OF_MAT_AT(result, 0, i*matrix.cols + j) = MZ_VALUE_OF_MAT_AT(matrix, i, j);
+                }break;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*
+*/
+MZ_Matrix MZ_add_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2){
+
+    MZ_assert(matrix1.rows == matrix2.rows && matrix1.cols == matrix2.cols, MZ_EQUAL_ERROR);
+
+    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
+
+    MZ_add_two_matrices_into(&result, matrix1, matrix2);
+
+    return result;
+
+}
+
+/*
+*/
+void MZ_add_two_matrices_into(MZ_Matrix* dest, MZ_Matrix matrix1, MZ_Matrix matrix2){
+
+    MZ_assert(matrix1.rows == matrix2.rows && matrix1.cols == matrix2.cols &&
+              dest->rows == matrix1.rows && dest->cols == matrix1.cols, MZ_EQUAL_ERROR);
+
+    _MZ_elementwise_matrix(dest, matrix1, &matrix2, 0.0f, _MZ_OP_ADD);
+
+}
+
+/*
+*/
+MZ_Matrix MZ_add_matrix_with_scalar(MZ_Matrix matrix1, float scalar){
+    
+    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
+
+    MZ_add_matrix_with_scalar_into(&result, matrix1, scalar);
+
+    return result;
+
+}
+
+/*
+*/
+void MZ_add_matrix_with_scalar_into(MZ_Matrix* dest, MZ_Matrix matrix1, float scalar){
+
+    MZ_assert(dest->rows == matrix1.rows && dest->cols == matrix1.cols, MZ_EQUAL_ERROR);
+
+    _MZ_elementwise_matrix(dest, matrix1, NULL, scalar, _MZ_OP_ADD);
+
+}
+
+/*
+*/
+MZ_Matrix MZ_subtract_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2){
+
+    MZ_assert(matrix1.rows == matrix2.rows && matrix1.cols == matrix2.cols, MZ_EQUAL_ERROR);
+
+    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
+
+    MZ_subtract_two_matrices_into(&result, matrix1, matrix2);
+
+    return result;
+
+}
+
+/*
+*/
+void MZ_subtract_two_matrices_into(MZ_Matrix* dest, MZ_Matrix matrix1, MZ_Matrix matrix2){
+
+    MZ_assert(matrix1.rows == matrix2.rows && matrix1.cols == matrix2.cols &&
+              dest->rows == matrix1.rows && dest->cols == matrix1.cols, MZ_EQUAL_ERROR);
+
+    _MZ_elementwise_matrix(dest, matrix1, &matrix2, 0.0f, _MZ_OP_SUB);
+
+}
+
+/*
+*/
+MZ_Matrix MZ_subtract_matrix_with_scalar(MZ_Matrix matrix1, float scalar){
+    
+    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
+
+    MZ_subtract_matrix_with_scalar_into(&result, matrix1, scalar);
+
+    return result;
+
+}
+
+/*
+*/
+void MZ_subtract_matrix_with_scalar_into(MZ_Matrix* dest, MZ_Matrix matrix1, float scalar){
+
+    MZ_assert(dest->rows == matrix1.rows && dest->cols == matrix1.cols, MZ_EQUAL_ERROR);
+
+    _MZ_elementwise_matrix(dest, matrix1, NULL, scalar, _MZ_OP_SUB);
+
+}
+
+/*
+    Blocking of the GEMM kernel: a KC x NC panel of B is packed to stay in L3, an MC x KC block of A
+    is packed to stay in L2 and the MR x NR tile of C is accumulated in registers by the micro-kernel.
+*/
+#if defined(__GNUC__)
+#if defined(__AVX__)
+#define _MZ_GEMM_VEC 8
+#else
+#define _MZ_GEMM_VEC 4
+#endif
+typedef float _MZ_gemm_vec __attribute__((vector_size(_MZ_GEMM_VEC * sizeof(float)), aligned(sizeof(float))));
+#else
+#define _MZ_GEMM_VEC 4
+#endif
+
+#define _MZ_GEMM_MR 6
+#define _MZ_GEMM_NR (2 * _MZ_GEMM_VEC)
+#define _MZ_GEMM_MC 96
+#define _MZ_GEMM_KC 256
+#define _MZ_GEMM_NC 2048
+
+/*
+    Products smaller than this (in multiply-adds) skip the packing and use a plain row-oriented loop.
+*/
+#define _MZ_GEMM_SMALL (48 * 48 * 48)
+
+/*
+    Packs an mc x kc block of A in slivers of MR rows, each stored column by column, scaled by alpha and zero padded.
+    When A is transposed the block is read from the kc x mc block of its storage.
+*/
+static void _MZ_gemm_pack_a(const float* a, size_t lda, bool trans, size_t mc, size_t kc, float alpha, float* restrict packed){
+
+    for(size_t i0 = 0; i0 < mc; i0 += _MZ_GEMM_MR){
+        size_t mr = mc - i0 < _MZ_GEMM_MR ? mc - i0 : _MZ_GEMM_MR;
+        for(size_t p = 0; p < kc; p++){
+            size_t i = 0;
+            if(trans){
+                const float* src = a + p * lda + i0;
+                for(; i < mr; i++){
+                    packed[i] = alpha * src[i];
+                }
+            }else {
+                for(; i < mr; i++){
+                    packed[i] = alpha * a[(i0 + i) * lda + p];
+                }
+            }
+            for(; i < _MZ_GEMM_MR; i++){
+                packed[i] = 0.0f;
+            }
+            packed += _MZ_GEMM_MR;
+        }
+    }
+}
+
+/*
+    Packs a kc x nc panel of B in slivers of NR columns, each stored row by row and zero padded.
+    When B is transposed the panel is read from the nc x kc block of its storage, one row per column.
+*/
+static void _MZ_gemm_pack_b(const float* b, size_t ldb, bool trans, size_t kc, size_t nc, float* restrict packed){
+
+    for(size_t j0 = 0; j0 < nc; j0 += _MZ_GEMM_NR){
+        size_t nr = nc - j0 < _MZ_GEMM_NR ? nc - j0 : _MZ_GEMM_NR;
+        if(trans){
+            for(size_t j = 0; j < _MZ_GEMM_NR; j++){
+                const float* src = b + (j0 + j) * ldb;
+                for(size_t p = 0; p < kc; p++){
+                    packed[p * _MZ_GEMM_NR + j] = j < nr ? src[p] : 0.0f;
+                }
+            }
+            packed += kc * _MZ_GEMM_NR;
+            continue;
+        }
+        for(size_t p = 0; p < kc; p++){
+            const float* src = b + p * ldb + j0;
+            size_t j = 0;
+            for(; j < nr; j++){
+                packed[j] = src[j];
+            }
+            for(; j < _MZ_GEMM_NR; j++){
+                packed[j] = 0.0f;
+            }
+            packed += _MZ_GEMM_NR;
+        }
+    }
+}
+
+/*
+    Computes the MR x NR tile A_sliver * B_sliver in registers and stores the mr x nr valid part in C
+    as tile + beta * C, C not being read when beta is 0.
+*/
+static void _MZ_gemm_micro_kernel(size_t kc, const float* restrict a, const float* restrict b,
+                                  float* c, size_t ldc, size_t mr, size_t nr, float beta){
+
+    float acc[_MZ_GEMM_MR][_MZ_GEMM_NR];
+
+    #if defined(__GNUC__)
+    // two vectors of B per step, broadcast against every row of the sliver of A
+    _MZ_gemm_vec acc0[_MZ_GEMM_MR], acc1[_MZ_GEMM_MR];
+
+    #pragma GCC unroll 8
+    for(size_t i = 0; i < _MZ_GEMM_MR; i++){
+        acc0[i] = (_MZ_gemm_vec){0};
+        acc1[i] = (_MZ_gemm_vec){0};
+    }
+
+    for(size_t p = 0; p < kc; p++){
+        _MZ_gemm_vec b0 = *(const _MZ_gemm_vec*)b;
+        _MZ_gemm_vec b1 = *(const _MZ_gemm_vec*)(b + _MZ_GEMM_VEC);
+        #pragma GCC unroll 8
+        for(size_t i = 0; i < _MZ_GEMM_MR; i++){
+            acc0[i] += a[i] * b0;
+            acc1[i] += a[i] * b1;
+        }
+        a += _MZ_GEMM_MR;
+        b += _MZ_GEMM_NR;
+    }
+
+    for(size_t i = 0; i < _MZ_GEMM_MR; i++){
+        memcpy(&acc[i][0], &acc0[i], sizeof(_MZ_gemm_vec));
+        memcpy(&acc[i][_MZ_GEMM_VEC], &acc1[i], sizeof(_MZ_gemm_vec));
+    }
+    #else
+    for(size_t i = 0; i < _MZ_GEMM_MR; i++){
+        for(size_t j = 0; j < _MZ_GEMM_NR; j++){
+            acc[i][j] = 0.0f;
+        }
+    }
+
+    for(size_t p = 0; p < kc; p++){
+        for(size_t i = 0; i < _MZ_GEMM_MR; i++){
+            float ai = a[i];
+            for(size_t j = 0; j < _MZ_GEMM_NR; j++){
+                acc[i][j] += ai * b[j];
+            }
+        }
+        a += _MZ_GEMM_MR;
+        b += _MZ_GEMM_NR;
+    }
+    #endif
+
+    for(size_t i = 0; i < mr; i++){
+        float* row = c + i * ldc;
+        if(beta == 0.0f){
+            for(size_t j = 0; j < nr; j++) row[j] = acc[i][j];
+        }else if(beta == 1.0f){
+            for(size_t j = 0; j < nr; j++) row[j] += acc[i][j];
+        }else {
+            for(size_t j = 0; j < nr; j++) row[j] = acc[i][j] + beta * row[j];
+        }
+    }
+}
+
+/*
+    Products larger than this (in multiply-adds) are split across the thread pool, one task per grain.
+*/
+#define _MZ_GEMM_PARALLEL_GRAIN ((size_t)MZ_PARALLEL_THRESHOLD * 64)
+
+typedef struct _MZ_GemmJob{
+    size_t m;
+    bool transA;
+    bool transB;
+    float alpha;
+    float beta;
+    const float* a;
+    size_t lda;
+    const float* b;
+    size_t ldb;
+    float* c;
+    size_t ldc;
+    size_t jc;
+    size_t nc;
+    size_t pc;
+    size_t kc;
+    float* packedB;
+    float* packedA;
+    size_t packedASize;
+    bool splitRows;
+}_MZ_GemmJob;
+
+static void _MZ_gemm_pack_b_range(void* ctx, size_t begin, size_t end){
+
+    _MZ_GemmJob* job = (_MZ_GemmJob*)ctx;
+
+    size_t j0 = begin * _MZ_GEMM_NR;
+    size_t j1 = end * _MZ_GEMM_NR < job->nc ? end * _MZ_GEMM_NR : job->nc;
+
+    const float* b = job->transB ? job->b + (job->jc + j0) * job->ldb + job->pc : job->b + job->pc * job->ldb + job->jc + j0;
+
+    _MZ_gemm_pack_b(b, job->ldb, job->transB, job->kc, j1 - j0, job->packedB + j0 * job->kc);
+}
+
+static void _MZ_gemm_task(void* ctx, unsigned int task, unsigned int tasks){
+
+    _MZ_GemmJob* job = (_MZ_GemmJob*)ctx;
+
+    size_t blocks = (job->m + _MZ_GEMM_MC - 1) / _MZ_GEMM_MC;
+    size_t slivers = (job->nc + _MZ_GEMM_NR - 1) / _MZ_GEMM_NR;
+
+    size_t blockBegin = 0, blockEnd = blocks;
+    size_t sliverBegin = 0, sliverEnd = slivers;
+
+    if(job->splitRows){
+        blockBegin = blocks * task / tasks;
+        blockEnd = blocks * (task + 1) / tasks;
+    }else {
+        sliverBegin = slivers * task / tasks;
+        sliverEnd = slivers * (task + 1) / tasks;
+    }
+
+    float* packedA = job->packedA + job->packedASize * task;
+
+    for(size_t block = blockBegin; block < blockEnd; block++){
+        size_t ic = block * _MZ_GEMM_MC;
+        size_t mc = job->m - ic < _MZ_GEMM_MC ? job->m - ic : _MZ_GEMM_MC;
+
+        const float* a = job->transA ? job->a + job->pc * job->lda + ic : job->a + ic * job->lda + job->pc;
+
+        _MZ_gemm_pack_a(a, job->lda, job->transA, mc, job->kc, job->alpha, packedA);
+
+        for(size_t sliver = sliverBegin; sliver < sliverEnd; sliver++){
+            size_t jr = sliver * _MZ_GEMM_NR;
+            size_t nr = job->nc - jr < _MZ_GEMM_NR ? job->nc - jr : _MZ_GEMM_NR;
+            for(size_t ir = 0; ir < mc; ir += _MZ_GEMM_MR){
+                size_t mr = mc - ir < _MZ_GEMM_MR ? mc - ir : _MZ_GEMM_MR;
+                _MZ_gemm_micro_kernel(job->kc, packedA + ir * job->kc, job->packedB + jr * job->kc,
+                                      job->c + (ic + ir) * job->ldc + job->jc + jr, job->ldc, mr, nr, job->pc != 0 ? 1.0f : job->beta);
+            }
+        }
+    }
+}
+
+// row = beta * row, without reading it when beta is 0
+static inline void _MZ_scale_row(float* row, size_t n, float beta){
+
+    if(beta == 0.0f){
+        memset(row, 0, n * sizeof(float));
+    }else if(beta != 1.0f){
+        for(size_t j = 0; j < n; j++) row[j] *= beta;
+    }
+}
+
+/*
+    C = alpha * op(A) * op(B) + beta * C on row-major storage, op(A) is m x k, op(B) is k x n and C is m x n.
+    A transposed operand is read from its own storage, nothing is copied besides the packing.
+*/
+static void _MZ_gemm(bool transA, bool transB, size_t m, size_t n, size_t k, float alpha,
+                     const float* a, size_t lda, const float* b, size_t ldb, float beta, float* c, size_t ldc){
+
+    if(k == 0 || alpha == 0.0f){
+        for(size_t i = 0; i < m; i++){
+            _MZ_scale_row(c + i * ldc, n, beta);
+        }
+        return;
+    }
+
+    if(m * n * k <= _MZ_GEMM_SMALL){
+        for(size_t i = 0; i < m; i++){
+            float* row = c + i * ldc;
+            _MZ_scale_row(row, n, beta);
+            for(size_t p = 0; p < k; p++){
+                float aip = alpha * (transA ? a[p * lda + i] : a[i * lda + p]);
+                if(transB){
+                    for(size_t j = 0; j < n; j++){
+                        row[j] += aip * b[j * ldb + p];
+                    }
+                }else {
+                    const float* src = b + p * ldb;
+                    for(size_t j = 0; j < n; j++){
+                        row[j] += aip * src[j];
+                    }
+                }
+            }
+        }
+        return;
+    }
+
+    size_t kcMax = k < _MZ_GEMM_KC ? k : _MZ_GEMM_KC;
+    size_t ncMax = n < _MZ_GEMM_NC ? n : _MZ_GEMM_NC;
+    size_t mcMax = m < _MZ_GEMM_MC ? m : _MZ_GEMM_MC;
+
+    unsigned int tasks = _MZ_parallel_tasks(m * n * k, _MZ_GEMM_PARALLEL_GRAIN);
+
+    size_t packedBSize = kcMax * ((ncMax + _MZ_GEMM_NR - 1) / _MZ_GEMM_NR) * _MZ_GEMM_NR;
+    size_t packedASize = kcMax * ((mcMax + _MZ_GEMM_MR - 1) / _MZ_GEMM_MR) * _MZ_GEMM_MR;
+
+    // one packed panel of B shared by every task, one packed block of A per task
+    _MZ_Scratch scratch = _MZ_scratch_begin();
+
+    // packing overwrites every element it reads back, no need to clear the buffer
+    float* packedB = (float*)MZ_arena_alloc(&_MZ_scratch_arena, (packedBSize + packedASize * tasks) * sizeof(float));
+    MZ_assert(packedB != NULL, MZ_ALLOC_ERROR);
+
+    _MZ_GemmJob job;
+    job.m = m;
+    job.transA = transA;
+    job.transB = transB;
+    job.alpha = alpha;
+    job.beta = beta;
+    job.a = a;
+    job.lda = lda;
+    job.b = b;
+    job.ldb = ldb;
+    job.c = c;
+    job.ldc = ldc;
+    job.packedB = packedB;
+    job.packedA = packedB + packedBSize;
+    job.packedASize = packedASize;
+
+    for(size_t jc = 0; jc < n; jc += _MZ_GEMM_NC){
+        size_t nc = n - jc < _MZ_GEMM_NC ? n - jc : _MZ_GEMM_NC;
+
+        for(size_t pc = 0; pc < k; pc += _MZ_GEMM_KC){
+            size_t kc = k - pc < _MZ_GEMM_KC ? k - pc : _MZ_GEMM_KC;
+
+            job.jc = jc;
+            job.nc = nc;
+            job.pc = pc;
+            job.kc = kc;
+
+            size_t slivers = (nc + _MZ_GEMM_NR - 1) / _MZ_GEMM_NR;
+            _MZ_parallel_for(slivers, (slivers + tasks - 1) / tasks, _MZ_gemm_pack_b_range, &job);
+
+            // split the row blocks of C between the tasks, or its column slivers when there are too few rows
+            job.splitRows = (m + _MZ_GEMM_MC - 1) / _MZ_GEMM_MC >= tasks;
+            _MZ_parallel_run(tasks, _MZ_gemm_task, &job);
+        }
+    }
+
+    _MZ_scratch_end(scratch);
+}
+
+/*
+*/
+MZ_Matrix MZ_multiply_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2){
+
+    MZ_assert(matrix1.cols == matrix2.rows, MZ_PROD_ERROR);
+
+    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix2.cols);
+
+    MZ_multiply_two_matrices_into(&result, matrix1, matrix2);
+
+    return result;
+
+}
+
+/*
+*/
+void MZ_multiply_two_matrices_into(MZ_Matrix* dest, MZ_Matrix matrix1, MZ_Matrix matrix2){
+
+    MZ_assert(matrix1.cols == matrix2.rows, MZ_PROD_ERROR);
+    MZ_assert(dest->rows == matrix1.rows && dest->cols == matrix2.cols, MZ_EQUAL_ERROR);
+    MZ_assert(dest->elements != matrix1.elements && dest->elements != matrix2.elements, MZ_ALIAS_ERROR);
+
+    _MZ_gemm(false, false, matrix1.rows, matrix2.cols, matrix1.cols, 1.0f,
+             matrix1.elements, MZ_STRIDE_OF_MATRIX(matrix1),
+             matrix2.elements, MZ_STRIDE_OF_MATRIX(matrix2),
+             0.0f, dest->elements, MZ_STRIDE_OF_MATRIX(*dest));
+
+}
+
+/*
+*/
+void MZ_gemm(MZ_Transpose transpose_A, MZ_Transpose transpose_B, float alpha, MZ_Matrix matrix_A, MZ_Matrix matrix_B, float beta, MZ_Matrix* dest){
+
+    unsigned int m = transpose_A == MZ_TRANSPOSE ? matrix_A.cols : matrix_A.rows;
+    unsigned int k = transpose_A == MZ_TRANSPOSE ? matrix_A.rows : matrix_A.cols;
+    unsigned int kb = transpose_B == MZ_TRANSPOSE ? matrix_B.cols : matrix_B.rows;
+    unsigned int n = transpose_B == MZ_TRANSPOSE ? matrix_B.rows : matrix_B.cols;
+
+    MZ_assert(k == kb, MZ_PROD_ERROR);
+    MZ_assert(dest->rows == m && dest->cols == n, MZ_EQUAL_ERROR);
+    MZ_assert(dest->elements != matrix_A.elements && dest->elements != matrix_B.elements, MZ_ALIAS_ERROR);
+
+    _MZ_gemm(transpose_A == MZ_TRANSPOSE, transpose_B == MZ_TRANSPOSE, m, n, k, alpha,
+             matrix_A.elements, MZ_STRIDE_OF_MATRIX(matrix_A),
+             matrix_B.elements, MZ_STRIDE_OF_MATRIX(matrix_B),
+             beta, dest->elements, MZ_STRIDE_OF_MATRIX(*dest));
+
+}
+
+/*
+*/
+MZ_Matrix MZ_multiply_two_matrices_naive(MZ_Matrix matrix1, MZ_Matrix matrix2){
+
+    MZ_assert(matrix1.cols == matrix2.rows, MZ_PROD_ERROR);
+
+    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix2.cols);
+    
+    for(unsigned int i = 0; i < result.rows; i++){
+		for(unsigned int j = 0; j < result.cols; j++){
+			MZ_VALUE_OF_MAT_AT(result, i, j) = 0;
+			for(unsigned int k = 0; k < matrix2.rows; k++){
+				MZ_VALUE_OF_MAT_AT(result, i, j) += MZ_VALUE_OF_MAT_AT(matrix1, i, k) * MZ_VALUE_OF_MAT_AT(matrix2, k, j); 
+			}
+		}
+	}
+
+    return result;
+
+}
+
+/*
+    Matrix-vector products, bound by the bandwidth of the matrix: every element of A is read
+    once. A * x works on 4 rows at a time so each load of x feeds 4 rows, x * A adds 4 rows
+    of A to a range of y at a time so y goes through the cache once every 4 rows.
+*/
+typedef void (*_MZ_GemvKernel)(float* y, const float* a, size_t lda, const float* x, size_t rows, size_t cols, float alpha, float beta);
+
+// alpha * t + beta * y, y not being read when beta is 0
+static inline float _MZ_axpby(float t, float alpha, float beta, float y){
+    return beta == 0.0f ? alpha * t : alpha * t + beta * y;
+}
+
+static void _MZ_gemv_rows_scalar(float* y, const float* a, size_t lda, const float* x, size_t rows, size_t cols, float alpha, float beta){
+
+    for(size_t r = 0; r < rows; r++){
+        const float* row = a + r * lda;
+        float acc[4] = { 0.0f };
+        size_t j = 0;
+        for(; j + 4 <= cols; j += 4){
+            for(int l = 0; l < 4; l++) acc[l] += row[j + l] * x[j + l];
+        }
+        for(; j < cols; j++) acc[0] += row[j] * x[j];
+        y[r] = _MZ_axpby((acc[0] + acc[1]) + (acc[2] + acc[3]), alpha, beta, y[r]);
+    }
+}
+
+static void _MZ_gemv_cols_scalar(float* y, const float* a, size_t lda, const float* x, size_t rows, size_t cols, float alpha, float beta){
+
+    _MZ_scale_row(y, cols, beta);
+
+    size_t i = 0;
+
+    for(; i + 4 <= rows; i += 4){
+        const float* a0 = a + i * lda;
+        const float* a1 = a0 + lda;
+        const float* a2 = a1 + lda;
+        const float* a3 = a2 + lda;
+        float x0 = alpha * x[i], x1 = alpha * x[i + 1], x2 = alpha * x[i + 2], x3 = alpha * x[i + 3];
+        for(size_t j = 0; j < cols; j++){
+            y[j] += (a0[j] * x0 + a1[j] * x1) + (a2[j] * x2 + a3[j] * x3);
+        }
+    }
+    for(; i < rows; i++){
+        const float* a0 = a + i * lda;
+        float x0 = alpha * x[i];
+        for(size_t j = 0; j < cols; j++) y[j] += a0[j] * x0;
+    }
+}
+
+#if _MZ_X86_DISPATCH
+
+#define _MZ_GEMV_LOOPS(P, W, TARGET)                                                             \
+__attribute__((target(TARGET)))                                                                  \
+static void _MZ_gemv_rows_##P(float* y, const float* a, size_t lda, const float* x, size_t rows, size_t cols, float alpha, float beta){ \
+    size_t r = 0;                                                                                \
+    for(; r + 4 <= rows; r += 4){                                                                \
+        const float* a0 = a + r * lda;                                                           \
+        const float* a1 = a0 + lda;                                                              \
+        const float* a2 = a1 + lda;                                                              \
+        const float* a3 = a2 + lda;                                                              \
+        _MZ_GEMV_##P##_T s0 = _MZ_GEMV_##P##_ZERO(), s1 = s0, s2 = s0, s3 = s0;                  \
+        size_t j = 0;                                                                            \
+        for(; j + W <= cols; j += W){                                                            \
+            _MZ_GEMV_##P##_T xv = _MZ_GEMV_##P##_LOAD(x + j);                                    \
+            s0 = _MZ_GEMV_##P##_FMADD(_MZ_GEMV_##P##_LOAD(a0 + j), xv, s0);                      \
+            s1 = _MZ_GEMV_##P##_FMADD(_MZ_GEMV_##P##_LOAD(a1 + j), xv, s1);                      \
+            s2 = _MZ_GEMV_##P##_FMADD(_MZ_GEMV_##P##_LOAD(a2 + j), xv, s2);                      \
+            s3 = _MZ_GEMV_##P##_FMADD(_MZ_GEMV_##P##_LOAD(a3 + j), xv, s3);                      \
+        }                                                                                        \
+        float t0 = _MZ_GEMV_##P##_HSUM(s0), t1 = _MZ_GEMV_##P##_HSUM(s1);                        \
+        float t2 = _MZ_GEMV_##P##_HSUM(s2), t3 = _MZ_GEMV_##P##_HSUM(s3);                        \
+        for(; j < cols; j++){                                                                    \
+            t0 += a0[j] * x[j]; t1 += a1[j] * x[j]; t2 += a2[j] * x[j]; t3 += a3[j] * x[j];      \
+        }                                                                                        \
+        y[r] = _MZ_axpby(t0, alpha, beta, y[r]); y[r + 1] = _MZ_axpby(t1, alpha, beta, y[r + 1]); \
+        y[r + 2] = _MZ_axpby(t2, alpha, beta, y[r + 2]); y[r + 3] = _MZ_axpby(t3, alpha, beta, y[r + 3]); \
+    }                                                                                            \
+    for(; r < rows; r++){                                                                        \
+        const float* a0 = a + r * lda;                                                           \
+        _MZ_GEMV_##P##_T s0 = _MZ_GEMV_##P##_ZERO();                                             \
+        size_t j = 0;                                                                            \
+        for(; j + W <= cols; j += W){                                                            \
+            s0 = _MZ_GEMV_##P##_FMADD(_MZ_GEMV_##P##_LOAD(a0 + j), _MZ_GEMV_##P##_LOAD(x + j), s0); \
+        }                                                                                        \
+        float t0 = _MZ_GEMV_##P##_HSUM(s0);                                                      \
+        for(; j < cols; j++) t0 += a0[j] * x[j];                                                 \
+        y[r] = _MZ_axpby(t0, alpha, beta, y[r]);                                                 \
+    }                                                                                            \
+}                                                                                                \
+__attribute__((target(TARGET)))                                                                  \
+static void _MZ_gemv_cols_##P(float* y, const float* a, size_t lda, const float* x, size_t rows, size_t cols, float alpha, float beta){ \
+    _MZ_scale_row(y, cols, beta);                                                                \
+    size_t i = 0;                                                                                \
+    for(; i + 4 <= rows; i += 4){                                                                \
+        const float* a0 = a + i * lda;                                                           \
+        const float* a1 = a0 + lda;                                                              \
+        const float* a2 = a1 + lda;                                                              \
+        const float* a3 = a2 + lda;                                                              \
+        float s0 = alpha * x[i], s1 = alpha * x[i + 1], s2 = alpha * x[i + 2], s3 = alpha * x[i + 3]; \
+        _MZ_GEMV_##P##_T x0 = _MZ_GEMV_##P##_SET1(s0), x1 = _MZ_GEMV_##P##_SET1(s1);             \
+        _MZ_GEMV_##P##_T x2 = _MZ_GEMV_##P##_SET1(s2), x3 = _MZ_GEMV_##P##_SET1(s3);             \
+        size_t j = 0;                                                                            \
+        for(; j + W <= cols; j += W){                                                            \
+            _MZ_GEMV_##P##_T acc = _MZ_GEMV_##P##_LOAD(y + j);                                   \
+            acc = _MZ_GEMV_##P##_FMADD(_MZ_GEMV_##P##_LOAD(a0 + j), x0, acc);                    \
+            acc = _MZ_GEMV_##P##_FMADD(_MZ_GEMV_##P##_LOAD(a1 + j), x1, acc);                    \
+            acc = _MZ_GEMV_##P##_FMADD(_MZ_GEMV_##P##_LOAD(a2 + j), x2, acc);                    \
+            acc = _MZ_GEMV_##P##_FMADD(_MZ_GEMV_##P##_LOAD(a3 + j), x3, acc);                    \
+            _MZ_GEMV_##P##_STORE(y + j, acc);                                                    \
+        }                                                                                        \
+        for(; j < cols; j++){                                                                    \
+            y[j] += a0[j] * s0 + a1[j] * s1 + a2[j] * s2 + a3[j] * s3;                           \
+        }                                                                                        \
+    }                                                                                            \
+    for(; i < rows; i++){                                                                        \
+        const float* a0 = a + i * lda;                                                           \
+        float s0 = alpha * x[i];                                                                 \
+        _MZ_GEMV_##P##_T x0 = _MZ_GEMV_##P##_SET1(s0);                                           \
+        size_t j = 0;                                                                            \
+        for(; j + W <= cols; j += W){                                                            \
+            _MZ_GEMV_##P##_STORE(y + j, _MZ_GEMV_##P##_FMADD(_MZ_GEMV_##P##_LOAD(a0 + j), x0,    \
+                                                             _MZ_GEMV_##P##_LOAD(y + j)));       \
+        }                                                                                        \
+        for(; j < cols; j++) y[j] += a0[j] * s0;                                                 \
+    }                                                                                            \
+}
+
+__attribute__((target("sse2")))
+static inline float _MZ_hsum_sse2(__m128 v){
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+#define _MZ_GEMV_sse2_T __m128
+#define _MZ_GEMV_sse2_ZERO() _mm_setzero_ps()
+#define _MZ_GEMV_sse2_SET1(x) _mm_set1_ps(x)
+#define _MZ_GEMV_sse2_LOAD(p) _mm_loadu_ps(p)
+#define _MZ_GEMV_sse2_STORE(p, x) _mm_storeu_ps(p, x)
+#define _MZ_GEMV_sse2_FMADD(x, y, z) _mm_add_ps(_mm_mul_ps(x, y), z)
+#define _MZ_GEMV_sse2_HSUM(x) _MZ_hsum_sse2(x)
+
+_MZ_GEMV_LOOPS(sse2, 4, "sse2")
+
+__attribute__((target("avx2,fma")))
+static inline float _MZ_hsum_avx2(__m256 v){
+    __m128 h = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_add_ss(h, _mm_shuffle_ps(h, h, 1));
+    return _mm_cvtss_f32(h);
+}
+
+#define _MZ_GEMV_avx2_T __m256
+#define _MZ_GEMV_avx2_ZERO() _mm256_setzero_ps()
+#define _MZ_GEMV_avx2_SET1(x) _mm256_set1_ps(x)
+#define _MZ_GEMV_avx2_LOAD(p) _mm256_loadu_ps(p)
+#define _MZ_GEMV_avx2_STORE(p, x) _mm256_storeu_ps(p, x)
+#define _MZ_GEMV_avx2_FMADD(x, y, z) _mm256_fmadd_ps(x, y, z)
+#define _MZ_GEMV_avx2_HSUM(x) _MZ_hsum_avx2(x)
+
+_MZ_GEMV_LOOPS(avx2, 8, "avx2,fma")
+
+#define _MZ_GEMV_avx512_T __m512
+#define _MZ_GEMV_avx512_ZERO() _mm512_setzero_ps()
+#define _MZ_GEMV_avx512_SET1(x) _mm512_set1_ps(x)
+#define _MZ_GEMV_avx512_LOAD(p) _mm512_loadu_ps(p)
+#define _MZ_GEMV_avx512_STORE(p, x) _mm512_storeu_ps(p, x)
+#define _MZ_GEMV_avx512_FMADD(x, y, z) _mm512_fmadd_ps(x, y, z)
+#define _MZ_GEMV_avx512_HSUM(x) _mm512_reduce_add_ps(x)
+
+_MZ_GEMV_LOOPS(avx512, 16, "avx512f")
+
+static const _MZ_GemvKernel _MZ_gemv_rows_kernels[MZ_ISA_COUNT] = {
+    _MZ_gemv_rows_scalar,
+    _MZ_gemv_rows_scalar,
+    _MZ_gemv_rows_sse2,
+    _MZ_gemv_rows_avx2,
+    _MZ_gemv_rows_avx512,
+};
+
+static const _MZ_GemvKernel _MZ_gemv_cols_kernels[MZ_ISA_COUNT] = {
+    _MZ_gemv_cols_scalar,
+    _MZ_gemv_cols_scalar,
+    _MZ_gemv_cols_sse2,
+    _MZ_gemv_cols_avx2,
+    _MZ_gemv_cols_avx512,
+};
+
+#else
+
+static const _MZ_GemvKernel _MZ_gemv_rows_kernels[MZ_ISA_COUNT] = {
+    _MZ_gemv_rows_scalar,
+    _MZ_gemv_rows_scalar,
+    _MZ_gemv_rows_scalar,
+    _MZ_gemv_rows_scalar,
+    _MZ_gemv_rows_scalar,
+};
+
+static const _MZ_GemvKernel _MZ_gemv_cols_kernels[MZ_ISA_COUNT] = {
+    _MZ_gemv_cols_scalar,
+    _MZ_gemv_cols_scalar,
+    _MZ_gemv_cols_scalar,
+    _MZ_gemv_cols_scalar,
+    _MZ_gemv_cols_scalar,
+};
+
+#endif // _MZ_X86_DISPATCH
+
+/*
+    Columns of y handed to a task of x * A at least, so that tasks never share a cache line of y.
+*/
+#define _MZ_GEMV_COLS_GRAIN 256
+
+typedef struct _MZ_GemvJob{
+    float* y;
+    const float* a;
+    size_t lda;
+    const float* x;
+    size_t rows;
+    size_t cols;
+    float alpha;
+    float beta;
+}_MZ_GemvJob;
+
+static void _MZ_gemv_rows_range(void* ctx, size_t begin, size_t end){
+
+    _MZ_GemvJob* job = (_MZ_GemvJob*)ctx;
+
+    _MZ_gemv_rows_kernels[_MZ_current_isa()](job->y + begin, job->a + begin * job->lda, job->lda, job->x, end - begin, job->cols, job->alpha, job->beta);
+}
+
+static void _MZ_gemv_cols_range(void* ctx, size_t begin, size_t end){
+
+    _MZ_GemvJob* job = (_MZ_GemvJob*)ctx;
+
+    size_t j0 = begin * _MZ_GEMV_COLS_GRAIN;
+    size_t j1 = end * _MZ_GEMV_COLS_GRAIN < job->cols ? end * _MZ_GEMV_COLS_GRAIN : job->cols;
+
+    _MZ_gemv_cols_kernels[_MZ_current_isa()](job->y + j0, job->a + j0, job->lda, job->x, job->rows, j1 - j0, job->alpha, job->beta);
+}
+
+/*
+    y = alpha * A * x + beta * y, A is rows x cols.
+*/
+static void _MZ_gemv(float* y, const float* a, size_t lda, const float* x, size_t rows, size_t cols, float alpha, float beta){
+
+    _MZ_GemvJob job = { y, a, lda, x, rows, cols, alpha, beta };
+
+    _MZ_parallel_for(rows, MZ_PARALLEL_THRESHOLD / (cols == 0 ? 1 : cols) + 1, _MZ_gemv_rows_range, &job);
+}
+
+/*
+    y = alpha * x * A + beta * y, that is alpha * A^T * x + beta * y, A is rows x cols. The columns
+    are split between the tasks, every element of y is summed by a single task in the same order
+    whatever the number of threads.
+*/
+static void _MZ_gemv_transposed(float* y, const float* a, size_t lda, const float* x, size_t rows, size_t cols, float alpha, float beta){
+
+    _MZ_GemvJob job = { y, a, lda, x, rows, cols, alpha, beta };
+
+    size_t blocks = (cols + _MZ_GEMV_COLS_GRAIN - 1) / _MZ_GEMV_COLS_GRAIN;
+    size_t work = _MZ_GEMV_COLS_GRAIN * (rows == 0 ? 1 : rows);
+
+    _MZ_parallel_for(blocks, MZ_PARALLEL_THRESHOLD / work + 1, _MZ_gemv_cols_range, &job);
+}
+
+/*
+*/
+MZ_Vec MZ_multiply_matrix_by_vector(MZ_Matrix matrix, MZ_Vec vector){
+
+    MZ_assert(matrix.cols == MZ_DIM_OF_VECTOR(vector), MZ_PROD_ERROR);
+
+    MZ_Vec result = MZ_alloc_vector(matrix.rows);
+
+    MZ_multiply_matrix_by_vector_into(&result, matrix, vector);
+
+    return result;
+}
+
+/*
+*/
+void MZ_multiply_matrix_by_vector_into(MZ_Vec* dest, MZ_Matrix matrix, MZ_Vec vector){
+
+    MZ_assert(matrix.cols == MZ_DIM_OF_VECTOR(vector), MZ_PROD_ERROR);
+    MZ_assert(dest->dim == matrix.rows, MZ_EQUAL_ERROR);
+    MZ_assert(dest->elements != vector.elements, MZ_ALIAS_ERROR);
+
+    _MZ_gemv(dest->elements, matrix.elements, MZ_STRIDE_OF_MATRIX(matrix), vector.elements, matrix.rows, matrix.cols, 1.0f, 0.0f);
+}
+
+/*
+*/
+MZ_Vec MZ_multiply_vector_by_matrix(MZ_Vec vector, MZ_Matrix matrix){
+
+    MZ_assert(matrix.rows == MZ_DIM_OF_VECTOR(vector), MZ_PROD_ERROR);
+
+    MZ_Vec result = MZ_alloc_vector(matrix.cols);
+
+    MZ_multiply_vector_by_matrix_into(&result, vector, matrix);
+
+    return result;
+}
+
+/*
+*/
+void MZ_multiply_vector_by_matrix_into(MZ_Vec* dest, MZ_Vec vector, MZ_Matrix matrix){
+
+    MZ_assert(matrix.rows == MZ_DIM_OF_VECTOR(vector), MZ_PROD_ERROR);
+    MZ_assert(dest->dim == matrix.cols, MZ_EQUAL_ERROR);
+    MZ_assert(dest->elements != vector.elements, MZ_ALIAS_ERROR);
+
+    _MZ_gemv_transposed(dest->elements, matrix.elements, MZ_STRIDE_OF_MATRIX(matrix), vector.elements, matrix.rows, matrix.cols, 1.0f, 0.0f);
+}
+
+/*
+*/
+void MZ_gemv(MZ_Transpose transpose_A, float alpha, MZ_Matrix matrix_A, MZ_Vec vector, float beta, MZ_Vec* dest){
+
+    bool trans = transpose_A == MZ_TRANSPOSE;
+
+    MZ_assert(MZ_DIM_OF_VECTOR(vector) == (trans ? matrix_A.rows : matrix_A.cols), MZ_PROD_ERROR);
+    MZ_assert(dest->dim == (trans ? matrix_A.cols : matrix_A.rows), MZ_EQUAL_ERROR);
+    MZ_assert(dest->elements != vector.elements, MZ_ALIAS_ERROR);
+
+    if(trans){
+        _MZ_gemv_transposed(dest->elements, matrix_A.elements, MZ_STRIDE_OF_MATRIX(matrix_A), vector.elements, matrix_A.rows, matrix_A.cols, alpha, beta);
+    }else {
+        _MZ_gemv(dest->elements, matrix_A.elements, MZ_STRIDE_OF_MATRIX(matrix_A), vector.elements, matrix_A.rows, matrix_A.cols, alpha, beta);
+    }
+}
+
+/*
+    Scaled sum, product or quotient element by element of two possibly transposed matrices,
+    walked in square tiles so that a transposed operand is read a cache line at a time in both
+    directions.
+*/
+#define _MZ_GEAM_TILE 32
+
+typedef struct _MZ_GeamJob{
+    float* c;
+    size_t ldc;
+    const float* a;
+    size_t lda;
+    bool transA;
+    float alpha;
+    const float* b;
+    size_t ldb;
+    bool transB;
+    float beta;
+    _MZ_ElementOp op;
+    size_t rows;
+    size_t cols;
+}_MZ_GeamJob;
+
+static void _MZ_geam_range(void* ctx, size_t begin, size_t end){
+
+    _MZ_GeamJob* job = (_MZ_GeamJob*)ctx;
+
+    // distance between two elements of op(X) along a row (j) and along a column (i)
+    const size_t aj = job->transA ? job->lda : 1, ai = job->transA ? 1 : job->lda;
+    const size_t bj = job->transB ? job->ldb : 1, bi = job->transB ? 1 : job->ldb;
+    const float* a = job->a;
+    const float* b = job->b;
+    const float alpha = job->alpha, beta = job->beta;
+    const size_t cols = job->cols;
+
+    size_t i1 = end * _MZ_GEAM_TILE < job->rows ? end * _MZ_GEAM_TILE : job->rows;
+
+    for(size_t i0 = begin * _MZ_GEAM_TILE; i0 < i1; i0 += _MZ_GEAM_TILE){
+        size_t ie = i0 + _MZ_GEAM_TILE < i1 ? i0 + _MZ_GEAM_TILE : i1;
+        for(size_t j0 = 0; j0 < cols; j0 += _MZ_GEAM_TILE){
+            size_t je = j0 + _MZ_GEAM_TILE < cols ? j0 + _MZ_GEAM_TILE : cols;
+            for(size_t i = i0; i < ie; i++){
+                float* row = job->c + i * job->ldc;
+                const float* ra = a + i * ai;
+                const float* rb = b + i * bi;
+                // both operands are read before the store, dest can be one that is not transposed
+                switch(job->op){
+                    case _MZ_OP_MUL:
+                        for(size_t j = j0; j < je; j++) row[j] = ra[j * aj] * rb[j * bj];
+                        break;
+                    case _MZ_OP_SAFE_DIV:
+                        for(size_t j = j0; j < je; j++) row[j] = rb[j * bj] != 0.0f ? ra[j * aj] / rb[j * bj] : 0.0f;
+                        break;
+                    default:
+                        if(beta == 0.0f){
+                            for(size_t j = j0; j < je; j++) row[j] = alpha * ra[j * aj];
+                        }else {
+                            for(size_t j = j0; j < je; j++) row[j] = alpha * ra[j * aj] + beta * rb[j * bj];
+                        }
+                        break;
+                }
+            }
+        }
+    }
+}
+
+static void _MZ_geam(MZ_Transpose transpose_A, float alpha, MZ_Matrix matrix_A, MZ_Transpose transpose_B, float beta, MZ_Matrix matrix_B,
+                     MZ_Matrix* dest, _MZ_ElementOp op){
+
+    bool transA = transpose_A == MZ_TRANSPOSE;
+    bool transB = transpose_B == MZ_TRANSPOSE;
+
+    MZ_assert(dest->rows == (transA ? matrix_A.cols : matrix_A.rows) && dest->cols == (transA ? matrix_A.rows : matrix_A.cols), MZ_EQUAL_ERROR);
+    MZ_assert(dest->rows == (transB ? matrix_B.cols : matrix_B.rows) && dest->cols == (transB ? matrix_B.rows : matrix_B.cols), MZ_EQUAL_ERROR);
+    MZ_assert(!(transA && dest->elements == matrix_A.elements) && !(transB && dest->elements == matrix_B.elements), MZ_ALIAS_ERROR);
+
+    // with no transposed operand the SIMD kernels of the plain operations apply
+    if(!transA && !transB && op != _MZ_OP_ADD){
+        _MZ_elementwise_matrix(dest, matrix_A, &matrix_B, 0.0f, op);
+        return;
+    }
+
+    _MZ_GeamJob job;
+    job.c = dest->elements;
+    job.ldc = MZ_STRIDE_OF_MATRIX(*dest);
+    job.a = matrix_A.elements;
+    job.lda = MZ_STRIDE_OF_MATRIX(matrix_A);
+    job.transA = transA;
+    job.alpha = alpha;
+    job.b = matrix_B.elements;
+    job.ldb = MZ_STRIDE_OF_MATRIX(matrix_B);
+    job.transB = transB;
+    job.beta = beta;
+    job.op = op;
+    job.rows = dest->rows;
+    job.cols = dest->cols;
+
+    size_t blocks = (job.rows + _MZ_GEAM_TILE - 1) / _MZ_GEAM_TILE;
+    size_t work = _MZ_GEAM_TILE * (job.cols == 0 ? 1 : job.cols);
+
+    _MZ_parallel_for(blocks, MZ_PARALLEL_THRESHOLD / work + 1, _MZ_geam_range, &job);
+}
+
+/*
+*/
+void MZ_geam(MZ_Transpose transpose_A, float alpha, MZ_Matrix matrix_A, MZ_Transpose transpose_B, float beta, MZ_Matrix matrix_B, MZ_Matrix* dest){
+    _MZ_geam(transpose_A, alpha, matrix_A, transpose_B, beta, matrix_B, dest, _MZ_OP_ADD);
+}
+
+/*
+*/
+void MZ_product_element_wise_transposed_into(MZ_Transpose transpose_A, MZ_Matrix matrix_A, MZ_Transpose transpose_B, MZ_Matrix matrix_B, MZ_Matrix* dest){
+    _MZ_geam(transpose_A, 1.0f, matrix_A, transpose_B, 1.0f, matrix_B, dest, _MZ_OP_MUL);
+}
+
+/*
+*/
+void MZ_divide_two_matrices_transposed_into(MZ_Transpose transpose_A, MZ_Matrix matrix_A, MZ_Transpose transpose_B, MZ_Matrix matrix_B, MZ_Matrix* dest){
+    _MZ_geam(transpose_A, 1.0f, matrix_A, transpose_B, 1.0f, matrix_B, dest, _MZ_OP_SAFE_DIV);
+}
+
+/*
+*/
+MZ_Matrix MZ_multiply_matrix_by_scalar(MZ_Matrix matrix1, float scalar){
+    
+    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
+
+    MZ_multiply_matrix_by_scalar_into(&result, matrix1, scalar);
+
+    return result;
+
+}
+
+/*
+*/
+void MZ_multiply_matrix_by_scalar_into(MZ_Matrix* dest, MZ_Matrix matrix1, float scalar){
+
+    MZ_assert(dest->rows == matrix1.rows && dest->cols == matrix1.cols, MZ_EQUAL_ERROR);
+
+    _MZ_elementwise_matrix(dest, matrix1, NULL, scalar, _MZ_OP_MUL);
+
+}
+
+/*
+*/
+MZ_Matrix MZ_divide_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2){
+
+    MZ_assert(matrix1.rows == matrix2.rows && matrix1.cols == matrix2.cols, MZ_EQUAL_ERROR);
+
+    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
+
+    MZ_divide_two_matrices_into(&result, matrix1, matrix2);
+
+    return result;
+
+}
+
+/*
+*/
+void MZ_divide_two_matrices_into(MZ_Matrix* dest, MZ_Matrix matrix1, MZ_Matrix matrix2){
+
+    MZ_assert(matrix1.rows == matrix2.rows && matrix1.cols == matrix2.cols &&
+              dest->rows == matrix1.rows && dest->cols == matrix1.cols, MZ_EQUAL_ERROR);
+
+    _MZ_elementwise_matrix(dest, matrix1, &matrix2, 0.0f, _MZ_OP_SAFE_DIV);
+
+}
+
+/*
+*/
+MZ_Matrix MZ_divide_matrix_by_scalar(MZ_Matrix matrix1, float scalar){
+
+    if(scalar == 0.0f) return NULL_MATRIX;
+
+    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
+
+    MZ_divide_matrix_by_scalar_into(&result, matrix1, scalar);
+
+    return result;
+
+}
+
+/*
+*/
+bool MZ_divide_matrix_by_scalar_into(MZ_Matrix* dest, MZ_Matrix matrix1, float scalar){
+
+    MZ_assert(dest->rows == matrix1.rows && dest->cols == matrix1.cols, MZ_EQUAL_ERROR);
+
+    if(scalar == 0.0f) return false;
+
+    _MZ_elementwise_matrix(dest, matrix1, NULL, scalar, _MZ_OP_DIV);
+
+    return true;
+
+}
+
+/*
+*/
+MZ_Matrix MZ_product_element_wise_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2){
+
+    MZ_assert(matrix1.rows == matrix2.rows && matrix1.cols == matrix2.cols, MZ_EQUAL_ERROR);
+
+    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
+
+    MZ_product_element_wise_two_matrices_into(&result, matrix1, matrix2);
+
+    return result;
+
+}
+
+/*
+*/
+void MZ_product_element_wise_two_matrices_into(MZ_Matrix* dest, MZ_Matrix matrix1, MZ_Matrix matrix2){
+
+    MZ_assert(matrix1.rows == matrix2.rows && matrix1.cols == matrix2.cols &&
+              dest->rows == matrix1.rows && dest->cols == matrix1.cols, MZ_EQUAL_ERROR);
+
+    _MZ_elementwise_matrix(dest, matrix1, &matrix2, 0.0f, _MZ_OP_MUL);
+
+}
+
+/*
+    Transpose. The source is cut in tiles that stay in L1 together with their image, and every
+    tile is transposed by blocks of 8x8 shuffled in registers. The square in place version swaps
+    pairs of blocks across the diagonal through two blocks on the stack.
+*/
+#define _MZ_TRANSPOSE_BLOCK 8
+#define _MZ_TRANSPOSE_TILE 64
+
+// dst[j][i] = src[i][j] for an 8x8 block
+typedef void (*_MZ_TransposeKernel)(float* dst, size_t ldd, const float* src, size_t lds);
+
+static void _MZ_transpose_block_scalar(float* dst, size_t ldd, const float* src, size_t lds){
+
+    for(size_t i = 0; i < _MZ_TRANSPOSE_BLOCK; i++){
+        for(size_t j = 0; j < _MZ_TRANSPOSE_BLOCK; j++){
+            dst[j * ldd + i] = src[i * lds + j];
+        }
+    }
+}
+
+#if _MZ_X86_DISPATCH
+
+__attribute__((target("sse2")))
+static void _MZ_transpose_block_sse2(float* dst, size_t ldd, const float* src, size_t lds){
+
+    for(size_t i = 0; i < _MZ_TRANSPOSE_BLOCK; i += 4){
+        for(size_t j = 0; j < _MZ_TRANSPOSE_BLOCK; j += 4){
+            __m128 r0 = _mm_loadu_ps(src + (i + 0) * lds + j);
+            __m128 r1 = _mm_loadu_ps(src + (i + 1) * lds + j);
+            __m128 r2 = _mm_loadu_ps(src + (i + 2) * lds + j);
+            __m128 r3 = _mm_loadu_ps(src + (i + 3) * lds + j);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(dst + (j + 0) * ldd + i, r0);
+            _mm_storeu_ps(dst + (j + 1) * ldd + i, r1);
+            _mm_storeu_ps(dst + (j + 2) * ldd + i, r2);
+            _mm_storeu_ps(dst + (j + 3) * ldd + i, r3);
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static void _MZ_transpose_block_avx2(float* dst, size_t ldd, const float* src, size_t lds){
+
+    __m256 r0 = _mm256_loadu_ps(src);
+    __m256 r1 = _mm256_loadu_ps(src + lds);
+    __m256 r2 = _mm256_loadu_ps(src + 2 * lds);
+    __m256 r3 = _mm256_loadu_ps(src + 3 * lds);
+    __m256 r4 = _mm256_loadu_ps(src + 4 * lds);
+    __m256 r5 = _mm256_loadu_ps(src + 5 * lds);
+    __m256 r6 = _mm256_loadu_ps(src + 6 * lds);
+    __m256 r7 = _mm256_loadu_ps(src + 7 * lds);
+
+    // interleave pairs of rows, then pairs of pairs, then swap the 128 bit halves
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1), t1 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t2 = _mm256_unpacklo_ps(r2, r3), t3 = _mm256_unpackhi_ps(r2, r3);
+    __m256 t4 = _mm256_unpacklo_ps(r4, r5), t5 = _mm256_unpackhi_ps(r4, r5);
+    __m256 t6 = _mm256_unpacklo_ps(r6, r7), t7 = _mm256_unpackhi_ps(r6, r7);
+
+    __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0)), s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0)), s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+    _mm256_storeu_ps(dst,           _mm256_permute2f128_ps(s0, s4, 0x20));
+    _mm256_storeu_ps(dst + ldd,     _mm256_permute2f128_ps(s1, s5, 0x20));
+    _mm256_storeu_ps(dst + 2 * ldd, _mm256_permute2f128_ps(s2, s6, 0x20));
+    _mm256_storeu_ps(dst + 3 * ldd, _mm256_permute2f128_ps(s3, s7, 0x20));
+    _mm256_storeu_ps(dst + 4 * ldd, _mm256_permute2f128_ps(s0, s4, 0x31));
+    _mm256_storeu_ps(dst + 5 * ldd, _mm256_permute2f128_ps(s1, s5, 0x31));
+    _mm256_storeu_ps(dst + 6 * ldd, _mm256_permute2f128_ps(s2, s6, 0x31));
+    _mm256_storeu_ps(dst + 7 * ldd, _mm256_permute2f128_ps(s3, s7, 0x31));
+}
+
+// an 8x8 block is one register per row with AVX2 already, AVX-512 uses the same kernel
+static const _MZ_TransposeKernel _MZ_transpose_kernels[MZ_ISA_COUNT] = {
+    _MZ_transpose_block_scalar,
+    _MZ_transpose_block_scalar,
+    _MZ_transpose_block_sse2,
+    _MZ_transpose_block_avx2,
+    _MZ_transpose_block_avx2,
+};
+
+#else
+
+static const _MZ_TransposeKernel _MZ_transpose_kernels[MZ_ISA_COUNT] = {
+    _MZ_transpose_block_scalar,
+    _MZ_transpose_block_scalar,
+    _MZ_transpose_block_scalar,
+    _MZ_transpose_block_scalar,
+    _MZ_transpose_block_scalar,
+};
+
+#endif // _MZ_X86_DISPATCH
+
+// dst = src^T for a rows x cols tile of src
+static void _MZ_transpose_tile(float* dst, size_t ldd, const float* src, size_t lds, size_t rows, size_t cols, _MZ_TransposeKernel kernel){
+
+    size_t i = 0;
+
+    for(; i + _MZ_TRANSPOSE_BLOCK <= rows; i += _MZ_TRANSPOSE_BLOCK){
+        size_t j = 0;
+        for(; j + _MZ_TRANSPOSE_BLOCK <= cols; j += _MZ_TRANSPOSE_BLOCK){
+            kernel(dst + j * ldd + i, ldd, src + i * lds + j, lds);
+        }
+        for(; j < cols; j++){
+            for(size_t k = i; k < i + _MZ_TRANSPOSE_BLOCK; k++) dst[j * ldd + k] = src[k * lds + j];
+        }
+    }
+    for(; i < rows; i++){
+        for(size_t j = 0; j < cols; j++) dst[j * ldd + i] = src[i * lds + j];
+    }
+}
+
+typedef struct _MZ_TransposeJob{
+    float* dst;
+    size_t ldd;
+    const float* src;
+    size_t lds;
+    size_t rows;
+    size_t cols;
+}_MZ_TransposeJob;
+
+// transposes the rows of tiles [begin, end) of the source
+static void _MZ_transpose_tiles(void* ctx, size_t begin, size_t end){
+
+    _MZ_TransposeJob* job = (_MZ_TransposeJob*)ctx;
+    _MZ_TransposeKernel kernel = _MZ_transpose_kernels[_MZ_current_isa()];
+
+    for(size_t tile = begin; tile < end; tile++){
+        size_t i = tile * _MZ_TRANSPOSE_TILE;
+        size_t rows = job->rows - i < _MZ_TRANSPOSE_TILE ? job->rows - i : _MZ_TRANSPOSE_TILE;
+        for(size_t j = 0; j < job->cols; j += _MZ_TRANSPOSE_TILE){
+            size_t cols = job->cols - j < _MZ_TRANSPOSE_TILE ? job->cols - j : _MZ_TRANSPOSE_TILE;
+            _MZ_transpose_tile(job->dst + j * job->ldd + i, job->ldd, job->src + i * job->lds + j, job->lds, rows, cols, kernel);
+        }
+    }
+}
+
+// swaps the blocks (bi, bj) and (bj, bi) transposing them, bi <= bj
+static void _MZ_transpose_swap_blocks(float* a, size_t lda, size_t bi, size_t bj, _MZ_TransposeKernel kernel){
+
+    float upper[_MZ_TRANSPOSE_BLOCK * _MZ_TRANSPOSE_BLOCK];
+    float lower[_MZ_TRANSPOSE_BLOCK * _MZ_TRANSPOSE_BLOCK];
+
+    float* pu = a + bi * _MZ_TRANSPOSE_BLOCK * lda + bj * _MZ_TRANSPOSE_BLOCK;
+    float* pl = a + bj * _MZ_TRANSPOSE_BLOCK * lda + bi * _MZ_TRANSPOSE_BLOCK;
+
+    kernel(upper, _MZ_TRANSPOSE_BLOCK, pu, lda);
+    if(bi != bj) kernel(lower, _MZ_TRANSPOSE_BLOCK, pl, lda);
+
+    for(size_t k = 0; k < _MZ_TRANSPOSE_BLOCK; k++){
+        memcpy(pl + k * lda, upper + k * _MZ_TRANSPOSE_BLOCK, sizeof(float) * _MZ_TRANSPOSE_BLOCK);
+        if(bi != bj) memcpy(pu + k * lda, lower + k * _MZ_TRANSPOSE_BLOCK, sizeof(float) * _MZ_TRANSPOSE_BLOCK);
+    }
+}
+
+/*
+    In place transpose of an n x n matrix. The rows of blocks are dealt to the tasks in turn,
+    the row bi swaps its blocks right of the diagonal with the ones below it, so the work
+    shrinks along the rows and dealing them evens it out.
+*/
+static void _MZ_transpose_square_task(void* ctx, unsigned int task, unsigned int tasks){
+
+    _MZ_TransposeJob* job = (_MZ_TransposeJob*)ctx;
+    _MZ_TransposeKernel kernel = _MZ_transpose_kernels[_MZ_current_isa()];
+
+    float* a = job->dst;
+    size_t lda = job->ldd;
+    size_t n = job->rows;
+    size_t blocks = n / _MZ_TRANSPOSE_BLOCK;
+    size_t edge = blocks * _MZ_TRANSPOSE_BLOCK;
+
+    for(size_t bi = task; bi < blocks; bi += tasks){
+        for(size_t bj = bi; bj < blocks; bj++){
+            _MZ_transpose_swap_blocks(a, lda, bi, bj, kernel);
+        }
+        // the columns past the last whole block
+        for(size_t i = bi * _MZ_TRANSPOSE_BLOCK; i < (bi + 1) * _MZ_TRANSPOSE_BLOCK; i++){
+            for(size_t j = edge; j < n; j++){
+                float tmp = a[i * lda + j];
+                a[i * lda + j] = a[j * lda + i];
+                a[j * lda + i] = tmp;
+            }
+        }
+    }
+
+    // the corner past the last whole block
+    if(task == 0){
+        for(size_t i = edge; i < n; i++){
+            for(size_t j = i + 1; j < n; j++){
+                float tmp = a[i * lda + j];
+                a[i * lda + j] = a[j * lda + i];
+                a[j * lda + i] = tmp;
+            }
+        }
+    }
+}
+
+/*
+*/
+MZ_Matrix MZ_transposed_matrix(MZ_Matrix source){
+
+    MZ_Matrix result = MZ_alloc_matrix(source.cols, source.rows);
+
+    MZ_transposed_matrix_into(&result, source);
+
+    return result;
+}
+
+/*
+*/
+void MZ_transposed_matrix_into(MZ_Matrix* dest, MZ_Matrix source){
+
+    MZ_assert(dest->rows == source.cols && dest->cols == source.rows, MZ_EQUAL_ERROR);
+
+    if(source.rows == 0 || source.cols == 0) return;
+
+    _MZ_TransposeJob job = { dest->elements, MZ_STRIDE_OF_MATRIX(*dest), source.elements, MZ_STRIDE_OF_MATRIX(source), source.rows, source.cols };
+
+    if(dest->elements == source.elements && job.ldd == job.lds){
+
+        MZ_assert(source.rows == source.cols, MZ_SQUARE_ERROR);
+
+        _MZ_parallel_run(_MZ_parallel_tasks((size_t)source.rows * source.rows, MZ_PARALLEL_THRESHOLD), _MZ_transpose_square_task, &job);
+        return;
+    }
+
+    // any other overlap, like two views of the same matrix, transposes a packed copy of the source
+    if(_MZ_matrices_overlap(*dest, source)){
+        _MZ_Scratch scratch = _MZ_scratch_begin();
+        MZ_Matrix staged = MZ_alloc_matrix(source.rows, source.cols);
+        MZ_copy_matrix_into(&staged, source);
+        MZ_transposed_matrix_into(dest, staged);
+        _MZ_scratch_end(scratch);
+        return;
+    }
+
+    size_t tiles = (source.rows + _MZ_TRANSPOSE_TILE - 1) / _MZ_TRANSPOSE_TILE;
+    size_t work = (size_t)_MZ_TRANSPOSE_TILE * (source.cols == 0 ? 1 : source.cols);
+
+    _MZ_parallel_for(tiles, MZ_PARALLEL_THRESHOLD / work + 1, _MZ_transpose_tiles, &job);
+}
+
+/*
+*/
+bool MZ_swap_two_matrix_rows(MZ_Matrix *source, unsigned int row1, unsigned int row2){
+
+
+    if(row1 >= source->rows || row2 >= source->rows || row1 == row2){
+        return false;
+    }
+
+    size_t indxRow1 = (size_t)row1 * MZ_STRIDE_OF_MATRIX(*source);
+    size_t indxRow2 = (size_t)row2 * MZ_STRIDE_OF_MATRIX(*source);
+
+    for(unsigned int i = 0; i < source->cols; i++){
+
+        float temp = source->elements[indxRow1 + i];
+        source->elements[indxRow1 + i] = source->elements[indxRow2 + i];
+        source->elements[indxRow2 + i] = temp;
+
+    }
+
+    return true;
+}
+
+/*
+*/
+bool MZ_add_two_matrix_rows(MZ_Matrix *source, unsigned int row1, unsigned int row2){
+
+
+    if(row1 >= source->rows || row2 >= source->rows || row1 == row2){
+        return false;
+    }
+
+    for(unsigned int i = 0; i < source->cols; i++){
+        //source->elements[row1][i] += source->elements[row2][i];
+        MZ_VALUE_OF_MAT_POINTER_AT(source, row1, i) += MZ_VALUE_OF_MAT_POINTER_AT(source, row2, i);
+    }
+
+    return true;
+}
+
+/*
+*/
+bool MZ_multiply_two_matrix_rows(MZ_Matrix *source, unsigned int row, float scalar){
+
+
+    if(row >= source->rows || scalar == 0.0f){
+        return false;
+    }
+
+    _MZ_scal(&MZ_VALUE_OF_MAT_POINTER_AT(source, row, 0), scalar, source->cols);
+
+    return true;
+}
+
+/*
+*/
+bool MZ_multiply_add_two_matrix_rows(MZ_Matrix *source, unsigned int row1, unsigned int row2, float scalar){
+
+
+    if(row1 >= source->rows || row2 >= source->rows || 
+       scalar == 0.0f || row1 == row2){
+        return false;
+    }
+
+    _MZ_axpy(&MZ_VALUE_OF_MAT_POINTER_AT(source, row1, 0), &MZ_VALUE_OF_MAT_POINTER_AT(source, row2, 0), scalar, source->cols);
+
+    return true;
+}
+
+/*
+*/
+bool MZ_multiply_add_matrix_row_to_rows(MZ_Matrix *source, unsigned int row, unsigned int first, unsigned int count, const float* scalars){
+
+    if(row >= source->rows || first > source->rows || count > source->rows - first ||
+       (row >= first && row - first < count)){
+        return false;
+    }
+
+    _MZ_axpy_rows(&MZ_VALUE_OF_MAT_POINTER_AT(source, first, 0), MZ_STRIDE_OF_MATRIX(*source), count, scalars,
+                  &MZ_VALUE_OF_MAT_POINTER_AT(source, row, 0), source->cols);
+
+    return true;
+}
+
+/*
+    Blocked right looking Gaussian elimination with partial pivoting. Every panel of
+    _MZ_ECHELON_BLOCK cols is eliminated one col at a time on the panel only, keeping the
+    multipliers below the pivots, and its row interchanges are recorded in an index and applied
+    to the cols right of the panel once per block. The rows of the panel are then solved
+    against its unit lower triangle and the trailing rows are updated by one GEMM. Cols with no
+    pivot larger than the tolerance are zeroed and skipped.
+*/
+#define _MZ_ECHELON_BLOCK 64
+
+static void _MZ_swap_floats(float* a, float* b, size_t n){
+    for(size_t i = 0; i < n; i++){
+        float tmp = a[i];
+        a[i] = b[i];
+        b[i] = tmp;
+    }
+}
+
+// eliminates the cols [c0, c1) below row r, returns the row after the last pivot found
+static size_t _MZ_echelon_panel(float* a, size_t lda, size_t m, size_t c0, size_t c1, size_t r,
+                                float tolerance, unsigned int* pivotCols, unsigned int* swaps, float* alphas){
+
+    size_t first = r;
+
+    for(size_t j = c0; j < c1 && r < m; j++){
+
+        size_t p = r;
+        float best = fabsf(a[r * lda + j]);
+        for(size_t i = r + 1; i < m; i++){
+            float v = fabsf(a[i * lda + j]);
+            if(v > best){
+                best = v;
+                p = i;
+            }
+        }
+
+        if(best <= tolerance){
+            for(size_t i = r; i < m; i++){
+                a[i * lda + j] = 0.0f;
+            }
+            continue;
+        }
+
+        if(p != r){
+            _MZ_swap_floats(a + r * lda + c0, a + p * lda + c0, c1 - c0);
+        }
+        swaps[r - first] = (unsigned int)p;
+        pivotCols[r] = (unsigned int)j;
+
+        const float* pivotRow = a + r * lda;
+        float inv = 1.0f / pivotRow[j];
+
+        for(size_t i = r + 1; i < m; i++){
+            float l = a[i * lda + j] * inv;
+            a[i * lda + j] = l;
+            alphas[i - r - 1] = -l;
+        }
+        _MZ_axpy_rows(a + (r + 1) * lda + j + 1, lda, m - r - 1, alphas, pivotRow + j + 1, c1 - j - 1);
+
+        r++;
+    }
+
+    return r;
+}
+
+static void _MZ_echelon(MZ_Matrix* source, bool reduced){
+
+    size_t m = source->rows;
+    size_t n = source->cols;
+    size_t lda = MZ_STRIDE_OF_MATRIX(*source);
+    float* a = source->elements;
+
+    if(m == 0 || n == 0) return;
+
+    // same tolerance as the usual rref: max(m, n) * eps * infinity norm of the matrix
+    double norm = 0.0;
+    for(size_t i = 0; i < m; i++){
+        double sum = 0.0;
+        for(size_t j = 0; j < n; j++){
+            sum += fabsf(a[i * lda + j]);
+        }
+        if(sum > norm) norm = sum;
+    }
+    float tolerance = (float)((double)(m > n ? m : n) * FLT_EPSILON * norm);
+
+    _MZ_Scratch scratch = _MZ_scratch_begin();
+
+    unsigned int* pivotCols = MZ_ALLOC(m, unsigned int);
+    unsigned int* swaps = MZ_ALLOC(_MZ_ECHELON_BLOCK, unsigned int);
+    float* alphas = MZ_ALLOC(m, float);
+    float* l = MZ_ALLOC(m * _MZ_ECHELON_BLOCK, float);
+
+    size_t r = 0;
+
+    for(size_t c0 = 0; c0 < n && r < m; c0 += _MZ_ECHELON_BLOCK){
+
+        size_t c1 = n - c0 < _MZ_ECHELON_BLOCK ? n : c0 + _MZ_ECHELON_BLOCK;
+        size_t first = r;
+
+        r = _MZ_echelon_panel(a, lda, m, c0, c1, r, tolerance, pivotCols, swaps, alphas);
+
+        size_t count = r - first;
+        if(count == 0 || c1 == n) continue;
+
+        for(size_t k = 0; k < count; k++){
+            if(swaps[k] != first + k){
+                _MZ_swap_floats(a + (first + k) * lda + c1, a + (size_t)swaps[k] * lda + c1, n - c1);
+            }
+        }
+
+        // U12 = L11^-1 * A12, the multipliers of the panel are in its pivot cols
+        for(size_t i = first + 1; i < r; i++){
+            float* row = a + i * lda;
+            for(size_t k = first; k < i; k++){
+                float f = row[pivotCols[k]];
+                if(f == 0.0f) continue;
+                _MZ_axpy(row + c1, a + k * lda + c1, -f, n - c1);
+            }
+        }
+
+        if(r == m) continue;
+
+        // A22 -= L21 * U12
+        for(size_t i = r; i < m; i++){
+            for(size_t k = 0; k < count; k++){
+                l[(i - r) * count + k] = a[i * lda + pivotCols[first + k]];
+            }
+        }
+        _MZ_gemm(false, false, m - r, n - c1, count, -1.0f, l, count,
+                 a + first * lda + c1, lda, 1.0f, a + r * lda + c1, lda);
+
+        #if VISUALIZE_STEPS
+        MZ_print_matrix_by_index(stdout, (unsigned int)r, *source);
+        #endif
+    }
+
+    size_t rank = r;
+
+    // clear the multipliers and the rows with no pivot, then scale the pivots to 1
+    for(size_t i = 0; i < m; i++){
+        float* row = a + i * lda;
+        size_t pivot = i < rank ? pivotCols[i] : n;
+        memset(row, 0, pivot * sizeof(float));
+        if(pivot == n) continue;
+        _MZ_scal(row + pivot + 1, 1.0f / row[pivot], n - pivot - 1);
+        row[pivot] = 1.0f;
+    }
+
+    /*
+        Back elimination, from the last block of pivots up: the rows of the block are reduced
+        among themselves, then the rows above it are cleared in its pivot cols by one GEMM.
+    */
+    for(size_t k1 = reduced ? rank : 0; k1 > 0;){
+
+        size_t k0 = k1 < _MZ_ECHELON_BLOCK ? 0 : k1 - _MZ_ECHELON_BLOCK;
+        size_t count = k1 - k0;
+        size_t left = pivotCols[k0];
+
+        for(size_t k = k1 - 1; k > k0; k--){
+            size_t pivot = pivotCols[k];
+            for(size_t i = k0; i < k; i++){
+                alphas[i - k0] = -a[i * lda + pivot];
+                a[i * lda + pivot] = 0.0f;
+            }
+            _MZ_axpy_rows(a + k0 * lda + pivot + 1, lda, k - k0, alphas, a + k * lda + pivot + 1, n - pivot - 1);
+        }
+
+        if(k0 > 0){
+            for(size_t i = 0; i < k0; i++){
+                for(size_t k = 0; k < count; k++){
+                    l[i * count + k] = a[i * lda + pivotCols[k0 + k]];
+                }
+            }
+            _MZ_gemm(false, false, k0, n - left, count, -1.0f, l, count,
+                     a + k0 * lda + left, lda, 1.0f, a + left, lda);
+            for(size_t i = 0; i < k0; i++){
+                for(size_t k = k0; k < k1; k++){
+                    a[i * lda + pivotCols[k]] = 0.0f;
+                }
+            }
+        }
+
+        k1 = k0;
+    }
+
+    _MZ_scratch_end(scratch);
+}
+
+/*
+*/
+void MZ_to_echelon_form(MZ_Matrix *source){
+    _MZ_echelon(source, false);
+}
+
+/*
+*/
+void MZ_to_reduced_echelon_form(MZ_Matrix *source){
+    _MZ_echelon(source, true);
+}
+
+
+/*
+*/
+MZ_Matrix MZ_append_vector_to_matrix(MZ_Matrix source, MZ_Vec vector){
+
+    MZ_assert(source.rows == vector.dim, MZ_EQUAL_ERROR);
+    
+    MZ_Matrix result = MZ_alloc_matrix(source.rows, source.cols + 1);
+
+    for(unsigned int i = 0; i < source.rows; i++){
+        unsigned int j = 0;
+        for(; j < source.cols; j++){
+            #if VISUALIZE_DEBUG
+            printf("%d\n", j);
+            #endif
+            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(source, i, j);
+        }
+        MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_VECTOR_AT(vector, i);
+        #if VISUALIZE_DEBUG
+        printf("%f at %d:%d\n", MZ_VALUE_OF_MAT_AT(result, i, j), i, j);
+        #endif
+    }
+
+    return result;
+
+}
+
+/*
+*/
+MZ_Matrix MZ_append_matrix_to_matrix(MZ_Matrix source, MZ_Matrix matrix){
+
+    MZ_assert(source.rows == matrix.rows, MZ_EQUAL_ERROR);
+    
+    MZ_Matrix result = MZ_alloc_matrix(source.rows, source.cols + matrix.cols);
+
+    for(unsigned int i = 0; i < source.rows; i++){
+        unsigned int j = 0;
+        for(; j < source.cols; j++){
+            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(source, i, j);
+        }
+        for(unsigned int k = 0; k < matrix.cols; k++){
+            MZ_VALUE_OF_MAT_AT(result, i, k + j) = MZ_VALUE_OF_MAT_AT(matrix, i, k);
+        }
+        
+    }
+
+    return result;
+
+}
+
+/*
+*/
+MZ_Matrix MZ_get_sub_matrix(MZ_Matrix source, unsigned int remRow, unsigned int remCol){
+
+    MZ_Matrix result = MZ_alloc_matrix(source.rows - 1, source.cols - 1);
+
+    unsigned int rowOffset = 0;
+    for (unsigned int i = 0; i < result.rows; i++){
+        unsigned int colOffset = 0;
+
+        if (i == remRow){
+            rowOffset++;
+        }
+
+        for (unsigned int j = 0; j < result.cols; j++){
+            if (j == remCol)
+            {
+                colOffset++;
+            }
+
+            // assign value
+            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(source, i + rowOffset, j + colOffset);//source.elements[i + rowOffset][j + colOffset];
+        }
+    }
+    return result;
+}
+
+float MZ_minor(MZ_Matrix source, unsigned int row, unsigned int col){
+    _MZ_Scratch scratch = _MZ_scratch_begin();
+    float result = MZ_determinant_of_matrix(MZ_get_sub_matrix(source, row, col));
+    _MZ_scratch_end(scratch);
+    return result;
+}
+
+float MZ_cofactor(MZ_Matrix source, unsigned int row, unsigned int col){
+    float x = (row + col) % 2 == 0 ? MZ_minor(source, row, col) : -MZ_minor(source, row, col);
+    return x;
+}
+
+/*
+*/
+float MZ_determinant_of_matrix(MZ_Matrix source){
+
+    MZ_assert(source.rows == source.cols && source.rows != 0, MZ_SQUARE_ERROR);
+
+    if(source.rows == 2){
+        return  MZ_VALUE_OF_MAT_AT(source, 0 , 0) * MZ_VALUE_OF_MAT_AT(source, 1 , 1) -
+                MZ_VALUE_OF_MAT_AT(source, 0 , 1) * MZ_VALUE_OF_MAT_AT(source, 1 , 0);
+    }
+
+    _MZ_Scratch scratch = _MZ_scratch_begin();
+
+    float det;
+    MZ_Cholesky cholesky;
+
+    if(_MZ_try_cholesky(source, &cholesky)){
+        det = 1.0f;
+        for(unsigned int i = 0; i < cholesky.dim; i++){
+            float l = cholesky.elements[(size_t)i * cholesky.dim + i];
+            det *= l * l;
+        }
+    }else {
+        MZ_LU lu = MZ_lu_decomposition_of_matrix(source);
+        det = MZ_determinant_of_lu(lu);
+    }
+
+    _MZ_scratch_end(scratch);
+
+    return det;
+}
+
+/*
+*/
+float MZ_determinant_of_matrix_by_cofactor(MZ_Matrix source){
+
+    MZ_assert(source.rows == source.cols && source.rows != 0, MZ_SQUARE_ERROR);
+
+    if(source.rows == 1){
+        return MZ_VALUE_OF_MAT_AT(source, 0, 0);
+    }
+
+    if(source.rows == 2){
+        return  MZ_VALUE_OF_MAT_AT(source, 0 , 0) * MZ_VALUE_OF_MAT_AT(source, 1 , 1) -
+                MZ_VALUE_OF_MAT_AT(source, 0 , 1) * MZ_VALUE_OF_MAT_AT(source, 1 , 0);
+    }
+
+    float det = 0.0f;
+
+    for(unsigned int col = 0; col < source.cols; col++){
+        MZ_Matrix sub = MZ_get_sub_matrix(source, 0, col);
+        float minor = MZ_determinant_of_matrix_by_cofactor(sub);
+        MZ_free_matrix(&sub);
+
+        det += MZ_VALUE_OF_MAT_AT(source, 0, col) * (col % 2 == 0 ? minor : -minor);
+    }
+    return det;
+}
+
+
+/*
+*/
+MZ_Matrix MZ_cofactor_matrix(MZ_Matrix source){
+
+    // must be a square matrix with at least 1 row
+    if (source.rows != source.cols || source.rows == 0)
+    {
+        return NULL_MATRIX;
+    }
+
+    MZ_Matrix result = MZ_alloc_matrix(source.rows, source.cols);
+
+    for (unsigned int i = 0; i < result.rows; i++)
+    {
+        for (unsigned int j = 0; j < result.cols; j++)
+        {
+            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_cofactor(source, i, j);
+        }
+    }
+
+    return result;
+}
+
+/*
+*/
+MZ_Matrix MZ_adjugate_matrix(MZ_Matrix source){
+
+    // must be a square matrix with at least 1 row
+    if (source.rows != source.cols || source.rows == 0)
+    {
+        return NULL_MATRIX;
+    }
+
+    MZ_Matrix result = MZ_alloc_matrix(source.rows, source.cols);
+
+    _MZ_Scratch scratch = _MZ_scratch_begin();
+
+    MZ_transposed_matrix_into(&result, MZ_cofactor_matrix(source));
+
+    _MZ_scratch_end(scratch);
+
+    return result;
+}
+
+/*
+*/
+bool MZ_is_matrix_invertible(MZ_Matrix source){
+
+    // must be a square matrix with at least 1 row
+    if (source.rows != source.cols || source.rows == 0)
+    {
+        return false;
+    }
+
+    _MZ_Scratch scratch = _MZ_scratch_begin();
+
+    MZ_LU lu = MZ_lu_decomposition_of_matrix(source);
+
+    bool invertible = !lu.singular;
+
+    _MZ_scratch_end(scratch);
+
+    return invertible;
+}
+
+/*
+*/
+MZ_Matrix MZ_inverse_of_matrix(MZ_Matrix source){
+
+    // must be a square matrix with at least 1 row
+    if (source.rows != source.cols || source.rows == 0)
+    {
+        return NULL_MATRIX;
     }
 
-    return false;
-}
+    MZ_Matrix result = MZ_alloc_matrix(source.rows, source.cols);
 
-void _MZ_SRAND(unsigned int _Seed){
-    #if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
-        srand((_Seed * getpid()); 
-    #elif _WIN32
-        srand(_Seed * _getpid()); 
-    #endif   
-}
+    if (!MZ_inverse_of_matrix_into(&result, source))
+    {
+        MZ_free_matrix(&result);
+        return NULL_MATRIX;
+    }
 
-MZ_Vec NULL_VECTOR = {0, NULL};
+    return result;
+}
 
 /*
 */
-void MZ_print_vector(FILE* fp, MZ_Vec vector){
+bool MZ_inverse_of_matrix_into(MZ_Matrix* dest, MZ_Matrix source){
 
-    fprintf(fp ,"\n\n   | Vector of size %zu: {\n   |\t[", MZ_DIM_OF_VECTOR(vector));
+    // must be a square matrix with at least 1 row
+    if (source.rows != source.cols || source.rows == 0)
+    {
+        return false;
+    }
 
-    if(vector.elements == NULL){
-        fprintf(fp ," %s ", MZ_NULL_VECTOR);
-    }else {
-        for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector); i++){
-            #if !VISUALIZE_RATIONAL
-            fprintf(fp ," %f", MZ_VALUE_OF_VECTOR_AT(vector, i));
-            #else
-            zstring value = rationalizeFloatToStr(MZ_VALUE_OF_VECTOR_AT(vector, i), 3);
-            fprintf(fp, " %s", value.data);
-            #endif
-            fprintf(fp ,"%c", (i < MZ_DIM_OF_VECTOR(vector) - 1 ? ',' : ' '));
+    MZ_assert(dest->rows == source.rows && dest->cols == source.cols, MZ_EQUAL_ERROR);
+
+    _MZ_Scratch scratch = _MZ_scratch_begin();
+
+    MZ_Cholesky cholesky;
+
+    if (_MZ_try_cholesky(source, &cholesky))
+    {
+        for (unsigned int i = 0; i < cholesky.dim; i++)
+        {
+            float* row = &MZ_VALUE_OF_MAT_POINTER_AT(dest, i, 0);
+            memset(row, 0, cholesky.dim * sizeof(float));
+            row[i] = 1.0f;
         }
+
+        _MZ_cholesky_substitute(cholesky, dest->elements, MZ_STRIDE_OF_MATRIX(*dest), cholesky.dim);
+
+        _MZ_scratch_end(scratch);
+        return true;
     }
-    fprintf(fp ,"]\n   |  }\n\n");
-}
 
-/*
-*/
-void MZ_print_vector_by_label(FILE* fp, const char* label, MZ_Vec vector){
+    MZ_LU lu = MZ_lu_decomposition_of_matrix(source);
 
-    fprintf(fp ,"\n\n   | [%s] of size %zu: {\n   |\t[", label, MZ_DIM_OF_VECTOR(vector));
+    if (lu.singular)
+    {
+        _MZ_scratch_end(scratch);
+        return false;
+    }
 
-    if(vector.elements == NULL){
-        fprintf(fp ," %s ", MZ_NULL_VECTOR);
-    }else {
-        for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector); i++){
-            #if !VISUALIZE_RATIONAL 
-            fprintf(fp ," %f", MZ_VALUE_OF_VECTOR_AT(vector, i));
-            #else
-            zstring value = rationalizeFloatToStr(MZ_VALUE_OF_VECTOR_AT(vector, i), 3);
-            fprintf(fp, " %s", value.data);
-            #endif
-            fprintf(fp ,"%c", (i < MZ_DIM_OF_VECTOR(vector) - 1 ? ',' : ' '));
-        }
+    // P * A * X = I  ->  start from the permuted identity, the source is no longer needed
+    unsigned int n = lu.dim;
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+        float* row = &MZ_VALUE_OF_MAT_POINTER_AT(dest, i, 0);
+        memset(row, 0, n * sizeof(float));
+        row[lu.pivots[i]] = 1.0f;
     }
-    fprintf(fp ,"]\n   |  }\n\n");
+
+    _MZ_lu_substitute(lu, dest->elements, MZ_STRIDE_OF_MATRIX(*dest), n);
+
+    _MZ_scratch_end(scratch);
+
+    return true;
 }
 
 /*
 */
-void MZ_print_vector_by_index(FILE* fp, int index, MZ_Vec vector){
+MZ_Matrix MZ_inverse_of_matrix_by_adjugate(MZ_Matrix source){
 
-    fprintf(fp ,"\n\n   | [VECTOR %d] of size %zu: {\n   |\t[", index, MZ_DIM_OF_VECTOR(vector));
+    // must be a square matrix with at least 1 row
+    if (source.rows != source.cols || source.rows == 0)
+    {
+        return NULL_MATRIX;
+    }
 
-    if(vector.elements == NULL){
-        fprintf(fp ," %s ", MZ_NULL_VECTOR);
-    }else {
-        for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector); i++){
-            #if !VISUALIZE_RATIONAL 
-            fprintf(fp ," %f", MZ_VALUE_OF_VECTOR_AT(vector, i));
-            #else
-            zstring value = rationalizeFloatToStr(MZ_VALUE_OF_VECTOR_AT(vector, i), 3);
-            fprintf(fp, " %s", value.data);
-            #endif
-            fprintf(fp ,"%c", (i < MZ_DIM_OF_VECTOR(vector) - 1 ? ',' : ' '));
-        }
+    float det = MZ_determinant_of_matrix_by_cofactor(source);
+
+    if (det == 0.0f)
+    {
+        return NULL_MATRIX;
     }
-    fprintf(fp ,"]\n   |  }\n\n");
-}
 
-/*
-*/
-void MZ_free_vector(MZ_Vec* vector){
+    MZ_Matrix result = MZ_alloc_matrix(source.rows, source.cols);
 
-    MZ_assert(vector != NULL, "Vector must not be NULL.");
+    _MZ_Scratch scratch = _MZ_scratch_begin();
 
-    free(vector->elements);
-    vector->elements = NULL;
-    vector->dim = 0;
+    // inverse = 1 / det * adj
+    MZ_multiply_matrix_by_scalar_into(&result, MZ_adjugate_matrix(source), 1.0f / det);
+
+    _MZ_scratch_end(scratch);
+
+    return result;
 }
 
 /*
 */
-void MZ_copy_vector_pointer(MZ_Vec* source, MZ_Vec* dest){
+MZ_Matrix MZ_inverse_of_matrix_by_rref(MZ_Matrix source){
 
-    if(dest->elements == NULL){ 
-        *dest= MZ_alloc_vector(source->dim); 
+    if (source.rows != source.cols || source.rows == 0)
+    {
+        return NULL_MATRIX;
     }
 
-    dest->dim = source->dim;
-    dest->elements = source->elements;
+    MZ_Matrix result = MZ_alloc_matrix(source.rows, source.cols);
 
-}
+    _MZ_Scratch scratch = _MZ_scratch_begin();
 
-/*
-*/
-MZ_Vec MZ_alloc_vector(size_t dim){
-    MZ_Vec result;
-    result.dim = dim;
-    result.elements = MZ_ALLOC(dim, float);
+    // augment the identity matrix
+    MZ_Matrix idMat = MZ_new_identity_matrix(source.rows);
+    MZ_Matrix opMat = MZ_append_matrix_to_matrix(source, idMat);
 
-    MZ_assert(result.elements != NULL, MZ_ALLOC_ERROR);
+    // row reduce the augmented matrix
+    MZ_to_reduced_echelon_form(&opMat);
+
+    // the left half is the identity only if the matrix is invertible
+    if (MZ_VALUE_OF_MAT_AT(opMat, source.rows - 1, source.cols - 1) != 1.0f)
+    {
+        _MZ_scratch_end(scratch);
+        MZ_free_matrix(&result);
+        return NULL_MATRIX;
+    }
+
+    // take the right half of the matrix -> that is the inverse
+    for (unsigned int i = 0; i < result.rows; i++)
+    {
+        for (unsigned int j = 0; j < result.cols; j++)
+        {
+            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(opMat, i, source.cols + j);
+        }
+    }
+
+    _MZ_scratch_end(scratch);
 
     return result;
 }
 
-/*
-*/
-MZ_Vec MZ_new_zero_vector(size_t dim){
+bool MZ_are_two_matrices_equal(MZ_Matrix matrix1, MZ_Matrix matrix2){
 
-    MZ_Vec result = MZ_alloc_vector(dim);
+    if(matrix1.rows != matrix2.rows || matrix1.cols != matrix2.cols) return false;
 
-    for(size_t i = 0; i < dim; i++){
-        MZ_VALUE_OF_VECTOR_AT(result, i) = 0.0f;
+    for(unsigned int i = 0; i < matrix1.rows; i++){
+        for(unsigned int j = 0; j < matrix1.cols; j++){
+            if((double)MZ_VALUE_OF_MAT_AT(matrix1, i, j) != (double)MZ_VALUE_OF_MAT_AT(matrix2, i, j)) return false;
+        }
     }
 
+    return true;
+}
+
+bool MZ_are_two_matrices_orthogonal(MZ_Matrix matrix1, MZ_Matrix matrix2){
+
+    if(matrix1.rows != matrix2.rows || matrix1.cols != matrix2.cols) return false;
+
+    _MZ_Scratch scratch = _MZ_scratch_begin();
+
+    bool result = MZ_are_two_matrices_equal(MZ_multiply_two_matrices(matrix1, matrix2), MZ_new_identity_matrix(matrix1.rows));
+
+    _MZ_scratch_end(scratch);
+
     return result;
 
 }
 
-/*
-*/
-MZ_Vec MZ_new_default_vector(size_t dim, float element){
+bool MZ_is_matrix_orthonormal(MZ_Matrix source){
 
-    MZ_Vec result = MZ_alloc_vector(dim);
+    _MZ_Scratch scratch = _MZ_scratch_begin();
 
-    for(size_t i = 0; i < dim; i++){
-        MZ_VALUE_OF_VECTOR_AT(result, i) = element;
+    if(source.rows == source.cols){
+        bool result = MZ_are_two_matrices_equal(MZ_inverse_of_matrix(source), MZ_transposed_matrix(source));
+        _MZ_scratch_end(scratch);
+        return result;
+    }
+
+    bool result = true;
+
+    for(unsigned int i = 1; i <= source.cols && result; i++){
+        MZ_Vec col =  MZ_get_vector_from_matrix_col(source, i);
+        if(!MZ_is_vector_normalized(col)) result = false;
+        for(unsigned int j = 1; j <= source.cols && result; j++){
+            if(i != j){
+                MZ_Vec col_2 = MZ_get_vector_from_matrix_col(source, j);
+                if(!MZ_are_two_vectors_orthogonal(col, col_2)){
+                    result = false;
+                }
+            }
+        }
     }
 
+    _MZ_scratch_end(scratch);
+
     return result;
 
 }
 
 /*
 */
-MZ_Vec MZ_new_random_float_vector(size_t dim, float min, float max){
+MZ_LU MZ_lu_decomposition_of_matrix(MZ_Matrix source){
 
-    MZ_Vec result = MZ_alloc_vector(dim);
+    MZ_assert(source.rows == source.cols && source.rows != 0, MZ_SQUARE_ERROR);
 
-    MZ_SRAND();
+    unsigned int n = source.rows;
 
-    for(size_t i = 0; i < dim; i++){
-        MZ_VALUE_OF_VECTOR_AT(result, i) = MZ_rand_float(min, max);
+    MZ_LU result;
+    result.dim = n;
+    result.sign = 1;
+    result.singular = false;
+
+    // the factors and the pivots share one allocation: n * n floats followed by n indices
+    result.elements = MZ_ALLOC((size_t)n * n + n, float);
+    MZ_assert(result.elements != NULL, MZ_ALLOC_ERROR);
+    result.pivots = (unsigned int*)(result.elements + (size_t)n * n);
+
+    float* a = result.elements;
+
+    for(unsigned int i = 0; i < n; i++){
+        memcpy(a + (size_t)i * n, &MZ_VALUE_OF_MAT_AT(source, i, 0), n * sizeof(float));
+        result.pivots[i] = i;
     }
 
-    return result;
-}
+    // multipliers of the current col, negated, so that every row below the pivot is updated in one pass
+    _MZ_Scratch scratch = _MZ_scratch_begin();
+    float* alphas = MZ_ALLOC(n, float);
 
-/*
-*/
-MZ_Vec MZ_new_random_int_vector(size_t dim, float min, float max){
+    for(unsigned int k = 0; k < n; k++){
 
-    MZ_Vec result = MZ_alloc_vector(dim);
+        unsigned int p = k;
+        float best = fabsf(a[(size_t)k * n + k]);
 
-    MZ_SRAND();
-    
-    for(size_t i = 0; i < dim; i++){
-        MZ_VALUE_OF_VECTOR_AT(result, i) = MZ_rand_int(min, max);
+        for(unsigned int i = k + 1; i < n; i++){
+            float v = fabsf(a[(size_t)i * n + k]);
+            if(v > best){
+                best = v;
+                p = i;
+            }
+        }
+
+        if(best == 0.0f){
+            result.singular = true;
+            continue;
+        }
+
+        if(p != k){
+            float* rowK = a + (size_t)k * n;
+            float* rowP = a + (size_t)p * n;
+            for(unsigned int j = 0; j < n; j++){
+                float tmp = rowK[j];
+                rowK[j] = rowP[j];
+                rowP[j] = tmp;
+            }
+            unsigned int tmp = result.pivots[k];
+            result.pivots[k] = result.pivots[p];
+            result.pivots[p] = tmp;
+            result.sign = -result.sign;
+        }
+
+        const float* pivotRow = a + (size_t)k * n;
+        float inv = 1.0f / pivotRow[k];
+
+        for(unsigned int i = k + 1; i < n; i++){
+            float l = a[(size_t)i * n + k] * inv;
+            a[(size_t)i * n + k] = l;
+            alphas[i - k - 1] = -l;
+        }
+        _MZ_axpy_rows(a + (size_t)(k + 1) * n + k + 1, n, n - k - 1, alphas, pivotRow + k + 1, n - k - 1);
+
+        #if VISUALIZE_STEPS
+        printf("LU step %u: pivot row %u\n", k, p);
+        #endif
     }
 
+    _MZ_scratch_end(scratch);
+
     return result;
 }
 
 /*
 */
-MZ_Vec _MZ_new_vector(size_t dim, ...){
+void MZ_free_lu(MZ_LU* lu){
 
-    MZ_Vec result = MZ_alloc_vector(dim);
+    MZ_assert(lu != NULL, "LU must not be NULL.");
 
-    va_list elem;
-    va_start(elem, dim);
+    MZ_FREE(lu->elements, (size_t)lu->dim * lu->dim + lu->dim, float);
+    lu->elements = NULL;
+    lu->pivots = NULL;
+    lu->dim = 0;
+}
 
-    for(size_t i = 0 ; i < dim; i++){
-        MZ_VALUE_OF_VECTOR_AT(result, i) = va_arg(elem, double);
-    }
+/*
+*/
+float MZ_determinant_of_lu(MZ_LU lu){
 
-    va_end(elem);
+    if(lu.singular) return 0.0f;
 
-    return result;
+    float det = (float)lu.sign;
+
+    for(unsigned int i = 0; i < lu.dim; i++){
+        det *= lu.elements[(size_t)i * lu.dim + i];
+    }
 
+    return det;
 }
 
 /*
+    Number of right-hand side columns solved together: the panel of X is kept small enough to stay
+    in cache while the rows of L and U stream over it once per panel.
 */
-MZ_Vec MZ_copy_vector(MZ_Vec source){
+#define _MZ_SOLVE_PANEL_BYTES (256 * 1024)
 
-    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(source));
+/*
+    Solves L * U * X = X in place, where X holds rows already permuted by the pivots.
+*/
+static void _MZ_lu_substitute(MZ_LU lu, float* x, size_t ldx, unsigned int nrhs){
 
-    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(source); i++){
-        MZ_VALUE_OF_VECTOR_AT(result , i) = MZ_VALUE_OF_VECTOR_AT(source, i);
-    }
+    unsigned int n = lu.dim;
+    const float* a = lu.elements;
 
-    return result;
+    size_t panel = _MZ_SOLVE_PANEL_BYTES / ((size_t)n * sizeof(float));
+    if(panel < 16) panel = 16;
+    if(panel > nrhs) panel = nrhs;
+
+    for(unsigned int c0 = 0; c0 < nrhs; c0 += panel){
+
+        unsigned int width = (unsigned int)(nrhs - c0 < panel ? nrhs - c0 : panel);
+
+        // forward substitution with the unit lower triangle
+        for(unsigned int i = 1; i < n; i++){
+            float* row = x + (size_t)i * ldx + c0;
+            for(unsigned int k = 0; k < i; k++){
+                float l = a[(size_t)i * n + k];
+                if(l == 0.0f) continue;
+                _MZ_axpy(row, x + (size_t)k * ldx + c0, -l, width);
+            }
+        }
 
+        // backward substitution with the upper triangle
+        for(unsigned int i = n; i-- > 0;){
+            float* row = x + (size_t)i * ldx + c0;
+            for(unsigned int k = i + 1; k < n; k++){
+                float u = a[(size_t)i * n + k];
+                if(u == 0.0f) continue;
+                _MZ_axpy(row, x + (size_t)k * ldx + c0, -u, width);
+            }
+            _MZ_scal(row, 1.0f / a[(size_t)i * n + i], width);
+        }
+    }
 }
 
 /*
+    Blocked right looking Cholesky on the lower triangle. For every block column the diagonal
+    block is factorized in place, the panel below it is solved against it row by row in
+    parallel, then the trailing matrix is updated by GEMM one block row at a time, only up to
+    the diagonal, so that the symmetric half is never computed.
 */
-MZ_Vec MZ_add_two_vectors(MZ_Vec vector1 , MZ_Vec vector2){
+#define _MZ_CHOLESKY_BLOCK 128
 
-    MZ_assert(MZ_DIM_OF_VECTOR(vector1) == MZ_DIM_OF_VECTOR(vector2), MZ_EQUAL_ERROR);
+// factorizes the b x b diagonal block at a in place, false if a pivot is not positive
+static bool _MZ_cholesky_block(float* a, size_t lda, size_t b){
 
-    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+    for(size_t j = 0; j < b; j++){
+        float* rowJ = a + j * lda;
 
-    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector1); i++){
-        MZ_VALUE_OF_VECTOR_AT(result , i) = MZ_VALUE_OF_VECTOR_AT(vector1, i) + MZ_VALUE_OF_VECTOR_AT(vector2, i);
+        float d = rowJ[j];
+        for(size_t p = 0; p < j; p++){
+            d -= rowJ[p] * rowJ[p];
+        }
+        // also catches a NaN
+        if(!(d > 0.0f)) return false;
+
+        float l = sqrtf(d);
+        float inv = 1.0f / l;
+        rowJ[j] = l;
+
+        for(size_t i = j + 1; i < b; i++){
+            float* rowI = a + i * lda;
+            float sum = rowI[j];
+            for(size_t p = 0; p < j; p++){
+                sum -= rowI[p] * rowJ[p];
+            }
+            rowI[j] = sum * inv;
+        }
     }
 
-    return result;
+    return true;
+}
 
+typedef struct _MZ_CholeskyPanelJob{
+    float* panel;
+    const float* diag;
+    size_t lda;
+    size_t b;
+}_MZ_CholeskyPanelJob;
+
+// row = row * L^-T for the rows [begin, end) of the panel
+static void _MZ_cholesky_panel_rows(void* ctx, size_t begin, size_t end){
+
+    _MZ_CholeskyPanelJob* job = (_MZ_CholeskyPanelJob*)ctx;
+
+    for(size_t i = begin; i < end; i++){
+        float* row = job->panel + i * job->lda;
+        for(size_t j = 0; j < job->b; j++){
+            const float* rowL = job->diag + j * job->lda;
+            float sum = row[j];
+            for(size_t p = 0; p < j; p++){
+                sum -= row[p] * rowL[p];
+            }
+            row[j] = sum / rowL[j];
+        }
+    }
 }
 
-/*
-*/
-MZ_Vec MZ_add_vector_with_scalar(MZ_Vec vector1 , float scalar){
+// factorizes a copy of the lower triangle of source, returns false if it is not positive definite
+static bool _MZ_cholesky_factorize(float* a, size_t n){
 
-    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+    for(size_t k = 0; k < n; k += _MZ_CHOLESKY_BLOCK){
 
-    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector1); i++){
-        MZ_VALUE_OF_VECTOR_AT(result , i) = MZ_VALUE_OF_VECTOR_AT(vector1, i) + scalar;
-    }
+        size_t b = n - k < _MZ_CHOLESKY_BLOCK ? n - k : _MZ_CHOLESKY_BLOCK;
+        float* diag = a + k * n + k;
 
-    return result;
-}
-    
-/*
-*/
-MZ_Vec MZ_subtract_two_vectors(MZ_Vec vector1 , MZ_Vec vector2){
+        if(!_MZ_cholesky_block(diag, n, b)) return false;
 
-    MZ_assert(MZ_DIM_OF_VECTOR(vector1) == MZ_DIM_OF_VECTOR(vector2), MZ_EQUAL_ERROR);
+        size_t next = k + b;
+        if(next == n) break;
 
-    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+        _MZ_CholeskyPanelJob job = { a + next * n + k, diag, n, b };
+        _MZ_parallel_for(n - next, MZ_PARALLEL_THRESHOLD / (b * b) + 1, _MZ_cholesky_panel_rows, &job);
 
-    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector1); i++){
-        MZ_VALUE_OF_VECTOR_AT(result , i) = MZ_VALUE_OF_VECTOR_AT(vector1, i) - MZ_VALUE_OF_VECTOR_AT(vector2, i);
+        // A22 -= L21 * L21^T, block row by block row up to the diagonal
+        for(size_t r = next; r < n; r += _MZ_CHOLESKY_BLOCK){
+            size_t rows = n - r < _MZ_CHOLESKY_BLOCK ? n - r : _MZ_CHOLESKY_BLOCK;
+            _MZ_gemm(false, true, rows, r + rows - next, b, -1.0f,
+                     a + r * n + k, n, a + next * n + k, n, 1.0f, a + r * n + next, n);
+        }
+
+        #if VISUALIZE_STEPS
+        printf("Cholesky step %zu\n", k);
+        #endif
     }
 
-    return result;  
+    return true;
 }
 
 /*
 */
-MZ_Vec MZ_subtract_vector_with_scalar(MZ_Vec vector1 , float scalar){
+MZ_Cholesky MZ_cholesky(MZ_Matrix source){
 
-    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+    MZ_assert(source.rows == source.cols && source.rows != 0, MZ_SQUARE_ERROR);
 
-    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector1); i++){
-        MZ_VALUE_OF_VECTOR_AT(result , i) = MZ_VALUE_OF_VECTOR_AT(vector1, i) - scalar;
+    unsigned int n = source.rows;
+
+    MZ_Cholesky result;
+    result.dim = n;
+    result.elements = MZ_ALLOC((size_t)n * n, float);
+    MZ_assert(result.elements != NULL, MZ_ALLOC_ERROR);
+
+    float* a = result.elements;
+
+    for(unsigned int i = 0; i < n; i++){
+        memcpy(a + (size_t)i * n, &MZ_VALUE_OF_MAT_AT(source, i, 0), (i + 1) * sizeof(float));
+    }
+
+    result.singular = !_MZ_cholesky_factorize(a, n);
+
+    // the upper triangle only ever held scratch values
+    for(unsigned int i = 0; i < n; i++){
+        memset(a + (size_t)i * n + i + 1, 0, (n - i - 1) * sizeof(float));
     }
 
     return result;
 }
 
 /*
+    Fast path of the general routines: a symmetric matrix with a positive diagonal is tried with
+    Cholesky first, which can only fail if it is not positive definite.
 */
-MZ_Vec MZ_multiply_two_vectors(MZ_Vec vector1, MZ_Vec vector2){
+static bool _MZ_try_cholesky(MZ_Matrix source, MZ_Cholesky* cholesky){
 
-    MZ_assert(MZ_DIM_OF_VECTOR(vector1) == MZ_DIM_OF_VECTOR(vector2), MZ_EQUAL_ERROR);
+    for(unsigned int i = 0; i < source.rows; i++){
+        if(!(MZ_VALUE_OF_MAT_AT(source, i, i) > 0.0f)) return false;
+        for(unsigned int j = 0; j < i; j++){
+            if(MZ_VALUE_OF_MAT_AT(source, i, j) != MZ_VALUE_OF_MAT_AT(source, j, i)) return false;
+        }
+    }
 
-    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+    *cholesky = MZ_cholesky(source);
 
-    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector1); i++){
-        MZ_VALUE_OF_VECTOR_AT(result , i) = MZ_VALUE_OF_VECTOR_AT(vector1, i) * MZ_VALUE_OF_VECTOR_AT(vector2, i);
+    if(cholesky->singular){
+        MZ_free_cholesky(cholesky);
+        return false;
     }
 
-    return result;  
+    return true;
 }
 
 /*
 */
-MZ_Vec MZ_multiply_vector_by_scalar(MZ_Vec vector1, float scalar){
-
-    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+void MZ_free_cholesky(MZ_Cholesky* cholesky){
 
-    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector1); i++){
-        MZ_VALUE_OF_VECTOR_AT(result , i) = MZ_VALUE_OF_VECTOR_AT(vector1, i) * scalar;
-    }
+    MZ_assert(cholesky != NULL, "Cholesky must not be NULL.");
 
-    return result;
+    MZ_FREE(cholesky->elements, (size_t)cholesky->dim * cholesky->dim, float);
+    cholesky->elements = NULL;
+    cholesky->dim = 0;
 }
 
 /*
 */
-MZ_Vec MZ_divide_two_vectors(MZ_Vec vector1, MZ_Vec vector2){
-
-    MZ_assert(MZ_DIM_OF_VECTOR(vector1) == MZ_DIM_OF_VECTOR(vector2), MZ_EQUAL_ERROR);
+float MZ_log_determinant_of_cholesky(MZ_Cholesky cholesky){
 
+    if(cholesky.singular) return NAN;
 
-    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+    double sum = 0.0;
 
-    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector1); i++){
-        if(MZ_VALUE_OF_VECTOR_AT(vector2 , i) == 0.0f) return NULL_VECTOR;
-        MZ_VALUE_OF_VECTOR_AT(result , i) = MZ_VALUE_OF_VECTOR_AT(vector1, i) / MZ_VALUE_OF_VECTOR_AT(vector2, i);
+    for(unsigned int i = 0; i < cholesky.dim; i++){
+        sum += log((double)cholesky.elements[(size_t)i * cholesky.dim + i]);
     }
 
-    return result;  
+    return (float)(2.0 * sum);
 }
 
-/*
-*/
-MZ_Vec MZ_divide_vector_by_scalar(MZ_Vec vector1, float scalar){
+typedef struct _MZ_CholeskySolveJob{
+    const float* l;
+    size_t lda;
+    float* x;
+    size_t ldx;
+    size_t b;
+}_MZ_CholeskySolveJob;
+
+// X = L^-1 * X on the cols [begin, end) of the b rows of X, L being a diagonal block
+static void _MZ_cholesky_forward_cols(void* ctx, size_t begin, size_t end){
+
+    _MZ_CholeskySolveJob* job = (_MZ_CholeskySolveJob*)ctx;
+
+    for(size_t i = 0; i < job->b; i++){
+        const float* rowL = job->l + i * job->lda;
+        float* row = job->x + i * job->ldx;
+        for(size_t k = 0; k < i; k++){
+            float lik = rowL[k];
+            if(lik == 0.0f) continue;
+            const float* src = job->x + k * job->ldx;
+            for(size_t j = begin; j < end; j++){
+                row[j] -= lik * src[j];
+            }
+        }
+        float inv = 1.0f / rowL[i];
+        for(size_t j = begin; j < end; j++){
+            row[j] *= inv;
+        }
+    }
+}
 
-    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector1));
+// X = L^-T * X on the cols [begin, end) of the b rows of X, the row i of L is the col i of L^T
+static void _MZ_cholesky_backward_cols(void* ctx, size_t begin, size_t end){
 
-    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector1); i++){
-        MZ_VALUE_OF_VECTOR_AT(result , i) = MZ_VALUE_OF_VECTOR_AT(vector1, i) / scalar;
-    }
+    _MZ_CholeskySolveJob* job = (_MZ_CholeskySolveJob*)ctx;
 
-    return result;
+    for(size_t i = job->b; i-- > 0;){
+        const float* rowL = job->l + i * job->lda;
+        float* row = job->x + i * job->ldx;
+        float inv = 1.0f / rowL[i];
+        for(size_t j = begin; j < end; j++){
+            row[j] *= inv;
+        }
+        for(size_t k = 0; k < i; k++){
+            float lik = rowL[k];
+            if(lik == 0.0f) continue;
+            float* dst = job->x + k * job->ldx;
+            for(size_t j = begin; j < end; j++){
+                dst[j] -= lik * row[j];
+            }
+        }
+    }
 }
 
 /*
+    Solves L * L^T * X = X in place by blocks of rows: the contribution of the rows already
+    solved is removed with one GEMM, then the block is solved against the diagonal block of L
+    with its cols spread over the threads.
 */
-MZ_Vec MZ_raise_vector_to_exp(MZ_Vec vector, size_t exponent){
+static void _MZ_cholesky_substitute(MZ_Cholesky cholesky, float* x, size_t ldx, unsigned int nrhs){
 
-    MZ_Vec result = MZ_copy_vector(vector);
-    
-    printf("\n");
-    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(result); i++){
-        for(size_t j = 0; j < exponent; j++){
-            MZ_VALUE_OF_VECTOR_AT(result, i) *= MZ_VALUE_OF_VECTOR_AT(vector, i);
+    size_t n = cholesky.dim;
+    const float* l = cholesky.elements;
 
-            #if VISUALIZE_STEPS
-            printf("%f -> %f |", MZ_VALUE_OF_VECTOR_AT(result, i) / MZ_VALUE_OF_VECTOR_AT(vector, i), MZ_VALUE_OF_VECTOR_AT(result, i));
-            #endif
+    for(size_t k = 0; k < n; k += _MZ_CHOLESKY_BLOCK){
+        size_t b = n - k < _MZ_CHOLESKY_BLOCK ? n - k : _MZ_CHOLESKY_BLOCK;
+
+        if(k > 0){
+            _MZ_gemm(false, false, b, nrhs, k, -1.0f, l + k * n, n, x, ldx, 1.0f, x + k * ldx, ldx);
         }
 
-        #if VISUALIZE_STEPS
-        printf("\n");
-        #endif
+        _MZ_CholeskySolveJob job = { l + k * n + k, n, x + k * ldx, ldx, b };
+        _MZ_parallel_for(nrhs, MZ_PARALLEL_THRESHOLD / (b * b) + 1, _MZ_cholesky_forward_cols, &job);
     }
 
-    return result;
+    size_t last = n == 0 ? 0 : (n - 1) / _MZ_CHOLESKY_BLOCK * _MZ_CHOLESKY_BLOCK;
+
+    for(size_t k = last + _MZ_CHOLESKY_BLOCK; k > 0;){
+        k -= _MZ_CHOLESKY_BLOCK;
+        size_t b = n - k < _MZ_CHOLESKY_BLOCK ? n - k : _MZ_CHOLESKY_BLOCK;
+        size_t next = k + b;
+
+        if(next < n){
+            _MZ_gemm(true, false, b, nrhs, n - next, -1.0f, l + next * n + k, n, x + next * ldx, ldx, 1.0f, x + k * ldx, ldx);
+        }
 
+        _MZ_CholeskySolveJob job = { l + k * n + k, n, x + k * ldx, ldx, b };
+        _MZ_parallel_for(nrhs, MZ_PARALLEL_THRESHOLD / (b * b) + 1, _MZ_cholesky_backward_cols, &job);
+    }
 }
 
 /*
 */
-MZ_Vec MZ_cross_product(MZ_Vec vector1, MZ_Vec vector2){
+MZ_Matrix MZ_inverse_of_matrix_by_cholesky(MZ_Matrix source){
 
-    if(MZ_DIM_OF_VECTOR(vector1) != 3 || MZ_DIM_OF_VECTOR(vector2) != 3){
-        return NULL_VECTOR;
+    MZ_assert(source.rows == source.cols && source.rows != 0, MZ_SQUARE_ERROR);
+
+    MZ_Matrix result = MZ_new_identity_matrix(source.rows);
+
+    _MZ_Scratch scratch = _MZ_scratch_begin();
+
+    MZ_Cholesky cholesky = MZ_cholesky(source);
+
+    if(cholesky.singular){
+        _MZ_scratch_end(scratch);
+        MZ_free_matrix(&result);
+        return NULL_MATRIX;
     }
 
-    MZ_Vec result = MZ_alloc_vector(3);
+    _MZ_cholesky_substitute(cholesky, result.elements, MZ_STRIDE_OF_MATRIX(result), result.cols);
 
-    MZ_VALUE_OF_VECTOR_AT(result , 0 ) = (MZ_VALUE_OF_VECTOR_AT(vector1, 1) * MZ_VALUE_OF_VECTOR_AT( vector2, 2)) - (MZ_VALUE_OF_VECTOR_AT(vector1 , 2) * MZ_VALUE_OF_VECTOR_AT(vector2 , 1));
-    MZ_VALUE_OF_VECTOR_AT(result , 1 ) = -1 * (MZ_VALUE_OF_VECTOR_AT(vector1, 0) * MZ_VALUE_OF_VECTOR_AT( vector2, 2)) - (MZ_VALUE_OF_VECTOR_AT(vector1 , 2) * MZ_VALUE_OF_VECTOR_AT(vector2 , 0));
-    MZ_VALUE_OF_VECTOR_AT(result , 2 ) = (MZ_VALUE_OF_VECTOR_AT(vector1, 0) * MZ_VALUE_OF_VECTOR_AT( vector2, 1)) - (MZ_VALUE_OF_VECTOR_AT(vector1 , 1) * MZ_VALUE_OF_VECTOR_AT(vector2 , 0));
+    _MZ_scratch_end(scratch);
 
     return result;
 }
 
 /*
 */
-MZ_Vec MZ_normalized_vector(MZ_Vec vector){
-
-    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(vector));
-    float mag = MZ_magnitude_of_vector(vector);
+MZ_Factorization MZ_factorize(MZ_Matrix source){
 
-    for(size_t i = 0 ; i < MZ_DIM_OF_VECTOR(vector); i++){
-        MZ_VALUE_OF_VECTOR_AT(result, i ) = MZ_VALUE_OF_VECTOR_AT(vector, i) / mag;
-    }
+    MZ_Factorization result;
+    result.kind = MZ_FACTORIZATION_LU;
+    result.lu = MZ_lu_decomposition_of_matrix(source);
 
     return result;
-
 }
 
 /*
 */
-MZ_Vec MZ_vector_proj_a_on_b(MZ_Vec vector_A, MZ_Vec vector_B){
-  
-  MZ_assert(vector_A.dim == vector_B.dim, MZ_EQUAL_ERROR);
-
-  if(MZ_are_two_vectors_orthogonal(vector_A, vector_B)){
-      MZ_Vec result = MZ_new_zero_vector(vector_A.dim);
-      return result;
-  }
-
-  MZ_Vec result = MZ_alloc_vector(vector_A.dim);
+MZ_Factorization MZ_factorize_spd(MZ_Matrix source){
 
-  result = MZ_multiply_vector_by_scalar(vector_B , MZ_scalar_proj_a_on_b(vector_A, vector_B));
+    MZ_Factorization result;
+    result.kind = MZ_FACTORIZATION_CHOLESKY;
+    result.cholesky = MZ_cholesky(source);
 
-  return result;
+    return result;
 }
 
 /*
 */
-void MZ_normalize_vector(MZ_Vec* vector){
+void MZ_free_factorization(MZ_Factorization* factorization){
 
-    float mag = MZ_magnitude_of_vector(*vector);
+    MZ_assert(factorization != NULL, "Factorization must not be NULL.");
 
-    for(size_t i = 0 ; i < vector->dim; i++){
-        vector->elements[i] /= mag;
+    switch(factorization->kind){
+        case MZ_FACTORIZATION_LU: MZ_free_lu(&factorization->lu); break;
+        case MZ_FACTORIZATION_CHOLESKY: MZ_free_cholesky(&factorization->cholesky); break;
+        default: break;
     }
 }
 
 /*
 */
-bool MZ_are_two_vectors_equal(MZ_Vec vector1, MZ_Vec vector2){
-
-    if(MZ_DIM_OF_VECTOR(vector1) != MZ_DIM_OF_VECTOR(vector2)) return false;
+bool MZ_is_factorization_singular(MZ_Factorization factorization){
 
-    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector1); i++){
-        if(MZ_VALUE_OF_VECTOR_AT(vector1, i) != MZ_VALUE_OF_VECTOR_AT(vector2, i)) return false;
+    switch(factorization.kind){
+        case MZ_FACTORIZATION_LU: return factorization.lu.singular;
+        case MZ_FACTORIZATION_CHOLESKY: return factorization.cholesky.singular;
+        default: return true;
     }
-
-    return true;
-
 }
 
 /*
 */
-bool MZ_are_two_vectors_orthogonal(MZ_Vec vector1, MZ_Vec vector2){
-    return MZ_dot_two_vectors(vector1, vector2) == 0; 
-}
+MZ_Vec MZ_solve_vec(MZ_Factorization factorization, MZ_Vec b){
 
-/*
-*/
-bool MZ_is_vector_normalized(MZ_Vec vector){
+    if(MZ_is_factorization_singular(factorization)) return NULL_VECTOR;
 
-    return fabs(MZ_magnitude_of_vector(vector) - 1.0) < 0.0001;
+    MZ_Vec result = MZ_alloc_vector(MZ_DIM_OF_VECTOR(b));
+
+    MZ_solve_vec_into(&result, factorization, b);
+
+    return result;
 }
 
 /*
 */
-float MZ_dot_two_vectors(MZ_Vec vector1, MZ_Vec vector2){
+static bool _MZ_cholesky_solve_vec(MZ_Vec* dest, MZ_Cholesky cholesky, MZ_Vec b){
 
-    MZ_assert(MZ_DIM_OF_VECTOR(vector1) == MZ_DIM_OF_VECTOR(vector2), MZ_EQUAL_ERROR);
+    unsigned int n = cholesky.dim;
 
-    float result = 0.0f;
+    MZ_assert(MZ_DIM_OF_VECTOR(b) == n && dest->dim == n, MZ_EQUAL_ERROR);
+    MZ_assert(dest->elements != b.elements, MZ_ALIAS_ERROR);
 
-    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector1); i++){
-        result += MZ_VALUE_OF_VECTOR_AT(vector1, i) * MZ_VALUE_OF_VECTOR_AT(vector2, i);
+    float* x = dest->elements;
+    const float* l = cholesky.elements;
+
+    // forward substitution with L, one dot product per row
+    for(unsigned int i = 0; i < n; i++){
+        float sum = MZ_VALUE_OF_VECTOR_AT(b, i);
+        const float* row = l + (size_t)i * n;
+        for(unsigned int k = 0; k < i; k++){
+            sum -= row[k] * x[k];
+        }
+        x[i] = sum / row[i];
     }
 
-    return result;
+    // backward substitution with L^T, its cols are the rows of L so each x[i] is spread upwards
+    for(unsigned int i = n; i-- > 0;){
+        const float* row = l + (size_t)i * n;
+        float xi = x[i] / row[i];
+        x[i] = xi;
+        for(unsigned int k = 0; k < i; k++){
+            x[k] -= row[k] * xi;
+        }
+    }
 
+    return true;
 }
 
 /*
 */
-float MZ_magnitude_of_vector(MZ_Vec vector){
+bool MZ_solve_vec_into(MZ_Vec* dest, MZ_Factorization factorization, MZ_Vec b){
 
-    float result = 0.0f;
+    if(MZ_is_factorization_singular(factorization)) return false;
 
-    for(size_t i = 0; i < MZ_DIM_OF_VECTOR(vector); i++){
-        result += MZ_VALUE_OF_VECTOR_AT(vector, i) * MZ_VALUE_OF_VECTOR_AT(vector, i);
+    if(factorization.kind == MZ_FACTORIZATION_CHOLESKY){
+        return _MZ_cholesky_solve_vec(dest, factorization.cholesky, b);
+    }
+
+    MZ_LU lu = factorization.lu;
+    unsigned int n = lu.dim;
+
+    MZ_assert(MZ_DIM_OF_VECTOR(b) == n && dest->dim == n, MZ_EQUAL_ERROR);
+    MZ_assert(dest->elements != b.elements, MZ_ALIAS_ERROR);
+
+    float* x = dest->elements;
+    const float* a = lu.elements;
+
+    // forward substitution on P * b, one dot product per row of L
+    for(unsigned int i = 0; i < n; i++){
+        float sum = MZ_VALUE_OF_VECTOR_AT(b, lu.pivots[i]);
+        const float* row = a + (size_t)i * n;
+        for(unsigned int k = 0; k < i; k++){
+            sum -= row[k] * x[k];
+        }
+        x[i] = sum;
     }
 
-    return sqrt(result);
+    // backward substitution, one dot product per row of U
+    for(unsigned int i = n; i-- > 0;){
+        float sum = x[i];
+        const float* row = a + (size_t)i * n;
+        for(unsigned int k = i + 1; k < n; k++){
+            sum -= row[k] * x[k];
+        }
+        x[i] = sum / row[i];
+    }
 
+    return true;
 }
 
-float MZ_scalar_proj_a_on_b(MZ_Vec vector_A, MZ_Vec vector_B){
+/*
+*/
+MZ_Matrix MZ_solve_mat(MZ_Factorization factorization, MZ_Matrix b){
 
-  MZ_assert(vector_A.dim == vector_B.dim, MZ_EQUAL_ERROR);
+    if(MZ_is_factorization_singular(factorization)) return NULL_MATRIX;
 
-  if(MZ_are_two_vectors_orthogonal(vector_A, vector_B)) return 0.0f;
-  
-  float result;
+    MZ_Matrix result = MZ_alloc_matrix(b.rows, b.cols);
 
-  result = MZ_dot_two_vectors(vector_A, vector_B) / powf(MZ_magnitude_of_vector(vector_B), 2.0f);
+    MZ_solve_mat_into(&result, factorization, b);
 
-  return result;
-  
+    return result;
 }
 
-MZ_Matrix NULL_MATRIX = {0, 0, NULL};
-
 /*
 */
-void MZ_print_matrix(FILE *fp, MZ_Matrix mat){
-	
-	#if VISUALIZE_RATIONAL
-	int spaces = 12;
-    #else
-    int spaces = 11;
-    #endif
+bool MZ_solve_mat_into(MZ_Matrix* dest, MZ_Factorization factorization, MZ_Matrix b){
 
-	fprintf(fp, "\n\n   | Matrix of size %ux%u: {\n", mat.rows, mat.cols);
-	
-    if(mat.elements == NULL){
+    if(MZ_is_factorization_singular(factorization)) return false;
 
-        int spaces = 13;
+    if(factorization.kind == MZ_FACTORIZATION_CHOLESKY){
 
-        fprintf(fp, "   |\t\t%c   ", LEFT_UP_CORNER);
-        for(unsigned int i = 0; i < 2; i++){
-            for(int i = 0; i < spaces; i++){
-                fprintf(fp, " ");
-            }	
-        }
-        fprintf(fp, "    %c   \n", RIGHT_UP_CORNER);
-        
-        for(unsigned int i = 0; i < 2; i++){
-            
-            fprintf(fp, "   |\t\t%c   ", SIDE_CHAR);
-            
-            for(unsigned int j = 0; j < 2; j++){
-                fprintf(fp, "%-13s ", MZ_NULL_MATRIX);
-            }		
-            fprintf(fp, "  %c\n", SIDE_CHAR);
-        }
+        MZ_assert(b.rows == factorization.cholesky.dim && dest->rows == b.rows && dest->cols == b.cols, MZ_EQUAL_ERROR);
+        MZ_assert(dest->elements != b.elements, MZ_ALIAS_ERROR);
 
-        fprintf(fp, "   |\t\t%c   ", LEFT_DOWN_CORNER);
-        for(unsigned int i = 0; i < 2; i++){
-            for(int i = 0; i < spaces; i++){
-                fprintf(fp, " ");
-            }
-        }
-        fprintf(fp, "    %c   \n", RIGHT_DOWN_CORNER);
-        fprintf(fp, "   | }\n\n");
+        MZ_copy_matrix_into(dest, b);
+        _MZ_cholesky_substitute(factorization.cholesky, dest->elements, MZ_STRIDE_OF_MATRIX(*dest), dest->cols);
 
-    }else {
+        return true;
+    }
 
-        fprintf(fp, "   |\t\t%c   ", LEFT_UP_CORNER);
-        for(unsigned int i = 0; i < mat.cols; i++){
-            for(int i = 0; i < spaces; i++){
-                fprintf(fp, " ");
-            }	
-        }
-        fprintf(fp, "%c   \n", RIGHT_UP_CORNER);
-        
-        for(unsigned int i = 0; i < mat.rows; i++){
-            
-            fprintf(fp, "   |\t\t%c   ", SIDE_CHAR);
-            
-            for(unsigned int j = 0; j < mat.cols; j++){
-                #if !VISUALIZE_RATIONAL
-                fprintf(fp, "%-11f", MZ_VALUE_OF_MAT_AT(mat, i, j));
-                #else
-                zstring value = rationalizeFloatToStr(MZ_VALUE_OF_MAT_AT(mat, i, j), 3);
-                fprintf(fp, " %-11s", value.data);
-                #endif
-            }		
-            fprintf(fp, "%c\n", SIDE_CHAR);
-        }
+    MZ_LU lu = factorization.lu;
 
-        fprintf(fp, "   |\t\t%c   ", LEFT_DOWN_CORNER);
-        for(unsigned int i = 0; i < mat.cols; i++){
-            for(int i = 0; i < spaces; i++){
-                fprintf(fp, " ");
-            }
-        }
-        fprintf(fp, "%c   \n", RIGHT_DOWN_CORNER);
-        fprintf(fp, "   | }\n\n");
+    MZ_assert(b.rows == lu.dim && dest->rows == b.rows && dest->cols == b.cols, MZ_EQUAL_ERROR);
+    MZ_assert(dest->elements != b.elements, MZ_ALIAS_ERROR);
 
+    for(unsigned int i = 0; i < dest->rows; i++){
+        memcpy(&MZ_VALUE_OF_MAT_POINTER_AT(dest, i, 0), &MZ_VALUE_OF_MAT_AT(b, lu.pivots[i], 0), b.cols * sizeof(float));
     }
-	
+
+    _MZ_lu_substitute(lu, dest->elements, MZ_STRIDE_OF_MATRIX(*dest), dest->cols);
+
+    return true;
 }
 
 /*
+    Blocked Householder QR. Every panel of _MZ_QR_BLOCK cols is factorized one reflector at a
+    time, then its reflectors are gathered in the compact WY form I - V * T * V^T so that the
+    trailing cols, and later any matrix multiplied by Q, are updated by three GEMMs instead of
+    one rank 1 update per reflector.
 */
-void MZ_print_matrix_by_label(FILE *fp, const char* label, MZ_Matrix mat){
-	
-	#if VISUALIZE_RATIONAL
-	int spaces = 12;
-    #else
-    int spaces = 11;
-    #endif
+#define _MZ_QR_BLOCK 32
 
-	fprintf(fp, "\n\n   | [%s] of size %ux%u: {\n", label, mat.rows, mat.cols);
+static inline size_t _MZ_qr_reflectors(MZ_QR qr){
+    return qr.rows < qr.cols ? qr.rows : qr.cols;
+}
 
-    if(mat.elements == NULL){
+static inline size_t _MZ_qr_size(MZ_QR qr){
+    size_t k = _MZ_qr_reflectors(qr);
+    size_t blocks = (k + _MZ_QR_BLOCK - 1) / _MZ_QR_BLOCK;
+    return (size_t)qr.rows * qr.cols + k + blocks * _MZ_QR_BLOCK * _MZ_QR_BLOCK;
+}
+
+// factorizes the cols [j0, j0 + b) of a, from the row j0 down, one reflector per col
+static void _MZ_qr_panel(float* a, size_t lda, size_t m, size_t j0, size_t b, float* tau){
 
-        int spaces = 13;
+    for(size_t j = j0; j < j0 + b; j++){
 
-        fprintf(fp, "   |\t\t%c   ", LEFT_UP_CORNER);
-        for(unsigned int i = 0; i < 2; i++){
-            for(int i = 0; i < spaces; i++){
-                fprintf(fp, " ");
-            }	
-        }
-        fprintf(fp, "    %c   \n", RIGHT_UP_CORNER);
-        
-        for(unsigned int i = 0; i < 2; i++){
-            
-            fprintf(fp, "   |\t\t%c   ", SIDE_CHAR);
-            
-            for(unsigned int j = 0; j < 2; j++){
-                fprintf(fp, "%-13s ", MZ_NULL_MATRIX);
-            }		
-            fprintf(fp, "  %c\n", SIDE_CHAR);
+        float alpha = a[j * lda + j];
+        double norm = 0.0;
+        for(size_t i = j + 1; i < m; i++){
+            double v = a[i * lda + j];
+            norm += v * v;
         }
 
-        fprintf(fp, "   |\t\t%c   ", LEFT_DOWN_CORNER);
-        for(unsigned int i = 0; i < 2; i++){
-            for(int i = 0; i < spaces; i++){
-                fprintf(fp, " ");
-            }
+        if(norm == 0.0){
+            tau[j] = 0.0f;
+            continue;
         }
-        fprintf(fp, "    %c   \n", RIGHT_DOWN_CORNER);
-        fprintf(fp, "   | }\n\n");
 
-    }else {
+        double beta = sqrt((double)alpha * alpha + norm);
+        if(alpha > 0.0f) beta = -beta;
 
-        fprintf(fp, "   |\t\t%c   ", LEFT_UP_CORNER);
-        for(unsigned int i = 0; i < mat.cols; i++){
-            for(int i = 0; i < spaces; i++){
-                fprintf(fp, " ");
-            }	
+        tau[j] = (float)((beta - alpha) / beta);
+        float scale = (float)(1.0 / (alpha - beta));
+        for(size_t i = j + 1; i < m; i++){
+            a[i * lda + j] *= scale;
         }
-        fprintf(fp, "%c   \n", RIGHT_UP_CORNER);
-	
-        for(unsigned int i = 0; i < mat.rows; i++){
-            
-            fprintf(fp, "   |\t\t%c   ", SIDE_CHAR);
-            
-            for(unsigned int j = 0; j < mat.cols; j++){
-                #if !VISUALIZE_RATIONAL
-                fprintf(fp, "%-11f", MZ_VALUE_OF_MAT_AT(mat, i, j));
-                #else
-                zstring value = rationalizeFloatToStr(MZ_VALUE_OF_MAT_AT(mat, i, j), 3);
-                fprintf(fp, " %-11s", value.data);
-                #endif
-            }		
-            fprintf(fp, "%c\n", SIDE_CHAR);
+        a[j * lda + j] = (float)beta;
+
+        // apply H = I - tau * v * v^T to the rest of the panel, v[0] being 1
+        size_t width = j0 + b - j - 1;
+        if(width == 0) continue;
+
+        float w[_MZ_QR_BLOCK];
+        const float* top = a + j * lda + j + 1;
+        for(size_t c = 0; c < width; c++) w[c] = top[c];
+        for(size_t i = j + 1; i < m; i++){
+            float v = a[i * lda + j];
+            const float* row = a + i * lda + j + 1;
+            for(size_t c = 0; c < width; c++) w[c] += v * row[c];
+        }
+        for(size_t c = 0; c < width; c++) w[c] *= tau[j];
+
+        float* rowTop = a + j * lda + j + 1;
+        for(size_t c = 0; c < width; c++) rowTop[c] -= w[c];
+        for(size_t i = j + 1; i < m; i++){
+            float v = a[i * lda + j];
+            if(v == 0.0f) continue;
+            float* row = a + i * lda + j + 1;
+            for(size_t c = 0; c < width; c++) row[c] -= v * w[c];
+        }
+    }
+}
+
+// copies the reflectors of the block starting at j0 into v, (m - j0) x b with their 1 and 0 explicit
+static void _MZ_qr_gather_v(const float* a, size_t lda, size_t m, size_t j0, size_t b, float* v){
+
+    for(size_t i = 0; i < m - j0; i++){
+        const float* src = a + (j0 + i) * lda + j0;
+        float* dst = v + i * b;
+        for(size_t c = 0; c < b; c++){
+            dst[c] = c < i ? src[c] : (c == i ? 1.0f : 0.0f);
         }
+    }
+}
 
-        fprintf(fp, "   |\t\t%c   ", LEFT_DOWN_CORNER);
-        for(unsigned int i = 0; i < mat.cols; i++){
-            for(int i = 0; i < spaces; i++){
-                fprintf(fp, " ");
-            }
+// builds the b x b upper triangular T of the block from its reflectors v and their scales
+static void _MZ_qr_form_t(const float* v, size_t rows, size_t b, const float* tau, float* t){
+
+    memset(t, 0, b * b * sizeof(float));
+
+    for(size_t i = 0; i < b; i++){
+
+        t[i * b + i] = tau[i];
+        if(tau[i] == 0.0f || i == 0) continue;
+
+        // z = -tau_i * V[:, 0:i]^T * v_i
+        float z[_MZ_QR_BLOCK] = { 0 };
+        for(size_t r = i; r < rows; r++){
+            float vi = v[r * b + i];
+            if(vi == 0.0f) continue;
+            const float* row = v + r * b;
+            for(size_t c = 0; c < i; c++) z[c] += row[c] * vi;
         }
-        fprintf(fp, "%c   \n", RIGHT_DOWN_CORNER);
-        fprintf(fp, "   | }\n\n");
 
+        // T[0:i, i] = T[0:i, 0:i] * z
+        for(size_t r = 0; r < i; r++){
+            float sum = 0.0f;
+            for(size_t c = r; c < i; c++) sum += t[r * b + c] * z[c];
+            t[r * b + i] = -tau[i] * sum;
+        }
     }
-	
 }
 
 /*
+    C = (I - V * T * V^T) * C, or with T^T for the transpose of the block, C being the rows
+    below j0 of a matrix of p cols. w and w2 hold b x p floats each.
 */
-void MZ_print_matrix_by_index(FILE *fp, unsigned int index, MZ_Matrix mat){
-	
-    #if VISUALIZE_RATIONAL
-	int spaces = 12;
-    #else
-    int spaces = 11;
-    #endif
-    
-    fprintf(fp, "\n\n   | [MATRIX %d] of size %ux%u: {\n", index, mat.rows, mat.cols);
+static void _MZ_qr_apply_block(const float* v, size_t rows, size_t b, const float* t, bool transpose,
+                               float* c, size_t ldc, size_t p, float* w, float* w2){
 
-    if(mat.elements == NULL){
+    _MZ_gemm(true, false, b, p, rows, 1.0f, v, b, c, ldc, 0.0f, w, p);
+    _MZ_gemm(transpose, false, b, p, b, 1.0f, t, b, w, p, 0.0f, w2, p);
+    _MZ_gemm(false, false, rows, p, b, -1.0f, v, b, w2, p, 1.0f, c, ldc);
+}
 
-        int spaces = 13;
+/*
+*/
+MZ_QR MZ_qr(MZ_Matrix source){
 
-        fprintf(fp, "   |\t\t%c   ", LEFT_UP_CORNER);
-        for(unsigned int i = 0; i < 2; i++){
-            for(int i = 0; i < spaces; i++){
-                fprintf(fp, " ");
-            }	
-        }
-        fprintf(fp, "    %c   \n", RIGHT_UP_CORNER);
-        
-        for(unsigned int i = 0; i < 2; i++){
-            
-            fprintf(fp, "   |\t\t%c   ", SIDE_CHAR);
-            
-            for(unsigned int j = 0; j < 2; j++){
-                fprintf(fp, "%-13s ", MZ_NULL_MATRIX);
-            }		
-            fprintf(fp, "  %c\n", SIDE_CHAR);
-        }
+    MZ_QR result;
+    result.rows = source.rows;
+    result.cols = source.cols;
 
-        fprintf(fp, "   |\t\t%c   ", LEFT_DOWN_CORNER);
-        for(unsigned int i = 0; i < 2; i++){
-            for(int i = 0; i < spaces; i++){
-                fprintf(fp, " ");
-            }
-        }
-        fprintf(fp, "    %c   \n", RIGHT_DOWN_CORNER);
-        fprintf(fp, "   | }\n\n");
+    size_t m = source.rows;
+    size_t n = source.cols;
+    size_t k = _MZ_qr_reflectors(result);
 
-    }else {
+    // the factors, the scales and the T of every block share one allocation
+    result.elements = MZ_ALLOC(_MZ_qr_size(result), float);
+    MZ_assert(result.elements != NULL, MZ_ALLOC_ERROR);
+    result.tau = result.elements + m * n;
+    result.t = result.tau + k;
 
-        fprintf(fp, "   |\t\t%c   ", LEFT_UP_CORNER);
-        for(unsigned int i = 0; i < mat.cols; i++){
-            for(int i = 0; i < spaces; i++){
-                fprintf(fp, " ");
-            }	
+    float* a = result.elements;
+
+    for(size_t i = 0; i < m; i++){
+        memcpy(a + i * n, &MZ_VALUE_OF_MAT_AT(source, i, 0), n * sizeof(float));
+    }
+
+    _MZ_Scratch scratch = _MZ_scratch_begin();
+
+    float* panel = MZ_ALLOC(m * _MZ_QR_BLOCK, float);
+    float* v = MZ_ALLOC(m * _MZ_QR_BLOCK, float);
+    float* w = MZ_ALLOC(2 * _MZ_QR_BLOCK * n, float);
+    MZ_assert(panel != NULL && v != NULL && w != NULL, MZ_ALLOC_ERROR);
+
+    for(size_t j0 = 0; j0 < k; j0 += _MZ_QR_BLOCK){
+
+        size_t b = k - j0 < _MZ_QR_BLOCK ? k - j0 : _MZ_QR_BLOCK;
+        float* t = result.t + j0 * _MZ_QR_BLOCK;
+
+        // the panel is factorized packed, its rows would otherwise be a whole row of a apart
+        for(size_t i = j0; i < m; i++){
+            memcpy(panel + (i - j0) * b, a + i * n + j0, b * sizeof(float));
         }
-        fprintf(fp, "%c   \n", RIGHT_UP_CORNER);
-	
-        for(unsigned int i = 0; i < mat.rows; i++){
-            
-            fprintf(fp, "   |\t\t%c   ", SIDE_CHAR);
-            
-            for(unsigned int j = 0; j < mat.cols; j++){
-                #if !VISUALIZE_RATIONAL
-                fprintf(fp, "%-11f", MZ_VALUE_OF_MAT_AT(mat, i, j));
-                #else
-                zstring value = rationalizeFloatToStr(MZ_VALUE_OF_MAT_AT(mat, i, j), 3);
-                fprintf(fp, " %-11s", value.data);
-                #endif
-            }		
-            fprintf(fp, "%c\n", SIDE_CHAR);
+        _MZ_qr_panel(panel, b, m - j0, 0, b, result.tau + j0);
+        for(size_t i = j0; i < m; i++){
+            memcpy(a + i * n + j0, panel + (i - j0) * b, b * sizeof(float));
         }
 
-        fprintf(fp, "   |\t\t%c   ", LEFT_DOWN_CORNER);
-        for(unsigned int i = 0; i < mat.cols; i++){
-            for(int i = 0; i < spaces; i++){
-                fprintf(fp, " ");
-            }
+        _MZ_qr_gather_v(panel, b, m - j0, 0, b, v);
+        _MZ_qr_form_t(v, m - j0, b, result.tau + j0, t);
+
+        size_t next = j0 + b;
+        if(next < n){
+            _MZ_qr_apply_block(v, m - j0, b, t, true, a + j0 * n + next, n, n - next, w, w + _MZ_QR_BLOCK * (n - next));
         }
-        fprintf(fp, "%c   \n", RIGHT_DOWN_CORNER);
-        fprintf(fp, "   | }\n\n");
 
+        #if VISUALIZE_STEPS
+        printf("QR step %zu\n", j0);
+        #endif
     }
-	
+
+    _MZ_scratch_end(scratch);
+
+    return result;
 }
 
 /*
 */
-void MZ_free_matrix(MZ_Matrix* mat){
-    MZ_assert(mat->elements != NULL, "Matrix must not be NULL.");
+void MZ_free_qr(MZ_QR* qr){
 
-    free(mat->elements);
-    mat->elements = NULL;
-    mat->rows = 0;
-    mat->cols = 0;
+    MZ_assert(qr != NULL, "QR must not be NULL.");
+
+    MZ_FREE(qr->elements, _MZ_qr_size(*qr), float);
+    qr->elements = NULL;
+    qr->tau = NULL;
+    qr->t = NULL;
+    qr->rows = 0;
+    qr->cols = 0;
 }
 
 /*
 */
-void MZ_copy_matrix_pointer(MZ_Matrix *source, MZ_Matrix *dest){
+void MZ_apply_q_of_qr(MZ_QR qr, MZ_Transpose trans, MZ_Matrix* target){
 
-    if(dest->elements == NULL){ 
-        *dest= MZ_alloc_matrix(source->rows, source->cols); 
-    }
+    MZ_assert(target->rows == qr.rows, MZ_EQUAL_ERROR);
 
-    dest->rows = source->rows;
-    dest->cols = source->cols;
-    dest->elements = source->elements;
+    size_t m = qr.rows;
+    size_t k = _MZ_qr_reflectors(qr);
+    size_t p = target->cols;
+    size_t ldc = MZ_STRIDE_OF_MATRIX(*target);
 
-    memcpy(dest, source, sizeof(MZ_Matrix));
+    if(k == 0 || p == 0) return;
 
-}
+    _MZ_Scratch scratch = _MZ_scratch_begin();
 
-/*
-*/
-MZ_Matrix MZ_alloc_matrix(unsigned int rows, unsigned int cols){
+    float* v = MZ_ALLOC(m * _MZ_QR_BLOCK, float);
+    float* w = MZ_ALLOC(2 * _MZ_QR_BLOCK * p, float);
+    MZ_assert(v != NULL && w != NULL, MZ_ALLOC_ERROR);
 
-    MZ_Matrix result;
-    result.rows = rows;
-    result.cols = cols;
+    size_t blocks = (k + _MZ_QR_BLOCK - 1) / _MZ_QR_BLOCK;
 
-    result.elements = MZ_ALLOC(rows * cols, float);
+    // Q^T = Q_last^T * ... * Q_1^T starts from the first block, Q from the last one
+    for(size_t step = 0; step < blocks; step++){
 
-    MZ_assert(result.elements != NULL, MZ_ALLOC_ERROR);
+        size_t block = trans == MZ_TRANSPOSE ? step : blocks - 1 - step;
+        size_t j0 = block * _MZ_QR_BLOCK;
+        size_t b = k - j0 < _MZ_QR_BLOCK ? k - j0 : _MZ_QR_BLOCK;
 
-    return result;
+        _MZ_qr_gather_v(qr.elements, qr.cols, m, j0, b, v);
+        _MZ_qr_apply_block(v, m - j0, b, qr.t + j0 * _MZ_QR_BLOCK, trans == MZ_TRANSPOSE,
+                           target->elements + j0 * ldc, ldc, p, w, w + _MZ_QR_BLOCK * p);
+    }
 
+    _MZ_scratch_end(scratch);
 }
 
 /*
 */
-MZ_Matrix MZ_new_zero_matrix(unsigned int rows, unsigned int cols){
+MZ_Matrix MZ_q_of_qr(MZ_QR qr){
 
-    MZ_Matrix result = MZ_alloc_matrix(rows, cols);
+    unsigned int k = (unsigned int)_MZ_qr_reflectors(qr);
 
-    for(unsigned int i = 0; i < rows; i++){
-        for(unsigned int j = 0; j < cols; j++){
-            MZ_VALUE_OF_MAT_AT(result, i, j) = 0.0f;
-        }
+    MZ_Matrix result = MZ_new_zero_matrix(qr.rows, k);
+    for(unsigned int i = 0; i < k; i++){
+        MZ_VALUE_OF_MAT_AT(result, i, i) = 1.0f;
     }
 
-    return result;
+    MZ_apply_q_of_qr(qr, MZ_NO_TRANSPOSE, &result);
 
+    return result;
 }
 
 /*
 */
-MZ_Matrix MZ_new_random_float_matrix(unsigned int rows, unsigned int cols, float min, float max){
+MZ_Matrix MZ_r_of_qr(MZ_QR qr){
 
-    MZ_Matrix result = MZ_alloc_matrix(rows, cols);
-    
-    MZ_SRAND();
+    unsigned int k = (unsigned int)_MZ_qr_reflectors(qr);
 
-    for(unsigned int i = 0; i < rows; i++){
-        for(unsigned int j = 0; j < cols; j++){
-            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_rand_float(min, max);
-        }
+    MZ_Matrix result = MZ_new_zero_matrix(k, qr.cols);
+
+    for(unsigned int i = 0; i < k; i++){
+        memcpy(&MZ_VALUE_OF_MAT_AT(result, i, i), qr.elements + (size_t)i * qr.cols + i, (qr.cols - i) * sizeof(float));
     }
 
     return result;
-   
 }
 
 /*
 */
-MZ_Matrix MZ_new_random_int_matrix(unsigned int rows, unsigned int cols, int min, int max){
-
-    MZ_Matrix result = MZ_alloc_matrix(rows, cols);
+MZ_Vec MZ_least_squares(MZ_Matrix source, MZ_Vec b){
 
-    MZ_SRAND();
+    MZ_Vec result = MZ_alloc_vector(source.cols);
 
-    for(unsigned int i = 0; i < rows; i++){
-        for(unsigned int j = 0; j < cols; j++){
-            MZ_VALUE_OF_MAT_AT(result, i, j) = (float)MZ_rand_int(min, max);
-        }
+    if(!MZ_least_squares_into(&result, source, b)){
+        MZ_free_vector(&result);
+        return NULL_VECTOR;
     }
 
     return result;
-   
 }
 
 /*
 */
-MZ_Matrix MZ_new_default_matrix(unsigned int rows, unsigned int cols, float value){
+bool MZ_least_squares_into(MZ_Vec* dest, MZ_Matrix source, MZ_Vec b){
 
-    MZ_Matrix result = MZ_alloc_matrix(rows, cols);
+    MZ_assert(source.rows >= source.cols, "Matrix must have at least as many rows as cols.");
+    MZ_assert(MZ_DIM_OF_VECTOR(b) == source.rows && dest->dim == source.cols, MZ_EQUAL_ERROR);
 
-    for(unsigned int i = 0; i < rows; i++){
-        for(unsigned int j = 0; j < cols; j++){
-            MZ_VALUE_OF_MAT_AT(result, i, j) = value;
-        }
-    }
+    size_t n = source.cols;
 
-    return result;
+    _MZ_Scratch scratch = _MZ_scratch_begin();
 
-}
+    MZ_QR qr = MZ_qr(source);
 
-MZ_Matrix MZ_new_identity_matrix(unsigned int dim){
-    MZ_Matrix result = MZ_alloc_matrix(dim, dim);
+    // y = Q^T * b, only its first n components matter
+    MZ_Vec y = MZ_copy_vector(b);
+    MZ_Matrix column = MZ_view_of_vector_as_matrix(y, source.rows, 1);
+    MZ_apply_q_of_qr(qr, MZ_TRANSPOSE, &column);
 
-    for(unsigned int i = 0; i < dim; i++){
-        for(unsigned int j = 0; j < dim; j++){
-            if(i == j){
-                MZ_VALUE_OF_MAT_AT(result, i, j) = 1.0f;
-            }else {
-                MZ_VALUE_OF_MAT_AT(result, i, j) = 0.0f;
-            }
+    // the cols are dependent when a diagonal element of R is lost in the rounding of the largest one
+    float largest = 0.0f;
+    for(size_t i = 0; i < n; i++){
+        float v = fabsf(qr.elements[i * n + i]);
+        if(v > largest) largest = v;
+    }
+    float tolerance = (float)(source.rows > source.cols ? source.rows : source.cols) * FLT_EPSILON * largest;
+
+    // R * x = y by backward substitution
+    for(size_t i = n; i-- > 0;){
+        const float* row = qr.elements + i * n;
+        if(fabsf(row[i]) <= tolerance){
+            _MZ_scratch_end(scratch);
+            return false;
+        }
+        float sum = y.elements[i];
+        for(size_t c = i + 1; c < n; c++){
+            sum -= row[c] * y.elements[c];
         }
+        y.elements[i] = sum / row[i];
     }
 
-    return result;
+    memcpy(dest->elements, y.elements, n * sizeof(float));
+
+    _MZ_scratch_end(scratch);
 
+    return true;
 }
 
 /*
-*/
-MZ_Matrix _MZ_new_matrix(unsigned int rows, unsigned int cols, unsigned int numVals, ...){
+    Rank by QR with column pivoting. The work is done on the transpose of the source, so that
+    each col is a contiguous row: picking the col of largest remaining norm is a swap of two rows,
+    and every reflector updates the remaining cols independently, spread over the threads. The
+    norms are downdated after each reflector and recomputed when cancellation ate their digits.
+*/
+typedef struct _MZ_RankJob{
+    float* cols;
+    size_t ld;
+    size_t first;
+    size_t k;
+    size_t len;
+    const float* v;
+    float tau;
+    double* norms;
+    double* exact;
+}_MZ_RankJob;
+
+// applies the reflector (1, v) at k to the cols [first + begin, first + end) and downdates their norms
+static void _MZ_rank_cols(void* ctx, size_t begin, size_t end){
+
+    _MZ_RankJob* job = (_MZ_RankJob*)ctx;
+
+    for(size_t c = job->first + begin; c < job->first + end; c++){
+        float* col = job->cols + c * job->ld + job->k;
+
+        float s = job->tau * (col[0] + (float)_MZ_dot(job->v + 1, col + 1, job->len - 1));
+
+        col[0] -= s;
+        _MZ_axpy(col + 1, job->v + 1, -s, job->len - 1);
+
+        double norm = job->norms[c] - (double)col[0] * col[0];
+        if(norm <= job->exact[c] * 1e-3){
+            norm = _MZ_dot(col + 1, col + 1, job->len - 1);
+            job->exact[c] = norm;
+        }
+        job->norms[c] = norm;
+    }
+}
 
-    MZ_Matrix result = MZ_alloc_matrix(rows, cols);
-    
-    va_list args;
-    va_start(args, numVals);
+static unsigned int _MZ_rank(MZ_Matrix source, float tolerance, bool defaultTolerance){
 
-    unsigned int vals = 0;
+    size_t m = source.rows;
+    size_t n = source.cols;
+    size_t steps = m < n ? m : n;
 
-    for(unsigned int i = 0; i < result.rows; i++){
-        for(unsigned int j = 0 ; j < result.cols; j++){
-            if(vals++ < numVals){
-                MZ_VALUE_OF_MAT_AT(result, i, j) =  va_arg(args, double);
-            }else {
-                MZ_VALUE_OF_MAT_AT(result, i, j) = 0.0f;
+    if(steps == 0) return 0;
+
+    _MZ_Scratch scratch = _MZ_scratch_begin();
+
+    // the n cols of the source as n rows of m floats
+    MZ_Matrix cols = MZ_alloc_matrix((unsigned int)n, (unsigned int)m);
+    MZ_transposed_matrix_into(&cols, source);
+
+    double* norms = MZ_ALLOC(2 * n, double);
+    MZ_assert(norms != NULL, MZ_ALLOC_ERROR);
+    double* exact = norms + n;
+
+    for(size_t c = 0; c < n; c++){
+        norms[c] = _MZ_dot(cols.elements + c * m, cols.elements + c * m, m);
+        exact[c] = norms[c];
+    }
+
+    unsigned int rank = 0;
+
+    for(size_t k = 0; k < steps; k++){
+
+        size_t p = k;
+        for(size_t c = k + 1; c < n; c++){
+            if(norms[c] > norms[p]) p = c;
+        }
+        if(p != k){
+            _MZ_swap_floats(cols.elements + k * m, cols.elements + p * m, m);
+            double tmp = norms[k]; norms[k] = norms[p]; norms[p] = tmp;
+            tmp = exact[k]; exact[k] = exact[p]; exact[p] = tmp;
+        }
+
+        float* x = cols.elements + k * m + k;
+        size_t len = m - k;
+
+        double tail = _MZ_dot(x + 1, x + 1, len - 1);
+
+        double alpha = x[0];
+        double beta = sqrt(alpha * alpha + tail);
+
+        // |R[k][k]| is the norm of what is left of the col, the largest of them
+        if(k == 0 && defaultTolerance){
+            tolerance = (float)((m > n ? m : n) * FLT_EPSILON * beta);
+        }
+        if(!(beta > tolerance) || beta == 0.0) break;
+
+        rank++;
+
+        if(k + 1 == n) break;
+
+        // with nothing below x[0] the reflector is the identity, the norms still lose their k-th component
+        float tau = 0.0f;
+        if(tail != 0.0){
+            if(alpha > 0.0) beta = -beta;
+            tau = (float)((beta - alpha) / beta);
+            float scale = (float)(1.0 / (alpha - beta));
+            for(size_t i = 1; i < len; i++){
+                x[i] *= scale;
             }
+            x[0] = (float)beta;
         }
+
+        _MZ_RankJob job = { cols.elements, m, k + 1, k, len, x, tau, norms, exact };
+        _MZ_parallel_for(n - k - 1, MZ_PARALLEL_THRESHOLD / (2 * len) + 1, _MZ_rank_cols, &job);
     }
 
-    va_end(args);
+    _MZ_scratch_end(scratch);
 
-    return result;
+    return rank;
+}
 
+/*
+*/
+unsigned int MZ_rank(MZ_Matrix source){
+    return _MZ_rank(source, 0.0f, true);
 }
 
 /*
 */
-MZ_Matrix MZ_Vector_to_matrix(MZ_Vec source, Direction dir){
+unsigned int MZ_rank_with_tolerance(MZ_Matrix source, float tolerance){
+    return _MZ_rank(source, tolerance, false);
+}
 
-    MZ_assert(dir < DIR_COUNT, MZ_DIRECTION_ERROR);
+/*
+    Fixed size types. Everything is written out by hand so that the compiler keeps the
+    values in registers, the 4 wide rows of MZ_Mat4 go through GCC vectors when available.
+*/
+#if defined(__GNUC__) || defined(__clang__)
+typedef float _MZ_v4 __attribute__((vector_size(16)));
+#define _MZ_V4_VECTORS 1
+#else
+#define _MZ_V4_VECTORS 0
+#endif
 
-    MZ_Matrix result;
+/*
+*/
+MZ_Vec3 MZ_new_vec3(float x, float y, float z){
+    MZ_Vec3 result = {{ x, y, z }};
+    return result;
+}
 
-    switch(dir){
-        case HORIZONTAL: {
-            result = MZ_alloc_matrix(1, MZ_DIM_OF_VECTOR(source));
+/*
+*/
+MZ_Vec3 MZ_add_two_vec3(MZ_Vec3 vector1, MZ_Vec3 vector2){
+    return MZ_new_vec3(vector1.x + vector2.x, vector1.y + vector2.y, vector1.z + vector2.z);
+}
 
-            for(unsigned int i = 0; i < result.cols; i++){
-                MZ_VALUE_OF_MAT_AT(result, 0, i) = source.elements[i];
-            }       
+/*
+*/
+MZ_Vec3 MZ_subtract_two_vec3(MZ_Vec3 vector1, MZ_Vec3 vector2){
+    return MZ_new_vec3(vector1.x - vector2.x, vector1.y - vector2.y, vector1.z - vector2.z);
+}
 
-        } break;
-        case VERTICAL: {
-            result = MZ_alloc_matrix(source.dim, 1); 
+/*
+*/
+MZ_Vec3 MZ_multiply_vec3_by_scalar(MZ_Vec3 vector, float scalar){
+    return MZ_new_vec3(vector.x * scalar, vector.y * scalar, vector.z * scalar);
+}
 
-            for(unsigned int i = 0; i < result.rows; i++){
-                MZ_VALUE_OF_MAT_AT(result, i, 0) = source.elements[i];
-            }  
+/*
+*/
+float MZ_dot_two_vec3(MZ_Vec3 vector1, MZ_Vec3 vector2){
+    return vector1.x * vector2.x + vector1.y * vector2.y + vector1.z * vector2.z;
+}
 
-        } break;
-        default: break;
-    }
+/*
+*/
+MZ_Vec3 MZ_cross_product_vec3(MZ_Vec3 vector1, MZ_Vec3 vector2){
+    return MZ_new_vec3(vector1.y * vector2.z - vector1.z * vector2.y,
+                       vector1.z * vector2.x - vector1.x * vector2.z,
+                       vector1.x * vector2.y - vector1.y * vector2.x);
+}
+
+/*
+*/
+float MZ_magnitude_of_vec3(MZ_Vec3 vector){
+    return sqrtf(MZ_dot_two_vec3(vector, vector));
+}
+
+/*
+*/
+MZ_Vec3 MZ_normalized_vec3(MZ_Vec3 vector){
+    return MZ_multiply_vec3_by_scalar(vector, 1.0f / MZ_magnitude_of_vec3(vector));
+}
 
+/*
+*/
+MZ_Vec4 MZ_new_vec4(float x, float y, float z, float w){
+    MZ_Vec4 result = {{ x, y, z, w }};
     return result;
+}
 
+/*
+*/
+MZ_Vec4 MZ_add_two_vec4(MZ_Vec4 vector1, MZ_Vec4 vector2){
+    return MZ_new_vec4(vector1.x + vector2.x, vector1.y + vector2.y, vector1.z + vector2.z, vector1.w + vector2.w);
 }
 
 /*
 */
-MZ_Vec MZ_Matrix_to_vector(MZ_Matrix source){
+MZ_Vec4 MZ_subtract_two_vec4(MZ_Vec4 vector1, MZ_Vec4 vector2){
+    return MZ_new_vec4(vector1.x - vector2.x, vector1.y - vector2.y, vector1.z - vector2.z, vector1.w - vector2.w);
+}
 
-    MZ_Vec result = MZ_alloc_vector(source.rows * source.cols);   
+/*
+*/
+MZ_Vec4 MZ_multiply_vec4_by_scalar(MZ_Vec4 vector, float scalar){
+    return MZ_new_vec4(vector.x * scalar, vector.y * scalar, vector.z * scalar, vector.w * scalar);
+}
 
-    for(unsigned int i = 0; i < source.rows; i++){
-        for(unsigned int j = 0; j < source.cols; j++){
-            result.elements[j + i * source.cols] = MZ_VALUE_OF_MAT_AT(source, i, j);
-        }
-    }
+/*
+*/
+float MZ_dot_two_vec4(MZ_Vec4 vector1, MZ_Vec4 vector2){
+    return (vector1.x * vector2.x + vector1.y * vector2.y) + (vector1.z * vector2.z + vector1.w * vector2.w);
+}
 
-    return result;
+/*
+*/
+float MZ_magnitude_of_vec4(MZ_Vec4 vector){
+    return sqrtf(MZ_dot_two_vec4(vector, vector));
 }
 
 /*
 */
-MZ_Vec MZ_get_vector_from_matrix_row(MZ_Matrix source, unsigned int row){
+MZ_Vec4 MZ_normalized_vec4(MZ_Vec4 vector){
+    return MZ_multiply_vec4_by_scalar(vector, 1.0f / MZ_magnitude_of_vec4(vector));
+}
 
-    row--;
+/*
+*/
+MZ_Mat3 MZ_identity_mat3(void){
+    MZ_Mat3 result = {{ { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } }};
+    return result;
+}
 
-    if(row > source.rows){ return NULL_VECTOR; }
+/*
+*/
+MZ_Mat3 MZ_multiply_two_mat3(MZ_Mat3 matrix1, MZ_Mat3 matrix2){
 
-    MZ_Vec result = MZ_alloc_vector(source.cols);   
+    MZ_Mat3 result;
+    const float (*a)[3] = matrix1.elements;
+    const float (*b)[3] = matrix2.elements;
 
-    for(unsigned int i = 0; i < source.cols; i++){
-        result.elements[i] = MZ_VALUE_OF_MAT_AT(source, row, i);
+    for(int i = 0; i < 3; i++){
+        result.elements[i][0] = a[i][0] * b[0][0] + a[i][1] * b[1][0] + a[i][2] * b[2][0];
+        result.elements[i][1] = a[i][0] * b[0][1] + a[i][1] * b[1][1] + a[i][2] * b[2][1];
+        result.elements[i][2] = a[i][0] * b[0][2] + a[i][1] * b[1][2] + a[i][2] * b[2][2];
     }
 
     return result;
@@ -1944,654 +8463,856 @@ MZ_Vec MZ_get_vector_from_matrix_row(MZ_Matrix source, unsigned int row){
 
 /*
 */
-MZ_Vec MZ_get_vector_from_matrix_col(MZ_Matrix source, unsigned int col){
+MZ_Vec3 MZ_multiply_mat3_by_vec3(MZ_Mat3 matrix, MZ_Vec3 vector){
 
-    col--;
+    const float (*m)[3] = matrix.elements;
 
-    if(col > source.cols){ return NULL_VECTOR; }
+    return MZ_new_vec3(m[0][0] * vector.x + m[0][1] * vector.y + m[0][2] * vector.z,
+                       m[1][0] * vector.x + m[1][1] * vector.y + m[1][2] * vector.z,
+                       m[2][0] * vector.x + m[2][1] * vector.y + m[2][2] * vector.z);
+}
 
-    MZ_Vec result = MZ_alloc_vector(source.rows);   
+/*
+*/
+MZ_Mat3 MZ_transposed_mat3(MZ_Mat3 source){
 
-    for(unsigned int i = 0; i < source.cols; i++){
-        result.elements[i] = MZ_VALUE_OF_MAT_AT(source, i, col);
-    }
+    const float (*m)[3] = source.elements;
 
+    MZ_Mat3 result = {{ { m[0][0], m[1][0], m[2][0] },
+                        { m[0][1], m[1][1], m[2][1] },
+                        { m[0][2], m[1][2], m[2][2] } }};
     return result;
 }
 
 /*
 */
-MZ_Matrix MZ_flatten_matrix(MZ_Matrix matrix, Direction dir){
-    MZ_Matrix result;
-
-    switch(dir){
-        case VERTICAL:{
-            result = MZ_alloc_matrix(matrix.rows * matrix.cols, 1);
-        }break;
-        case HORIZONTAL:{
-            result = MZ_alloc_matrix(1, matrix.rows * matrix.cols);
-        }break;
-    }
+float MZ_determinant_of_mat3(MZ_Mat3 source){
 
-    for(unsigned int i = 0; i < matrix.rows; i++){
-        for(unsigned int j = 0; j < matrix.cols; j++){
-            switch(dir){
-                case VERTICAL:{
-                    MZ_VALUE_OF_MAT_AT(result, i*matrix.cols + j, 0) = MZ_VALUE_OF_MAT_AT(matrix, i, j);
-                }break;
-                case HORIZONTAL:{
-                    MZ_VALUE_OF_MAT_AT(result, 0, i*matrix.cols + j) = MZ_VALUE_OF_MAT_AT(matrix, i, j);
-                }break;
-            }
-        }
-    }
+    const float (*m)[3] = source.elements;
 
-    return result;
+    return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+         - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+         + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
 }
 
 /*
 */
-MZ_Matrix MZ_add_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2){
+bool MZ_inverse_of_mat3(MZ_Mat3 source, MZ_Mat3* result){
 
-    MZ_assert(matrix1.rows == matrix2.rows && matrix1.cols == matrix2.cols, MZ_EQUAL_ERROR);
-    
-    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
+    const float (*m)[3] = source.elements;
 
-    for(unsigned int i = 0; i < result.rows; i++){
-        for(unsigned int j = 0; j < result.cols; j++){
-            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(matrix1, i, j) + MZ_VALUE_OF_MAT_AT(matrix2, i, j);
-        }
-    }
+    // cofactors of the first row, reused by the determinant
+    float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
 
-    return result;
+    float det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
 
+    if(det == 0.0f) return false;
+
+    float inv = 1.0f / det;
+
+    // inverse = adjugate / det, the adjugate being the transposed cofactor matrix
+    MZ_Mat3 r = {{
+        { c00 * inv, (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv, (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv },
+        { c01 * inv, (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv, (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv },
+        { c02 * inv, (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv, (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv },
+    }};
+
+    *result = r;
+
+    return true;
 }
 
 /*
 */
-MZ_Matrix MZ_add_matrix_with_scalar(MZ_Matrix matrix1, float scalar){
-    
-    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
-
-    for(unsigned int i = 0; i < result.rows; i++){
-        for(unsigned int j = 0; j < result.cols; j++){
-            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(matrix1, i, j) + scalar;
-        }
-    }
-
+MZ_Mat4 MZ_identity_mat4(void){
+    MZ_Mat4 result = {{ { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f },
+                        { 0.0f, 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } }};
     return result;
-
 }
 
 /*
 */
-MZ_Matrix MZ_subtract_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2){
+MZ_Mat4 MZ_multiply_two_mat4(MZ_Mat4 matrix1, MZ_Mat4 matrix2){
 
-    MZ_assert(matrix1.rows == matrix2.rows && matrix1.cols == matrix2.cols, MZ_EQUAL_ERROR);
+    MZ_Mat4 result;
 
-    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
+    #if _MZ_V4_VECTORS
+    // each row of the result is a combination of the 4 rows of matrix2
+    _MZ_v4 b0, b1, b2, b3;
+    memcpy(&b0, matrix2.elements[0], sizeof(_MZ_v4));
+    memcpy(&b1, matrix2.elements[1], sizeof(_MZ_v4));
+    memcpy(&b2, matrix2.elements[2], sizeof(_MZ_v4));
+    memcpy(&b3, matrix2.elements[3], sizeof(_MZ_v4));
 
-    for(unsigned int i = 0; i < result.rows; i++){
-        for(unsigned int j = 0; j < result.cols; j++){
-            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(matrix1, i, j) - MZ_VALUE_OF_MAT_AT(matrix2, i, j);
+    for(int i = 0; i < 4; i++){
+        const float* a = matrix1.elements[i];
+        _MZ_v4 row = (b0 * a[0] + b1 * a[1]) + (b2 * a[2] + b3 * a[3]);
+        memcpy(result.elements[i], &row, sizeof(_MZ_v4));
+    }
+    #else
+    for(int i = 0; i < 4; i++){
+        const float* a = matrix1.elements[i];
+        for(int j = 0; j < 4; j++){
+            result.elements[i][j] = (a[0] * matrix2.elements[0][j] + a[1] * matrix2.elements[1][j]) +
+                                    (a[2] * matrix2.elements[2][j] + a[3] * matrix2.elements[3][j]);
         }
     }
+    #endif
 
     return result;
+}
+
+/*
+*/
+MZ_Vec4 MZ_multiply_mat4_by_vec4(MZ_Mat4 matrix, MZ_Vec4 vector){
+
+    const float (*m)[4] = matrix.elements;
 
+    return MZ_new_vec4((m[0][0] * vector.x + m[0][1] * vector.y) + (m[0][2] * vector.z + m[0][3] * vector.w),
+                       (m[1][0] * vector.x + m[1][1] * vector.y) + (m[1][2] * vector.z + m[1][3] * vector.w),
+                       (m[2][0] * vector.x + m[2][1] * vector.y) + (m[2][2] * vector.z + m[2][3] * vector.w),
+                       (m[3][0] * vector.x + m[3][1] * vector.y) + (m[3][2] * vector.z + m[3][3] * vector.w));
 }
 
 /*
 */
-MZ_Matrix MZ_subtract_matrix_with_scalar(MZ_Matrix matrix1, float scalar){
-    
-    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
+MZ_Mat4 MZ_transposed_mat4(MZ_Mat4 source){
 
-    for(unsigned int i = 0; i < result.rows; i++){
-        for(unsigned int j = 0; j < result.cols; j++){
-            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(matrix1, i, j) - scalar;
-        }
-    }
+    const float (*m)[4] = source.elements;
 
+    MZ_Mat4 result = {{ { m[0][0], m[1][0], m[2][0], m[3][0] },
+                        { m[0][1], m[1][1], m[2][1], m[3][1] },
+                        { m[0][2], m[1][2], m[2][2], m[3][2] },
+                        { m[0][3], m[1][3], m[2][3], m[3][3] } }};
     return result;
-
 }
 
 /*
+    The 2x2 determinants of the top two rows (s) and of the bottom two rows (c), shared by
+    the determinant and the inverse of a 4x4 matrix (Laplace expansion by complementary minors).
 */
-MZ_Matrix MZ_multiply_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2){
+typedef struct _MZ_Mat4Minors{
+    float s[6];
+    float c[6];
+}_MZ_Mat4Minors;
 
-    MZ_assert(matrix1.cols == matrix2.rows, MZ_PROD_ERROR);
+static inline _MZ_Mat4Minors _MZ_minors_of_mat4(const float (*m)[4]){
 
-    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix2.cols);
-    
-    for(unsigned int i = 0; i < result.rows; i++){
-		for(unsigned int j = 0; j < result.cols; j++){
-			MZ_VALUE_OF_MAT_AT(result, i, j) = 0;
-			for(unsigned int k = 0; k < matrix2.rows; k++){
-				MZ_VALUE_OF_MAT_AT(result, i, j) += MZ_VALUE_OF_MAT_AT(matrix1, i, k) * MZ_VALUE_OF_MAT_AT(matrix2, k, j); 
-			}
-		}
-	}
+    _MZ_Mat4Minors r;
 
-    return result;
+    r.s[0] = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+    r.s[1] = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+    r.s[2] = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+    r.s[3] = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+    r.s[4] = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+    r.s[5] = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+
+    r.c[5] = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+    r.c[4] = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+    r.c[3] = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+    r.c[2] = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+    r.c[1] = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+    r.c[0] = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+
+    return r;
+}
 
+static inline float _MZ_determinant_from_minors(const _MZ_Mat4Minors* r){
+    return (r->s[0] * r->c[5] - r->s[1] * r->c[4] + r->s[2] * r->c[3]) +
+           (r->s[3] * r->c[2] - r->s[4] * r->c[1] + r->s[5] * r->c[0]);
 }
 
 /*
 */
-MZ_Matrix MZ_multiply_matrix_by_scalar(MZ_Matrix matrix1, float scalar){
-    
-    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
-
-    for(unsigned int i = 0; i < result.rows; i++){
-        for(unsigned int j = 0; j < result.cols; j++){
-            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(matrix1, i, j) * scalar;
-        }
-    }
+float MZ_determinant_of_mat4(MZ_Mat4 source){
 
-    return result;
+    _MZ_Mat4Minors r = _MZ_minors_of_mat4(source.elements);
 
+    return _MZ_determinant_from_minors(&r);
 }
 
 /*
 */
-MZ_Matrix MZ_divide_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2){
+bool MZ_inverse_of_mat4(MZ_Mat4 source, MZ_Mat4* result){
 
-    MZ_assert(matrix1.rows == matrix2.rows && matrix1.cols == matrix2.cols, MZ_EQUAL_ERROR);
+    const float (*m)[4] = source.elements;
 
-    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
+    _MZ_Mat4Minors r = _MZ_minors_of_mat4(m);
+    const float* s = r.s;
+    const float* c = r.c;
 
-    for(unsigned int i = 0; i < result.rows; i++){
-        for(unsigned int j = 0; j < result.cols; j++){
-            if(MZ_VALUE_OF_MAT_AT(matrix2, i, j) != 0.0f){
-                MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(matrix1, i, j) / MZ_VALUE_OF_MAT_AT(matrix2, i, j);
-            }else {
-                MZ_VALUE_OF_MAT_AT(result, i, j) = 0.0f;
-            }
-        }
-    }
+    float det = _MZ_determinant_from_minors(&r);
 
-    return result;
+    if(det == 0.0f) return false;
 
-}
+    float inv = 1.0f / det;
 
-/*
-*/
-MZ_Matrix MZ_divide_matrix_by_scalar(MZ_Matrix matrix1, float scalar){
-    
-    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
+    MZ_Mat4 out = {{
+        { ( m[1][1] * c[5] - m[1][2] * c[4] + m[1][3] * c[3]) * inv,
+          (-m[0][1] * c[5] + m[0][2] * c[4] - m[0][3] * c[3]) * inv,
+          ( m[3][1] * s[5] - m[3][2] * s[4] + m[3][3] * s[3]) * inv,
+          (-m[2][1] * s[5] + m[2][2] * s[4] - m[2][3] * s[3]) * inv },
 
-    for(unsigned int i = 0; i < result.rows; i++){
-        for(unsigned int j = 0; j < result.cols; j++){
-            if(scalar != 0.0f){
-                MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(matrix1, i, j) / scalar;
-            }else {
-                return NULL_MATRIX;
-            }
-        }
-    }
+        { (-m[1][0] * c[5] + m[1][2] * c[2] - m[1][3] * c[1]) * inv,
+          ( m[0][0] * c[5] - m[0][2] * c[2] + m[0][3] * c[1]) * inv,
+          (-m[3][0] * s[5] + m[3][2] * s[2] - m[3][3] * s[1]) * inv,
+          ( m[2][0] * s[5] - m[2][2] * s[2] + m[2][3] * s[1]) * inv },
 
-    return result;
+        { ( m[1][0] * c[4] - m[1][1] * c[2] + m[1][3] * c[0]) * inv,
+          (-m[0][0] * c[4] + m[0][1] * c[2] - m[0][3] * c[0]) * inv,
+          ( m[3][0] * s[4] - m[3][1] * s[2] + m[3][3] * s[0]) * inv,
+          (-m[2][0] * s[4] + m[2][1] * s[2] - m[2][3] * s[0]) * inv },
+
+        { (-m[1][0] * c[3] + m[1][1] * c[1] - m[1][2] * c[0]) * inv,
+          ( m[0][0] * c[3] - m[0][1] * c[1] + m[0][2] * c[0]) * inv,
+          (-m[3][0] * s[3] + m[3][1] * s[1] - m[3][2] * s[0]) * inv,
+          ( m[2][0] * s[3] - m[2][1] * s[1] + m[2][2] * s[0]) * inv },
+    }};
 
+    *result = out;
+
+    return true;
 }
 
 /*
 */
-MZ_Matrix MZ_product_element_wise_two_matrices(MZ_Matrix matrix1, MZ_Matrix matrix2){
+MZ_Vec MZ_Vec3_to_vector(MZ_Vec3 source){
 
-    MZ_assert(matrix1.rows == matrix2.rows && matrix1.cols == matrix2.cols, MZ_EQUAL_ERROR);
+    MZ_Vec result = MZ_alloc_vector(3);
 
-    MZ_Matrix result = MZ_alloc_matrix(matrix1.rows, matrix1.cols);
-    
-    for(unsigned int i = 0; i < result.rows; i++){
-        for(unsigned int j = 0; j < result.cols; j++){
-            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(matrix1, i, j) * MZ_VALUE_OF_MAT_AT(matrix2, i, j);
-        }
-    }
+    memcpy(result.elements, source.elements, sizeof(source.elements));
 
     return result;
-    
 }
 
 /*
 */
-MZ_Matrix MZ_transposed_matrix(MZ_Matrix source){
+MZ_Vec3 MZ_Vector_to_vec3(MZ_Vec source){
 
-    MZ_Matrix result = MZ_alloc_matrix(source.cols, source.rows);
+    MZ_assert(MZ_DIM_OF_VECTOR(source) == 3, MZ_EQUAL_ERROR);
 
-    for(unsigned int i = 0; i < result.rows; i++){
-        for(unsigned int j = 0; j < result.cols; j++){
-            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(source, j, i);
-        }
-    }
+    return MZ_new_vec3(MZ_VALUE_OF_VECTOR_AT(source, 0), MZ_VALUE_OF_VECTOR_AT(source, 1), MZ_VALUE_OF_VECTOR_AT(source, 2));
+}
+
+/*
+*/
+MZ_Vec MZ_Vec4_to_vector(MZ_Vec4 source){
 
+    MZ_Vec result = MZ_alloc_vector(4);
+
+    memcpy(result.elements, source.elements, sizeof(source.elements));
 
     return result;
 }
 
 /*
 */
-bool MZ_swap_two_matrix_rows(MZ_Matrix *source, unsigned int row1, unsigned int row2){
+MZ_Vec4 MZ_Vector_to_vec4(MZ_Vec source){
 
+    MZ_assert(MZ_DIM_OF_VECTOR(source) == 4, MZ_EQUAL_ERROR);
 
-    if(row1 >= source->rows || row2 >= source->rows || row1 == row2){
-        return false;
-    }
-
-    unsigned int indxRow1 = row1 * source->cols;
-    unsigned int indxRow2 = row2 * source->cols;
+    return MZ_new_vec4(MZ_VALUE_OF_VECTOR_AT(source, 0), MZ_VALUE_OF_VECTOR_AT(source, 1),
+                       MZ_VALUE_OF_VECTOR_AT(source, 2), MZ_VALUE_OF_VECTOR_AT(source, 3));
+}
 
-    for(unsigned int i = 0; i < source->cols; i++){
+/*
+*/
+MZ_Matrix MZ_Mat3_to_matrix(MZ_Mat3 source){
 
-        float temp = source->elements[indxRow1 + i];
-        source->elements[indxRow1 + i] = source->elements[indxRow2 + i];
-        source->elements[indxRow2 + i] = temp;
+    MZ_Matrix result = MZ_alloc_matrix(3, 3);
 
+    for(unsigned int i = 0; i < 3; i++){
+        memcpy(&MZ_VALUE_OF_MAT_AT(result, i, 0), source.elements[i], sizeof(source.elements[i]));
     }
 
-    return true;
+    return result;
 }
 
 /*
 */
-bool MZ_add_two_matrix_rows(MZ_Matrix *source, unsigned int row1, unsigned int row2){
+MZ_Mat3 MZ_Matrix_to_mat3(MZ_Matrix source){
 
+    MZ_assert(source.rows == 3 && source.cols == 3, MZ_EQUAL_ERROR);
 
-    if(row1 >= source->rows || row2 >= source->rows || row1 == row2){
-        return false;
-    }
+    MZ_Mat3 result;
 
-    for(unsigned int i = 0; i < source->cols; i++){
-        //source->elements[row1][i] += source->elements[row2][i];
-        MZ_VALUE_OF_MAT_POINTER_AT(source, row1, i) += MZ_VALUE_OF_MAT_POINTER_AT(source, row2, i);
+    for(unsigned int i = 0; i < 3; i++){
+        memcpy(result.elements[i], &MZ_VALUE_OF_MAT_AT(source, i, 0), sizeof(result.elements[i]));
     }
 
-    return true;
+    return result;
 }
 
 /*
 */
-bool MZ_multiply_two_matrix_rows(MZ_Matrix *source, unsigned int row, int scalar){
+MZ_Matrix MZ_Mat4_to_matrix(MZ_Mat4 source){
 
+    MZ_Matrix result = MZ_alloc_matrix(4, 4);
 
-    if(row >= source->rows || scalar == 0.0f){
-        return false;
-    }
-
-    for(unsigned int i = 0; i < source->cols; i++){
-        MZ_VALUE_OF_MAT_POINTER_AT(source, row, i)  *= scalar;
+    for(unsigned int i = 0; i < 4; i++){
+        memcpy(&MZ_VALUE_OF_MAT_AT(result, i, 0), source.elements[i], sizeof(source.elements[i]));
     }
 
-    return true;
+    return result;
 }
 
 /*
 */
-bool MZ_multiply_add_two_matrix_rows(MZ_Matrix *source, unsigned int row1, unsigned int row2, int scalar){
+MZ_Mat4 MZ_Matrix_to_mat4(MZ_Matrix source){
 
+    MZ_assert(source.rows == 4 && source.cols == 4, MZ_EQUAL_ERROR);
 
-    if(row1 >= source->rows || row2 >= source->rows || 
-       scalar == 0.0f || row1 == row2){
-        return false;
-    }
+    MZ_Mat4 result;
 
-    for(unsigned int i = 0; i < source->cols; i++){
-        //source->elements[row1][i] += source->elements[row2][i] * scalar;
-        MZ_VALUE_OF_MAT_POINTER_AT(source, row1, i) += MZ_VALUE_OF_MAT_POINTER_AT(source, row2, i) * scalar;
+    for(unsigned int i = 0; i < 4; i++){
+        memcpy(result.elements[i], &MZ_VALUE_OF_MAT_AT(source, i, 0), sizeof(result.elements[i]));
     }
 
-    return true;
+    return result;
 }
 
 /*
+    Vector batches. The kernels take one block of lanes (vectors) at a time and walk the
+    components, every lane being independent the result does not depend on the threads.
 */
-void MZ_to_echelon_form(MZ_Matrix *source){
+MZ_VecBatch NULL_VEC_BATCH = {0, 0, 0, NULL};
 
-    unsigned int curRow = 0;
+typedef enum _MZ_BatchOp{
+    _MZ_BATCH_DOT,
+    _MZ_BATCH_MAGNITUDE,
+    _MZ_BATCH_NORMALIZE,
+    _MZ_BATCH_CROSS,
+}_MZ_BatchOp;
 
-    for(unsigned int i = 0; i < source->cols; i++){
-        
-        #if VISUALIZE_STEPS
+typedef void (*_MZ_BatchKernel)(float* dest, const float* a, const float* b, size_t ld, size_t dim, size_t n, _MZ_BatchOp op);
 
-        MZ_print_matrix_by_index(stdout, curRow, *source);
-        #endif
+static void _MZ_batch_kernel_scalar(float* dest, const float* a, const float* b, size_t ld, size_t dim, size_t n, _MZ_BatchOp op){
+
+    switch(op){
+        case _MZ_BATCH_DOT:
+        case _MZ_BATCH_MAGNITUDE:
+            for(size_t i = 0; i < n; i++){
+                float sum = 0.0f;
+                for(size_t c = 0; c < dim; c++) sum += a[c * ld + i] * b[c * ld + i];
+                dest[i] = op == _MZ_BATCH_MAGNITUDE ? sqrtf(sum) : sum;
+            }
+            break;
+        case _MZ_BATCH_NORMALIZE:
+            for(size_t i = 0; i < n; i++){
+                float sum = 0.0f;
+                for(size_t c = 0; c < dim; c++) sum += a[c * ld + i] * a[c * ld + i];
+                float inv = 1.0f / sqrtf(sum);
+                for(size_t c = 0; c < dim; c++) dest[c * ld + i] = a[c * ld + i] * inv;
+            }
+            break;
+        case _MZ_BATCH_CROSS:
+            for(size_t i = 0; i < n; i++){
+                float ax = a[i], ay = a[ld + i], az = a[2 * ld + i];
+                float bx = b[i], by = b[ld + i], bz = b[2 * ld + i];
+                dest[i]          = ay * bz - az * by;
+                dest[ld + i]     = az * bx - ax * bz;
+                dest[2 * ld + i] = ax * by - ay * bx;
+            }
+            break;
+    }
+}
 
-        unsigned int row = curRow;
+#if _MZ_X86_DISPATCH
 
-        if(row >= source->rows) break;
+/*
+    Same loops for every instruction set, W lanes at a time, the remaining lanes go through
+    the scalar kernel.
+*/
+#define _MZ_BATCH_LOOPS(P, W)                                                                    \
+    size_t i = 0;                                                                                \
+    switch(op){                                                                                  \
+        case _MZ_BATCH_DOT:                                                                      \
+        case _MZ_BATCH_MAGNITUDE:                                                                \
+            for(; i + W <= n; i += W){                                                           \
+                P##_T acc = P##_ZERO();                                                          \
+                for(size_t c = 0; c < dim; c++){                                                 \
+                    acc = P##_FMADD(P##_LOAD(a + c * ld + i), P##_LOAD(b + c * ld + i), acc);    \
+                }                                                                                \
+                P##_STORE(dest + i, op == _MZ_BATCH_MAGNITUDE ? P##_SQRT(acc) : acc);            \
+            }                                                                                    \
+            break;                                                                               \
+        case _MZ_BATCH_NORMALIZE:                                                                \
+            for(; i + W <= n; i += W){                                                           \
+                P##_T acc = P##_ZERO();                                                          \
+                for(size_t c = 0; c < dim; c++){                                                 \
+                    P##_T x = P##_LOAD(a + c * ld + i);                                          \
+                    acc = P##_FMADD(x, x, acc);                                                  \
+                }                                                                                \
+                P##_T inv = P##_DIV(P##_SET1(1.0f), P##_SQRT(acc));                              \
+                for(size_t c = 0; c < dim; c++){                                                 \
+                    P##_STORE(dest + c * ld + i, P##_MUL(P##_LOAD(a + c * ld + i), inv));        \
+                }                                                                                \
+            }                                                                                    \
+            break;                                                                               \
+        case _MZ_BATCH_CROSS:                                                                    \
+            for(; i + W <= n; i += W){                                                           \
+                P##_T ax = P##_LOAD(a + i), ay = P##_LOAD(a + ld + i), az = P##_LOAD(a + 2 * ld + i); \
+                P##_T bx = P##_LOAD(b + i), by = P##_LOAD(b + ld + i), bz = P##_LOAD(b + 2 * ld + i); \
+                P##_STORE(dest + i,          P##_SUB(P##_MUL(ay, bz), P##_MUL(az, by)));         \
+                P##_STORE(dest + ld + i,     P##_SUB(P##_MUL(az, bx), P##_MUL(ax, bz)));         \
+                P##_STORE(dest + 2 * ld + i, P##_SUB(P##_MUL(ax, by), P##_MUL(ay, bx)));         \
+            }                                                                                    \
+            break;                                                                               \
+    }                                                                                            \
+    if(i < n) _MZ_batch_kernel_scalar(dest + i, a + i, b + i, ld, dim, n - i, op);
+
+#define _MZ_BATCH_SSE2_T __m128
+#define _MZ_BATCH_SSE2_ZERO() _mm_setzero_ps()
+#define _MZ_BATCH_SSE2_SET1(x) _mm_set1_ps(x)
+#define _MZ_BATCH_SSE2_LOAD(p) _mm_loadu_ps(p)
+#define _MZ_BATCH_SSE2_STORE(p, x) _mm_storeu_ps(p, x)
+#define _MZ_BATCH_SSE2_SUB(x, y) _mm_sub_ps(x, y)
+#define _MZ_BATCH_SSE2_MUL(x, y) _mm_mul_ps(x, y)
+#define _MZ_BATCH_SSE2_DIV(x, y) _mm_div_ps(x, y)
+#define _MZ_BATCH_SSE2_SQRT(x) _mm_sqrt_ps(x)
+#define _MZ_BATCH_SSE2_FMADD(x, y, z) _mm_add_ps(_mm_mul_ps(x, y), z)
+
+__attribute__((target("sse2")))
+static void _MZ_batch_kernel_sse2(float* dest, const float* a, const float* b, size_t ld, size_t dim, size_t n, _MZ_BatchOp op){
+    _MZ_BATCH_LOOPS(_MZ_BATCH_SSE2, 4)
+}
 
-        for(; row < source->rows; row++){
-            if(MZ_VALUE_OF_MAT_POINTER_AT(source, row, i) != 0.0f) break;
-        }
+#define _MZ_BATCH_AVX2_T __m256
+#define _MZ_BATCH_AVX2_ZERO() _mm256_setzero_ps()
+#define _MZ_BATCH_AVX2_SET1(x) _mm256_set1_ps(x)
+#define _MZ_BATCH_AVX2_LOAD(p) _mm256_loadu_ps(p)
+#define _MZ_BATCH_AVX2_STORE(p, x) _mm256_storeu_ps(p, x)
+#define _MZ_BATCH_AVX2_SUB(x, y) _mm256_sub_ps(x, y)
+#define _MZ_BATCH_AVX2_MUL(x, y) _mm256_mul_ps(x, y)
+#define _MZ_BATCH_AVX2_DIV(x, y) _mm256_div_ps(x, y)
+#define _MZ_BATCH_AVX2_SQRT(x) _mm256_sqrt_ps(x)
+#define _MZ_BATCH_AVX2_FMADD(x, y, z) _mm256_fmadd_ps(x, y, z)
+
+__attribute__((target("avx2,fma")))
+static void _MZ_batch_kernel_avx2(float* dest, const float* a, const float* b, size_t ld, size_t dim, size_t n, _MZ_BatchOp op){
+    _MZ_BATCH_LOOPS(_MZ_BATCH_AVX2, 8)
+}
 
-        if(row == source->rows) continue;
+#define _MZ_BATCH_AVX512_T __m512
+#define _MZ_BATCH_AVX512_ZERO() _mm512_setzero_ps()
+#define _MZ_BATCH_AVX512_SET1(x) _mm512_set1_ps(x)
+#define _MZ_BATCH_AVX512_LOAD(p) _mm512_loadu_ps(p)
+#define _MZ_BATCH_AVX512_STORE(p, x) _mm512_storeu_ps(p, x)
+#define _MZ_BATCH_AVX512_SUB(x, y) _mm512_sub_ps(x, y)
+#define _MZ_BATCH_AVX512_MUL(x, y) _mm512_mul_ps(x, y)
+#define _MZ_BATCH_AVX512_DIV(x, y) _mm512_div_ps(x, y)
+#define _MZ_BATCH_AVX512_SQRT(x) _mm512_sqrt_ps(x)
+#define _MZ_BATCH_AVX512_FMADD(x, y, z) _mm512_fmadd_ps(x, y, z)
+
+__attribute__((target("avx512f")))
+static void _MZ_batch_kernel_avx512(float* dest, const float* a, const float* b, size_t ld, size_t dim, size_t n, _MZ_BatchOp op){
+    _MZ_BATCH_LOOPS(_MZ_BATCH_AVX512, 16)
+}
 
-        MZ_swap_two_matrix_rows(source, curRow, row);
+static const _MZ_BatchKernel _MZ_batch_kernels[MZ_ISA_COUNT] = {
+    _MZ_batch_kernel_scalar,
+    _MZ_batch_kernel_scalar,
+    _MZ_batch_kernel_sse2,
+    _MZ_batch_kernel_avx2,
+    _MZ_batch_kernel_avx512,
+};
+
+#else
+
+static const _MZ_BatchKernel _MZ_batch_kernels[MZ_ISA_COUNT] = {
+    _MZ_batch_kernel_scalar,
+    _MZ_batch_kernel_scalar,
+    _MZ_batch_kernel_scalar,
+    _MZ_batch_kernel_scalar,
+    _MZ_batch_kernel_scalar,
+};
+
+#endif // _MZ_X86_DISPATCH
+
+typedef struct _MZ_BatchJob{
+    float* dest;
+    const float* a;
+    const float* b;
+    size_t ld;
+    size_t dim;
+    _MZ_BatchOp op;
+}_MZ_BatchJob;
 
-        float factor = 1 / MZ_VALUE_OF_MAT_POINTER_AT(source, curRow, i);
+static void _MZ_batch_range(void* ctx, size_t begin, size_t end){
 
-        for(unsigned int col = i; col < source->cols; col++){
-            MZ_VALUE_OF_MAT_POINTER_AT(source, curRow, col) *= factor;
-        }
+    _MZ_BatchJob* job = (_MZ_BatchJob*)ctx;
 
-        for(row = curRow + 1; row < source->rows; row++){
-            MZ_multiply_add_two_matrix_rows(source, row, curRow, -1 * MZ_VALUE_OF_MAT_POINTER_AT(source, curRow, i));
-        }
+    _MZ_batch_kernels[_MZ_current_isa()](job->dest + begin, job->a + begin, job->b + begin, job->ld, job->dim, end - begin, job->op);
+}
 
-        curRow++;
+static void _MZ_batch(float* dest, MZ_VecBatch a, MZ_VecBatch b, _MZ_BatchOp op){
 
-    }
+    _MZ_BatchJob job = { dest, a.elements, b.elements, a.stride, a.dim, op };
+
+    _MZ_parallel_for(a.count, MZ_PARALLEL_THRESHOLD / (a.dim == 0 ? 1 : a.dim) + 1, _MZ_batch_range, &job);
+}
 
+static inline bool _MZ_are_batches_alike(MZ_VecBatch batch1, MZ_VecBatch batch2){
+    return batch1.count == batch2.count && batch1.dim == batch2.dim && batch1.stride == batch2.stride;
 }
 
 /*
 */
-void MZ_to_reduced_echelon_form(MZ_Matrix *source){
+MZ_VecBatch MZ_alloc_vec_batch(size_t count, size_t dim){
 
-    unsigned int curRow = 0;
+    const size_t line = _MZ_ALIGNMENT / sizeof(float);
 
-    for(unsigned int i = 0; i < source->cols; i++){
-        
-        #if VISUALIZE_STEPS
-        MZ_print_matrix_by_index(stdout, curRow, *source);
-        #endif
+    MZ_VecBatch result;
+    result.count = count;
+    result.dim = dim;
+    result.stride = (count + line - 1) / line * line;
 
-        unsigned int row = curRow;
+    // zeroed, the padding lanes take part in the elementwise operations
+    result.elements = MZ_ALLOC(result.stride * dim, float);
 
-        if(row >= source->rows) break;
+    MZ_assert(result.elements != NULL || result.stride * dim == 0, MZ_ALLOC_ERROR);
 
-        for(; row < source->rows; row++){
-            if(MZ_VALUE_OF_MAT_POINTER_AT(source, row, i) != 0.0f) break;
-        }
+    return result;
+}
 
-        if(row == source->rows) continue;
+/*
+*/
+void MZ_free_vec_batch(MZ_VecBatch* batch){
 
-        MZ_swap_two_matrix_rows(source, curRow, row);
+    MZ_assert(batch != NULL, "Batch must not be NULL.");
 
-        float factor = 1 / MZ_VALUE_OF_MAT_POINTER_AT(source, curRow, i);
+    MZ_FREE(batch->elements, batch->stride * batch->dim, float);
+    *batch = NULL_VEC_BATCH;
+}
 
-        for(unsigned int col = i; col < source->cols; col++){
-            MZ_VALUE_OF_MAT_POINTER_AT(source, curRow, col) *= factor;
-        }
+/*
+*/
+MZ_VecBatch MZ_vectors_to_batch(const MZ_Vec* vectors, size_t count){
 
-        for(row = 0; row < source->rows; row++){
-            if(row == curRow) continue;
-            MZ_multiply_add_two_matrix_rows(source, row, curRow, -1 * MZ_VALUE_OF_MAT_POINTER_AT(source, row, i));
-        }
+    MZ_assert(count > 0, MZ_EQUAL_ERROR);
 
-        curRow++;
+    MZ_VecBatch result = MZ_alloc_vec_batch(count, MZ_DIM_OF_VECTOR(vectors[0]));
 
+    for(size_t i = 0; i < count; i++){
+        MZ_assert(MZ_DIM_OF_VECTOR(vectors[i]) == result.dim, MZ_EQUAL_ERROR);
+        for(size_t c = 0; c < result.dim; c++){
+            MZ_VALUE_OF_BATCH_AT(result, i, c) = MZ_VALUE_OF_VECTOR_AT(vectors[i], c);
+        }
     }
+
+    return result;
 }
 
+/*
+*/
+void MZ_batch_to_vectors(MZ_VecBatch batch, MZ_Vec* vectors){
+
+    for(size_t i = 0; i < batch.count; i++){
+        vectors[i] = MZ_get_vector_from_batch(batch, i);
+    }
+}
 
 /*
 */
-MZ_Matrix MZ_append_vector_to_matrix(MZ_Matrix source, MZ_Vec vector){
+MZ_Vec MZ_get_vector_from_batch(MZ_VecBatch batch, size_t index){
 
-    MZ_assert(source.rows == vector.dim, MZ_EQUAL_ERROR);
-    
-    MZ_Matrix result = MZ_alloc_matrix(source.rows, source.cols + 1);
+    MZ_assert(index < batch.count, MZ_EQUAL_ERROR);
 
-    for(unsigned int i = 0; i < source.rows; i++){
-        unsigned int j = 0;
-        for(; j < source.cols; j++){
-            #if VISUALIZE_DEBUG
-            printf("%d\n", j);
-            #endif
-            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(source, i, j);
-        }
-        MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_VECTOR_AT(vector, i);
-        #if VISUALIZE_DEBUG
-        printf("%f at %d:%d\n", MZ_VALUE_OF_MAT_AT(result, i, j), i, j);
-        #endif
+    MZ_Vec result = MZ_alloc_vector(batch.dim);
+
+    for(size_t c = 0; c < batch.dim; c++){
+        MZ_VALUE_OF_VECTOR_AT(result, c) = MZ_VALUE_OF_BATCH_AT(batch, index, c);
     }
 
     return result;
-
 }
 
 /*
 */
-MZ_Matrix MZ_append_matrix_to_matrix(MZ_Matrix source, MZ_Matrix matrix){
+void MZ_set_vector_in_batch(MZ_VecBatch* batch, size_t index, MZ_Vec vector){
 
-    MZ_assert(source.rows == matrix.rows, MZ_EQUAL_ERROR);
-    
-    MZ_Matrix result = MZ_alloc_matrix(source.rows, source.cols + matrix.cols);
+    MZ_assert(index < batch->count && MZ_DIM_OF_VECTOR(vector) == batch->dim, MZ_EQUAL_ERROR);
 
-    for(unsigned int i = 0; i < source.rows; i++){
-        unsigned int j = 0;
-        for(; j < source.cols; j++){
-            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(source, i, j);
-        }
-        for(unsigned int k = 0; k < matrix.cols; k++){
-            MZ_VALUE_OF_MAT_AT(result, i, k + j) = MZ_VALUE_OF_MAT_AT(matrix, i, k);
-        }
-        
+    for(size_t c = 0; c < batch->dim; c++){
+        MZ_VALUE_OF_BATCH_AT(*batch, index, c) = MZ_VALUE_OF_VECTOR_AT(vector, c);
     }
+}
 
-    return result;
+/*
+*/
+MZ_VecBatch MZ_add_two_vec_batches(MZ_VecBatch batch1, MZ_VecBatch batch2){
 
+    MZ_VecBatch result = MZ_alloc_vec_batch(batch1.count, batch1.dim);
+
+    MZ_add_two_vec_batches_into(&result, batch1, batch2);
+
+    return result;
 }
 
 /*
 */
-MZ_Matrix MZ_get_sub_matrix(MZ_Matrix source, unsigned int remRow, unsigned int remCol){
+void MZ_add_two_vec_batches_into(MZ_VecBatch* dest, MZ_VecBatch batch1, MZ_VecBatch batch2){
 
-    MZ_Matrix result = MZ_alloc_matrix(source.rows - 1, source.cols - 1);
+    MZ_assert(_MZ_are_batches_alike(*dest, batch1) && _MZ_are_batches_alike(batch1, batch2), MZ_EQUAL_ERROR);
 
-    unsigned int rowOffset = 0;
-    for (unsigned int i = 0; i < result.rows; i++){
-        unsigned int colOffset = 0;
+    // same layout on both sides, the components can be added as one flat array
+    _MZ_elementwise(dest->elements, batch1.elements, batch2.elements, 0.0f, batch1.stride * batch1.dim, _MZ_OP_ADD);
+}
 
-        if (i == remRow){
-            rowOffset++;
-        }
+/*
+*/
+MZ_VecBatch MZ_subtract_two_vec_batches(MZ_VecBatch batch1, MZ_VecBatch batch2){
 
-        for (unsigned int j = 0; j < result.cols; j++){
-            if (j == remCol)
-            {
-                colOffset++;
-            }
+    MZ_VecBatch result = MZ_alloc_vec_batch(batch1.count, batch1.dim);
 
-            // assign value
-            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(source, i + rowOffset, j + colOffset);//source.elements[i + rowOffset][j + colOffset];
-        }
-    }
-    return result;
-}
+    MZ_subtract_two_vec_batches_into(&result, batch1, batch2);
 
-float MZ_minor(MZ_Matrix source, unsigned int row, unsigned int col){
-    float result = MZ_determinant_of_matrix(MZ_get_sub_matrix(source, row, col));
     return result;
 }
 
-float MZ_cofactor(MZ_Matrix source, unsigned int row, unsigned int col){
-    float x = (row + col) % 2 == 0 ? MZ_minor(source, row, col) : -MZ_minor(source, row, col);
-    return x;
+/*
+*/
+void MZ_subtract_two_vec_batches_into(MZ_VecBatch* dest, MZ_VecBatch batch1, MZ_VecBatch batch2){
+
+    MZ_assert(_MZ_are_batches_alike(*dest, batch1) && _MZ_are_batches_alike(batch1, batch2), MZ_EQUAL_ERROR);
+
+    _MZ_elementwise(dest->elements, batch1.elements, batch2.elements, 0.0f, batch1.stride * batch1.dim, _MZ_OP_SUB);
 }
 
 /*
 */
-float MZ_determinant_of_matrix(MZ_Matrix source){
-
-    MZ_assert(source.rows == source.cols || source.rows != 0, MZ_EQUAL_ERROR);
+MZ_VecBatch MZ_multiply_vec_batch_by_scalar(MZ_VecBatch batch, float scalar){
 
-    if(source.rows == 2){
-        return  MZ_VALUE_OF_MAT_AT(source, 0 , 0) * MZ_VALUE_OF_MAT_AT(source, 1 , 1) -
-                MZ_VALUE_OF_MAT_AT(source, 0 , 1) * MZ_VALUE_OF_MAT_AT(source, 1 , 0);
-    }
+    MZ_VecBatch result = MZ_alloc_vec_batch(batch.count, batch.dim);
 
-    float det = 0.0f;
+    MZ_multiply_vec_batch_by_scalar_into(&result, batch, scalar);
 
-    for(unsigned int col = 0; col < source.cols; col++){
-        det += MZ_VALUE_OF_MAT_AT(source, 0, col) * MZ_cofactor(source, 0, col);
-    }
-    return det;
+    return result;
 }
 
-
 /*
 */
-MZ_Matrix MZ_cofactor_matrix(MZ_Matrix source){
+void MZ_multiply_vec_batch_by_scalar_into(MZ_VecBatch* dest, MZ_VecBatch batch, float scalar){
 
-    // must be a square matrix with at least 1 row
-    if (source.rows != source.cols || source.rows == 0)
-    {
-        return NULL_MATRIX;
-    }
+    MZ_assert(_MZ_are_batches_alike(*dest, batch), MZ_EQUAL_ERROR);
 
-    MZ_Matrix result = MZ_alloc_matrix(source.rows, source.cols);
+    _MZ_elementwise(dest->elements, batch.elements, NULL, scalar, batch.stride * batch.dim, _MZ_OP_MUL);
+}
 
-    for (unsigned int i = 0; i < result.rows; i++)
-    {
-        for (unsigned int j = 0; j < result.cols; j++)
-        {
-            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_cofactor(source, i, j);
-        }
-    }
+/*
+*/
+MZ_Vec MZ_dot_two_vec_batches(MZ_VecBatch batch1, MZ_VecBatch batch2){
+
+    MZ_Vec result = MZ_alloc_vector(batch1.count);
+
+    MZ_dot_two_vec_batches_into(&result, batch1, batch2);
 
     return result;
 }
 
 /*
 */
-MZ_Matrix MZ_adjugate_matrix(MZ_Matrix source){
+void MZ_dot_two_vec_batches_into(MZ_Vec* dest, MZ_VecBatch batch1, MZ_VecBatch batch2){
 
-    // must be a square matrix with at least 1 row
-    if (source.rows != source.cols || source.rows == 0)
-    {
-        return NULL_MATRIX;
+    MZ_assert(_MZ_are_batches_alike(batch1, batch2) && dest->dim == batch1.count, MZ_EQUAL_ERROR);
+
+    _MZ_batch(dest->elements, batch1, batch2, _MZ_BATCH_DOT);
+}
+
+/*
+*/
+MZ_VecBatch MZ_cross_product_vec_batches(MZ_VecBatch batch1, MZ_VecBatch batch2){
+
+    if(batch1.dim != 3 || batch2.dim != 3){
+        return NULL_VEC_BATCH;
     }
 
-    MZ_Matrix result = MZ_alloc_matrix(source.rows, source.cols);
+    MZ_VecBatch result = MZ_alloc_vec_batch(batch1.count, 3);
 
-    result = MZ_transposed_matrix(MZ_cofactor_matrix(source));
+    MZ_cross_product_vec_batches_into(&result, batch1, batch2);
 
     return result;
 }
 
 /*
 */
-bool MZ_is_matrix_invertible(MZ_Matrix source){
+bool MZ_cross_product_vec_batches_into(MZ_VecBatch* dest, MZ_VecBatch batch1, MZ_VecBatch batch2){
 
-    // must be a square matrix with at least 1 row
-    if (source.rows != source.cols || source.rows == 0)
-    {
+    if(batch1.dim != 3 || batch2.dim != 3 || dest->dim != 3){
         return false;
     }
 
-    return MZ_determinant_of_matrix(source) != 0.0f;
+    MZ_assert(_MZ_are_batches_alike(*dest, batch1) && _MZ_are_batches_alike(batch1, batch2), MZ_EQUAL_ERROR);
+
+    // every lane is loaded before being stored, dest can be one of the operands
+    _MZ_batch(dest->elements, batch1, batch2, _MZ_BATCH_CROSS);
+
+    return true;
 }
 
 /*
 */
-MZ_Matrix MZ_inverse_of_matrix(MZ_Matrix source){
+MZ_Vec MZ_magnitude_of_vec_batch(MZ_VecBatch batch){
 
-    // must be a square matrix with at least 1 row
-    if (source.rows != source.cols || source.rows == 0)
-    {
-        return NULL_MATRIX;
-    }
+    MZ_Vec result = MZ_alloc_vector(batch.count);
 
-    // get the adjugate
-    MZ_Matrix adj = MZ_adjugate_matrix(source);
+    MZ_magnitude_of_vec_batch_into(&result, batch);
 
-    // calculate the determinant using the adjugate
-    float det = 0.0f;
+    return result;
+}
 
-    det = MZ_determinant_of_matrix(source);
+/*
+*/
+void MZ_magnitude_of_vec_batch_into(MZ_Vec* dest, MZ_VecBatch batch){
 
-    if (det == 0.0f)
-    {
-        return NULL_MATRIX;
-    }
+    MZ_assert(dest->dim == batch.count, MZ_EQUAL_ERROR);
 
-    // inverse = 1 / det * adj
-    MZ_Matrix result = MZ_alloc_matrix(adj.rows, adj.cols);
-    result = MZ_multiply_matrix_by_scalar(adj, 1.0f / det);
+    _MZ_batch(dest->elements, batch, batch, _MZ_BATCH_MAGNITUDE);
+}
+
+/*
+*/
+MZ_VecBatch MZ_normalized_vec_batch(MZ_VecBatch batch){
 
-    MZ_free_matrix(&adj);
+    MZ_VecBatch result = MZ_alloc_vec_batch(batch.count, batch.dim);
+
+    MZ_normalized_vec_batch_into(&result, batch);
 
     return result;
 }
 
 /*
 */
-MZ_Matrix MZ_inverse_of_matrix_by_rref(MZ_Matrix source){
+void MZ_normalized_vec_batch_into(MZ_VecBatch* dest, MZ_VecBatch batch){
 
-    if (!MZ_is_matrix_invertible(source))
-    {
-        return NULL_MATRIX;
-    }
+    MZ_assert(_MZ_are_batches_alike(*dest, batch), MZ_EQUAL_ERROR);
 
-    // augment the identity matrix
-    MZ_Matrix idMat = MZ_new_identity_matrix(source.rows);
-    MZ_Matrix opMat = MZ_append_matrix_to_matrix(source, idMat);
+    _MZ_batch(dest->elements, batch, batch, _MZ_BATCH_NORMALIZE);
+}
 
-    // row reduce the augmented matrix
-    MZ_to_reduced_echelon_form(&opMat);
+/*
+    Point transforms. The transform is kept as its 4 columns, a point is then
+    x * col0 + y * col1 + z * col2 + col3 computed in one register, w being the last lane.
+*/
+typedef void (*_MZ_TransformKernel)(float* dest, const float* points, const float* columns, bool projective, size_t n);
 
-    // take the right half of the matrix -> that is the inverse
-    MZ_Matrix result = MZ_alloc_matrix(source.rows, source.cols);
+static void _MZ_transform_kernel_scalar(float* dest, const float* points, const float* columns, bool projective, size_t n){
 
-    for (unsigned int i = 0; i < result.rows; i++)
-    {
-        for (unsigned int j = 0; j < result.cols; j++)
-        {
-            MZ_VALUE_OF_MAT_AT(result, i, j) = MZ_VALUE_OF_MAT_AT(opMat, i, source.cols + j);
+    const float* c = columns;
+
+    for(size_t i = 0; i < n; i++){
+        float x = points[3 * i], y = points[3 * i + 1], z = points[3 * i + 2];
+
+        float rx = c[0] * x + c[4] * y + c[8]  * z + c[12];
+        float ry = c[1] * x + c[5] * y + c[9]  * z + c[13];
+        float rz = c[2] * x + c[6] * y + c[10] * z + c[14];
+
+        if(projective){
+            float inv = 1.0f / (c[3] * x + c[7] * y + c[11] * z + c[15]);
+            rx *= inv; ry *= inv; rz *= inv;
         }
+
+        dest[3 * i] = rx;
+        dest[3 * i + 1] = ry;
+        dest[3 * i + 2] = rz;
     }
+}
 
-    MZ_free_matrix(&idMat);
-    MZ_free_matrix(&opMat);
+#if _MZ_X86_DISPATCH
 
-    return result;
+/*
+    A point is memory bound whatever the width, so every instruction set works on 4 lanes.
+    The whole point is read before its 3 results are stored, dest may be the source.
+*/
+#define _MZ_TRANSFORM_LOOP(MADD)                                                                 \
+    __m128 c0 = _mm_loadu_ps(columns);                                                           \
+    __m128 c1 = _mm_loadu_ps(columns + 4);                                                       \
+    __m128 c2 = _mm_loadu_ps(columns + 8);                                                       \
+    __m128 c3 = _mm_loadu_ps(columns + 12);                                                      \
+    for(size_t i = 0; i < n; i++){                                                               \
+        const float* p = points + 3 * i;                                                         \
+        __m128 r = MADD(c2, _mm_set1_ps(p[2]), MADD(c1, _mm_set1_ps(p[1]),                       \
+                   MADD(c0, _mm_set1_ps(p[0]), c3)));                                            \
+        if(projective) r = _mm_div_ps(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3)));         \
+        _mm_storel_pi((__m64*)(dest + 3 * i), r);                                                \
+        _mm_store_ss(dest + 3 * i + 2, _mm_movehl_ps(r, r));                                     \
+    }
+
+#define _MZ_SSE2_MADD(x, y, z) _mm_add_ps(_mm_mul_ps(x, y), z)
+
+__attribute__((target("sse2")))
+static void _MZ_transform_kernel_sse2(float* dest, const float* points, const float* columns, bool projective, size_t n){
+    _MZ_TRANSFORM_LOOP(_MZ_SSE2_MADD)
 }
 
-bool MZ_are_two_matrices_equal(MZ_Matrix matrix1, MZ_Matrix matrix2){
+__attribute__((target("avx2,fma")))
+static void _MZ_transform_kernel_fma(float* dest, const float* points, const float* columns, bool projective, size_t n){
+    _MZ_TRANSFORM_LOOP(_mm_fmadd_ps)
+}
 
-    if(matrix1.rows != matrix2.rows || matrix1.cols != matrix2.cols) return false;
+static const _MZ_TransformKernel _MZ_transform_kernels[MZ_ISA_COUNT] = {
+    _MZ_transform_kernel_scalar,
+    _MZ_transform_kernel_scalar,
+    _MZ_transform_kernel_sse2,
+    _MZ_transform_kernel_fma,
+    _MZ_transform_kernel_fma,
+};
 
-    for(unsigned int i = 0; i < matrix1.rows; i++){
-        for(unsigned int j = 0; j < matrix1.cols; j++){
-            if((double)MZ_VALUE_OF_MAT_AT(matrix1, i, j) != (double)MZ_VALUE_OF_MAT_AT(matrix2, i, j)) return false;
-        }
-    }
+#else
 
-    return true;
-}
+static const _MZ_TransformKernel _MZ_transform_kernels[MZ_ISA_COUNT] = {
+    _MZ_transform_kernel_scalar,
+    _MZ_transform_kernel_scalar,
+    _MZ_transform_kernel_scalar,
+    _MZ_transform_kernel_scalar,
+    _MZ_transform_kernel_scalar,
+};
 
-bool MZ_are_two_matrices_orthogonal(MZ_Matrix matrix1, MZ_Matrix matrix2){
+#endif // _MZ_X86_DISPATCH
 
-    if(matrix1.rows != matrix2.rows || matrix1.cols != matrix2.cols) return false;
+typedef struct _MZ_TransformJob{
+    float* dest;
+    const float* points;
+    float columns[16];
+    bool projective;
+}_MZ_TransformJob;
 
-    return MZ_are_two_matrices_equal(MZ_multiply_two_matrices(matrix1, matrix2), MZ_new_identity_matrix(matrix1.rows));
+static void _MZ_transform_range(void* ctx, size_t begin, size_t end){
 
+    _MZ_TransformJob* job = (_MZ_TransformJob*)ctx;
+
+    _MZ_transform_kernels[_MZ_current_isa()](job->dest + 3 * begin, job->points + 3 * begin, job->columns, job->projective, end - begin);
 }
 
-bool MZ_is_matrix_orthonormal(MZ_Matrix source){
+/*
+*/
+void MZ_transform_points(MZ_Matrix transform, float* points, size_t count){
+    MZ_transform_points_into(points, transform, points, count);
+}
 
-    if(source.rows == source.cols){
-        return MZ_are_two_matrices_equal(MZ_inverse_of_matrix(source), MZ_transposed_matrix(source));
-    }
+/*
+*/
+void MZ_transform_points_into(float* dest, MZ_Matrix transform, const float* points, size_t count){
 
-    for(unsigned int i = 1; i <= source.cols; i++){
-        MZ_Vec col =  MZ_get_vector_from_matrix_col(source, i);
-        if(!MZ_is_vector_normalized(col)) return false;
-        for(unsigned int j = 1; j <= source.cols; j++){
-            if(i != j){
-                MZ_Vec col_2 = MZ_get_vector_from_matrix_col(source, j);
-                if(!MZ_are_two_vectors_orthogonal(col, col_2)){
-                    return false;
-                }
-            }
+    MZ_assert((transform.rows == 3 || transform.rows == 4) && transform.cols == 4, MZ_EQUAL_ERROR);
+
+    _MZ_TransformJob job;
+    job.dest = dest;
+    job.points = points;
+
+    // a 3x4 transform is the 4x4 one with (0, 0, 0, 1) as its last row
+    for(unsigned int j = 0; j < 4; j++){
+        for(unsigned int i = 0; i < 3; i++){
+            job.columns[4 * j + i] = MZ_VALUE_OF_MAT_AT(transform, i, j);
         }
+        job.columns[4 * j + 3] = transform.rows == 4 ? MZ_VALUE_OF_MAT_AT(transform, 3, j) : (j == 3 ? 1.0f : 0.0f);
     }
 
-    return false;
+    job.projective = job.columns[3] != 0.0f || job.columns[7] != 0.0f || job.columns[11] != 0.0f || job.columns[15] != 1.0f;
 
+    _MZ_parallel_for(count, MZ_PARALLEL_THRESHOLD / 3 + 1, _MZ_transform_range, &job);
 }
 
 #endif // ZMATH_IMPLEMENTATION
\ No newline at end of file